@@ -21,6 +21,12 @@
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "omen_acpi_sig.h"
 
 // ACPI Method Patterns for HP OMEN/Victus
 static const char* hp_acpi_methods[] = {
@@ -33,13 +39,25 @@ static const char* hp_acpi_methods[] = {
     NULL
 };
 
+#define ACPI_CALL_PATH      "/proc/acpi/call"
+#define ACPI_COMMAND_SIZE   (512 + OMEN_ACPI_SIG_MAX_BUFFER * 2)
+#define ACPI_RESPONSE_SIZE  4096    // acpi_call's result buffer
+#define PROBE_TIMEOUT_MS    2000    // Default per-probe deadline
+#define PROBE_KILL_GRACE_MS 200     // A killed worker not gone by then is stuck in the kernel
+#define PROBE_RESPONSE_SIZE 256     // Kept per probe for the report
+
 // Global state
 static int verbose_mode = 0;
+static char board_name[64];     // DMI board name, keys omen_acpi_sig.h
+static int acpi_fd = -1;        // /proc/acpi/call, open for the whole run
+static int acpi_reopen = 0;     // Open the file per call instead (old behaviour, for comparison)
 
 // Function Prototypes
 static int check_acpi_call_support(void);
-static int test_acpi_method(const char* method);
+static int prepare_probe(const char* method, char* command, size_t size);
+static int run_probes(const char** methods, int count, int jobs, int timeout_ms);
 static int call_acpi_method(const char* method, const char* args);
+static int run_batch(const char* path, int repeat, int quiet);
 static void print_usage(const char* progname);
 static void safety_info(void);
 
@@ -66,74 +84,719 @@ static int check_acpi_call_support(void) {
     return 0;
 }
 
+/*
+ * acpi_call evaluates the method inside write() and keeps the result until
+ * it is read, so a call on the open descriptor is one write() and one
+ * pread() at offset 0 - no open, close or stdio per call.
+ *
+ * command ends with a newline; response is NUL terminated. Returns the
+ * response length or -errno.
+ */
+static int acpi_call_open(void) {
+    if (acpi_fd < 0 && !acpi_reopen) {
+        acpi_fd = open(ACPI_CALL_PATH, O_RDWR | O_CLOEXEC);
+        if (acpi_fd < 0) {
+            return -errno;
+        }
+    }
+    return 0;
+}
+
+static ssize_t acpi_call_exec(const char* command, size_t len, char* response, size_t size) {
+    int fd = acpi_fd;
+    ssize_t n;
+    
+    if (acpi_reopen) {
+        fd = open(ACPI_CALL_PATH, O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -errno;
+        }
+    }
+    n = write(fd, command, len);
+    if (acpi_reopen) {
+        close(fd);
+    }
+    if (n != (ssize_t)len) {
+        return n < 0 ? -errno : -EIO;
+    }
+    
+    if (acpi_reopen) {
+        fd = open(ACPI_CALL_PATH, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -errno;
+        }
+    }
+    n = pread(fd, response, size - 1, 0);
+    if (acpi_reopen) {
+        close(fd);
+    }
+    if (n < 0) {
+        return -errno;
+    }
+    
+    // acpi_call includes the terminating NUL in what it returns
+    while (n > 0 && (response[n - 1] == '\0' || response[n - 1] == '\n')) {
+        n--;
+    }
+    response[n] = 0;
+    return n;
+}
+
 /*
  * Call an ACPI method with arguments
  */
 static int call_acpi_method(const char* method, const char* args) {
-    FILE *fp;
-    char command[512];
-    char response[256];
+    char command[ACPI_COMMAND_SIZE];
+    char response[ACPI_RESPONSE_SIZE];
+    int len;
+    ssize_t ret;
     
     // Construct ACPI call command
     if (args && strlen(args) > 0) {
-        snprintf(command, sizeof(command), "%s %s", method, args);
+        len = snprintf(command, sizeof(command), "%s %s\n", method, args);
     } else {
-        snprintf(command, sizeof(command), "%s", method);
+        len = snprintf(command, sizeof(command), "%s\n", method);
+    }
+    if (len < 0 || (size_t)len >= sizeof(command)) {
+        printf("[ERROR] ACPI command too long\n");
+        return -1;
     }
     
     if (verbose_mode) {
-        printf("[DEBUG] ACPI call: %s\n", command);
+        printf("[DEBUG] ACPI call: %.*s\n", len - 1, command);
     }
     
-    // Write command to /proc/acpi/call
-    fp = fopen("/proc/acpi/call", "w");
-    if (!fp) {
-        printf("[ERROR] Cannot open /proc/acpi/call for writing\n");
+    if (acpi_call_open() != 0) {
+        printf("[ERROR] Cannot open %s: %s\n", ACPI_CALL_PATH, strerror(errno));
         return -1;
     }
     
-    if (fprintf(fp, "%s\n", command) < 0) {
-        printf("[ERROR] Failed to write ACPI command\n");
-        fclose(fp);
+    ret = acpi_call_exec(command, (size_t)len, response, sizeof(response));
+    if (ret < 0) {
+        printf("[ERROR] ACPI call failed: %s\n", strerror((int)-ret));
         return -1;
     }
-    fclose(fp);
-    
-    // Read response
-    fp = fopen("/proc/acpi/call", "r");
-    if (!fp) {
-        printf("[ERROR] Cannot open /proc/acpi/call for reading\n");
+    if (ret == 0) {
+        printf("[WARNING] No ACPI response\n");
         return -1;
     }
+    printf("[INFO] ACPI response: %s\n", response);
+    return 0;
+}
+
+/*
+ * Read the DMI board name the signature table is keyed by
+ */
+static void read_board_name(FILE *log) {
+    FILE *fp = fopen("/sys/class/dmi/id/board_name", "r");
     
-    if (fgets(response, sizeof(response), fp)) {
-        response[strcspn(response, "\n")] = 0;
-        printf("[INFO] ACPI response: %s\n", response);
+    if (fp) {
+        if (fgets(board_name, sizeof(board_name), fp)) {
+            board_name[strcspn(board_name, "\n")] = 0;
+        }
         fclose(fp);
-        return 0;
+    }
+    fprintf(log, "[INFO] Board: %s%s\n", board_name[0] ? board_name : "(unknown)",
+           omen_acpi_sig_board_known(board_name) ? " (in signature table)" : "");
+}
+
+/*
+ * acpi_call arguments matching a signature: zero integers, and a zeroed
+ * buffer as large as the method indexes
+ */
+static void format_sig_args(const struct omen_acpi_sig *sig, char *args, size_t size) {
+    size_t len = 0;
+    
+    args[0] = 0;
+    for (int i = 0; i < sig->args && len + 4 < size; i++) {
+        if (i == sig->buffer_arg && sig->buffer_size > 0) {
+            len += snprintf(args + len, size - len, "%sb", i ? " " : "");
+            for (int b = 0; b < sig->buffer_size && len + 3 < size; b++) {
+                args[len++] = '0';
+                args[len++] = '0';
+            }
+            args[len] = 0;
+        } else {
+            len += snprintf(args + len, size - len, "%s0", i ? " " : "");
+        }
+    }
+}
+
+/*
+ * Build the acpi_call command that tests a method for existence
+ *
+ * Boards in omen_acpi_sig.h are checked against their signature first:
+ * methods the firmware lacks are not called, and the rest get the right
+ * argument count instead of a call that is certain to fail. Without a
+ * signature the method is called without arguments. Returns the command
+ * length, or -1 if the method should not be called.
+ */
+static int prepare_probe(const char* method, char* command, size_t size) {
+    const struct omen_acpi_sig *sig = omen_acpi_sig_find(board_name, method);
+    char args[16 + OMEN_ACPI_SIG_MAX_BUFFER * 2];
+    int len;
+    
+    if (!sig && omen_acpi_sig_board_known(board_name)) {
+        printf("[INFO] Method %s is not in board %s firmware, not called\n", method, board_name);
+        return -1;
+    }
+    if (sig) {
+        format_sig_args(sig, args, sizeof(args));
+        printf("[INFO] %s signature: %u args", method, sig->args);
+        if (sig->buffer_arg != OMEN_ACPI_SIG_NO_BUFFER) {
+            printf(", Arg%u buffer >= %u bytes", sig->buffer_arg, sig->buffer_size);
+        }
+        printf("\n");
+        len = snprintf(command, size, "%s %s\n", method, args);
     } else {
-        printf("[WARNING] No ACPI response\n");
+        len = snprintf(command, size, "%s\n", method);
+    }
+    
+    if (len < 0 || (size_t)len >= size) {
+        printf("[ERROR] ACPI command for %s too long\n", method);
+        return -1;
+    }
+    if (verbose_mode) {
+        printf("[DEBUG] ACPI call: %.*s\n", len - 1, command);
+    }
+    return len;
+}
+
+/*
+ * Batch mode - one "<method> [args]" per line from a file or stdin,
+ * blank lines and # comments skipped. Commands are read up front so the
+ * timing covers only the calls. Results go to stdout, one line per call:
+ *
+ *   <seq> TAB <ok|error|skip|fail> TAB <latency us> TAB <response>
+ *
+ * error is an AML error reported by acpi_call, skip a method the board's
+ * signature table says the firmware lacks (not called), fail a syscall
+ * error. The summary with calls per second goes to stderr.
+ */
+struct batch_command {
+    char *text;                 // Newline terminated
+    size_t len;
+    int skip;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int batch_load(FILE *fp, struct batch_command **out, int *count) {
+    struct batch_command *cmds = NULL;
+    int used = 0, capacity = 0;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t n;
+    
+    while ((n = getline(&line, &line_size, fp)) >= 0) {
+        char *start = line;
+        char method[256];
+        
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' ')) {
+            line[--n] = 0;
+        }
+        while (*start == ' ' || *start == '\t') {
+            start++;
+        }
+        if (*start == 0 || *start == '#') {
+            continue;
+        }
+        if (strlen(start) + 2 > ACPI_COMMAND_SIZE) {
+            fprintf(stderr, "[ERROR] Command %d too long\n", used + 1);
+            free(line);
+            return -1;
+        }
+        if (used == capacity) {
+            struct batch_command *grown;
+            
+            capacity = capacity ? capacity * 2 : 64;
+            grown = realloc(cmds, sizeof(*cmds) * (size_t)capacity);
+            if (!grown) {
+                free(line);
+                return -1;
+            }
+            cmds = grown;
+        }
+        
+        struct batch_command *cmd = &cmds[used];
+        
+        cmd->len = strlen(start) + 1;
+        cmd->text = malloc(cmd->len + 1);
+        if (!cmd->text) {
+            free(line);
+            return -1;
+        }
+        memcpy(cmd->text, start, cmd->len - 1);
+        cmd->text[cmd->len - 1] = '\n';
+        cmd->text[cmd->len] = 0;
+        
+        snprintf(method, sizeof(method), "%.*s", (int)strcspn(start, " \t"), start);
+        cmd->skip = omen_acpi_sig_board_known(board_name) &&
+                    !omen_acpi_sig_find(board_name, method);
+        used++;
+    }
+    
+    free(line);
+    *out = cmds;
+    *count = used;
+    return 0;
+}
+
+static int run_batch(const char* path, int repeat, int quiet) {
+    static char out_buf[1 << 16];
+    struct batch_command *cmds = NULL;
+    char response[ACPI_RESPONSE_SIZE];
+    uint64_t ok = 0, errors = 0, skipped = 0, failed = 0, calls = 0, seq = 0;
+    uint64_t start, total_ns, call_total_ns = 0, max_ns = 0;
+    int count = 0;
+    FILE *fp = stdin;
+    
+    if (strcmp(path, "-") != 0) {
+        fp = fopen(path, "r");
+        if (!fp) {
+            fprintf(stderr, "[ERROR] Cannot open %s: %s\n", path, strerror(errno));
+            return 1;
+        }
+    }
+    int ret = batch_load(fp, &cmds, &count);
+    
+    if (fp != stdin) {
         fclose(fp);
+    }
+    if (ret != 0) {
+        return 1;
+    }
+    if (count == 0) {
+        fprintf(stderr, "[ERROR] No commands in %s\n", path);
+        return 1;
+    }
+    
+    if (acpi_call_open() != 0) {
+        fprintf(stderr, "[ERROR] Cannot open %s: %s\n", ACPI_CALL_PATH, strerror(errno));
+        fprintf(stderr, "[INFO] Please run: sudo modprobe acpi_call\n");
+        return 1;
+    }
+    
+    setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+    start = now_ns();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < count; i++) {
+            const char *status = "skip";
+            const char *text = "";
+            uint64_t call_ns = 0;
+            
+            seq++;
+            if (!cmds[i].skip) {
+                uint64_t t0 = now_ns();
+                ssize_t n = acpi_call_exec(cmds[i].text, cmds[i].len, response, sizeof(response));
+                
+                call_ns = now_ns() - t0;
+                call_total_ns += call_ns;
+                if (call_ns > max_ns) {
+                    max_ns = call_ns;
+                }
+                calls++;
+                if (n < 0) {
+                    status = "fail";
+                    text = strerror((int)-n);
+                    failed++;
+                } else if (strncmp(response, "Error", 5) == 0) {
+                    status = "error";
+                    text = response;
+                    errors++;
+                } else {
+                    status = "ok";
+                    text = response;
+                    ok++;
+                }
+            } else {
+                skipped++;
+            }
+            if (!quiet) {
+                printf("%llu\t%s\t%.1f\t%s\n", (unsigned long long)seq, status,
+                       call_ns / 1000.0, text);
+            }
+        }
+    }
+    total_ns = now_ns() - start;
+    fflush(stdout);
+    
+    fprintf(stderr, "[INFO] %llu calls in %.3f ms: %llu ok, %llu error, %llu failed, %llu skipped\n",
+            (unsigned long long)calls, total_ns / 1e6, (unsigned long long)ok,
+            (unsigned long long)errors, (unsigned long long)failed, (unsigned long long)skipped);
+    if (calls > 0) {
+        fprintf(stderr, "[INFO] %.0f calls/s, %.1f us mean, %.1f us max (%s)\n",
+                calls * 1e9 / total_ns, call_total_ns / 1000.0 / calls, max_ns / 1000.0,
+                acpi_reopen ? "open per call" : "persistent descriptor");
+    }
+    
+    for (int i = 0; i < count; i++) {
+        free(cmds[i].text);
+    }
+    free(cmds);
+    return failed > 0 ? 1 : 0;
+}
+
+/*
+ * Candidate paths for discovery, one per line; blank lines and # comments
+ * skipped. Returns the count or -1.
+ */
+static int load_methods(const char* path, char*** out) {
+    FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    char **methods = NULL;
+    int used = 0, capacity = 0;
+    char line[256];
+    
+    if (!fp) {
+        printf("[ERROR] Cannot open %s: %s\n", path, strerror(errno));
         return -1;
     }
+    while (fgets(line, sizeof(line), fp)) {
+        char *start = line + strspn(line, " \t");
+        
+        start[strcspn(start, " \t\r\n#")] = 0;
+        if (*start == 0) {
+            continue;
+        }
+        if (used == capacity) {
+            char **grown;
+            
+            capacity = capacity ? capacity * 2 : 64;
+            grown = realloc(methods, sizeof(*methods) * (size_t)capacity);
+            if (!grown) {
+                break;
+            }
+            methods = grown;
+        }
+        methods[used] = strdup(start);
+        if (!methods[used]) {
+            break;
+        }
+        used++;
+    }
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    
+    *out = methods;
+    return used;
 }
 
 /*
- * Test an ACPI method for existence
+ * Probing - every method runs in a forked worker with a deadline
+ *
+ * A method that hangs in AML would block a plain call forever. Here the
+ * parent waits for at most timeout_ms per probe, then kills the worker.
+ * A worker inside the firmware call may not die (the kernel only returns
+ * from the write() when the method does); it is abandoned after a short
+ * grace period and the run goes on.
+ *
+ * acpi_call keeps a single unlocked result buffer, so a response is only
+ * known to belong to its probe if no other call was in flight meanwhile.
+ * jobs defaults to 1 for that reason; with more jobs, or after a worker
+ * was abandoned, overlapping probes are flagged and their responses
+ * should be confirmed with a single call.
  */
-static int test_acpi_method(const char* method) {
-    printf("[INFO] Testing ACPI method: %s\n", method);
+enum probe_state {
+    PROBE_PENDING = 0,
+    PROBE_SKIPPED,              // Not in the board's firmware, not called
+    PROBE_RUNNING,
+    PROBE_KILLED,               // Deadline passed, SIGKILL sent
+    PROBE_DONE,
+    PROBE_TIMEOUT,              // Killed and reaped
+    PROBE_STUCK,                // Killed but still in the kernel, abandoned
+};
+
+// Sent by a worker in one write(), below PIPE_BUF so it arrives whole
+struct probe_message {
+    int32_t result;             // Response length or -errno
+    uint64_t call_ns;
+    char response[PROBE_RESPONSE_SIZE];
+};
+
+struct probe {
+    const char *method;
+    int state;
+    pid_t pid;
+    int pipe_fd;
+    uint64_t start_ns;
+    uint64_t end_ns;            // Completion, deadline or abandonment
+    int overlapped;             // Another call was in flight meanwhile
+    struct probe_message msg;
+};
+
+static int probe_in_flight(const struct probe *p) {
+    return p->state == PROBE_RUNNING || p->state == PROBE_KILLED || p->state == PROBE_STUCK;
+}
+
+static void probe_worker(const char* command, size_t len, int fd) {
+    struct probe_message msg;
+    char response[ACPI_RESPONSE_SIZE];
+    uint64_t start;
+    ssize_t n;
     
-    // Try to call the method without arguments first
-    int result = call_acpi_method(method, NULL);
+    memset(&msg, 0, sizeof(msg));
+    start = now_ns();
+    n = acpi_call_open() == 0 ? acpi_call_exec(command, len, response, sizeof(response)) : -errno;
+    msg.call_ns = now_ns() - start;
+    msg.result = (int32_t)n;
+    if (n >= 0) {
+        // Truncated to what the report shows
+        memcpy(msg.response, response, n < (ssize_t)sizeof(msg.response) ? (size_t)n : sizeof(msg.response) - 1);
+        for (char *c = msg.response; *c; c++) {
+            if (*c == '\n' || *c == '\t') {
+                *c = ' ';
+            }
+        }
+    }
+    if (write(fd, &msg, sizeof(msg)) != (ssize_t)sizeof(msg)) {
+        _exit(1);
+    }
+    _exit(0);
+}
+
+static int probe_start(struct probe *probes, int count, struct probe *p, uint64_t now) {
+    char command[ACPI_COMMAND_SIZE];
+    int len = prepare_probe(p->method, command, sizeof(command));
+    int fds[2];
     
-    if (result == 0) {
-        printf("[SUCCESS] Method %s exists and responded\n", method);
+    if (len < 0) {
+        p->state = PROBE_SKIPPED;
         return 0;
-    } else {
-        printf("[INFO] Method %s not available or failed\n", method);
+    }
+    if (pipe(fds) != 0) {
+        return -errno;
+    }
+    
+    fflush(stdout);
+    p->pid = fork();
+    if (p->pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -errno;
+    }
+    if (p->pid == 0) {
+        // Other workers' pipes must not stay open in this one
+        for (int i = 0; i < count; i++) {
+            if (probes[i].state == PROBE_RUNNING || probes[i].state == PROBE_KILLED) {
+                close(probes[i].pipe_fd);
+            }
+        }
+        close(fds[0]);
+        probe_worker(command, (size_t)len, fds[1]);
+    }
+    close(fds[1]);
+    
+    p->pipe_fd = fds[0];
+    p->start_ns = now;
+    p->state = PROBE_RUNNING;
+    for (int i = 0; i < count; i++) {
+        if (&probes[i] != p && probe_in_flight(&probes[i])) {
+            probes[i].overlapped = 1;
+            p->overlapped = 1;
+        }
+    }
+    return 0;
+}
+
+static void probe_finish(struct probe *p, uint64_t now) {
+    ssize_t n = read(p->pipe_fd, &p->msg, sizeof(p->msg));
+    
+    if (n != (ssize_t)sizeof(p->msg)) {
+        // Worker died without reporting
+        p->msg.result = -EPIPE;
+        p->msg.call_ns = now - p->start_ns;
+    }
+    p->msg.response[sizeof(p->msg.response) - 1] = 0;
+    close(p->pipe_fd);
+    waitpid(p->pid, NULL, 0);
+    p->state = PROBE_DONE;
+    p->end_ns = now;
+}
+
+static void probe_report(const struct probe *probes, int count, int *found) {
+    printf("\n=== RESULTS ===\n");
+    printf("  %-36s %-8s %10s  %s\n", "Method", "Status", "Latency", "Response");
+    
+    *found = 0;
+    for (int i = 0; i < count; i++) {
+        const struct probe *p = &probes[i];
+        const char *status = "";
+        const char *text = "";
+        char latency[32] = "-";
+        
+        switch (p->state) {
+        case PROBE_SKIPPED:
+            status = "skipped";
+            text = "not in board firmware";
+            break;
+        case PROBE_TIMEOUT:
+            status = "timeout";
+            text = "worker killed";
+            break;
+        case PROBE_STUCK:
+            status = "stuck";
+            text = "worker abandoned in the kernel";
+            break;
+        case PROBE_DONE:
+            if (p->msg.result < 0) {
+                status = "failed";
+                text = strerror(-p->msg.result);
+            } else if (p->msg.result == 0) {
+                status = "failed";
+                text = "no response";
+            } else if (strncmp(p->msg.response, "Error", 5) == 0) {
+                status = "error";
+                text = p->msg.response;
+            } else {
+                status = "ok";
+                text = p->msg.response;
+                (*found)++;
+            }
+            break;
+        default:
+            status = "not run";
+            break;
+        }
+        if (p->state == PROBE_DONE) {
+            snprintf(latency, sizeof(latency), "%.3f ms", p->msg.call_ns / 1e6);
+        } else if (p->state == PROBE_TIMEOUT || p->state == PROBE_STUCK) {
+            snprintf(latency, sizeof(latency), "> %.0f ms", (p->end_ns - p->start_ns) / 1e6);
+        }
+        printf("  %-36s %-7s%s %10s  %s\n", p->method, status,
+               p->overlapped && p->state == PROBE_DONE ? "*" : " ", latency, text);
+    }
+}
+
+static int run_probes(const char** methods, int count, int jobs, int timeout_ms) {
+    const uint64_t timeout_ns = (uint64_t)timeout_ms * 1000000ull;
+    const uint64_t grace_ns = PROBE_KILL_GRACE_MS * 1000000ull;
+    struct probe *probes = calloc((size_t)count, sizeof(*probes));
+    struct pollfd *pfds = calloc((size_t)count, sizeof(*pfds));
+    int *pfd_probe = calloc((size_t)count, sizeof(*pfd_probe));
+    int next = 0, active = 0, stuck = 0, overlapped = 0, found;
+    uint64_t start = now_ns();
+    
+    if (!probes || !pfds || !pfd_probe) {
+        printf("[ERROR] Out of memory\n");
+        free(probes);
+        free(pfds);
+        free(pfd_probe);
         return -1;
     }
+    for (int i = 0; i < count; i++) {
+        probes[i].method = methods[i];
+        probes[i].pipe_fd = -1;
+    }
+    printf("[INFO] Probing %d methods, %d at a time, %d ms deadline each\n", count, jobs, timeout_ms);
+    
+    while (next < count || active > 0) {
+        uint64_t now = now_ns();
+        int wait_ms = -1;
+        int nfds = 0;
+        
+        // Start probes up to jobs at once
+        while (next < count && active < jobs) {
+            int ret = probe_start(probes, count, &probes[next], now);
+            
+            if (ret < 0) {
+                printf("[ERROR] Cannot start a worker for %s: %s\n", probes[next].method,
+                       strerror(-ret));
+                next = count;
+                break;
+            }
+            if (probes[next].state == PROBE_RUNNING) {
+                active++;
+            }
+            next++;
+        }
+        
+        // Deadlines: kill, then abandon what the kill did not reach
+        for (int i = 0; i < count; i++) {
+            struct probe *p = &probes[i];
+            
+            if (p->state == PROBE_RUNNING && now - p->start_ns >= timeout_ns) {
+                kill(p->pid, SIGKILL);
+                p->state = PROBE_KILLED;
+                p->end_ns = now;
+            }
+            if (p->state == PROBE_KILLED) {
+                if (waitpid(p->pid, NULL, WNOHANG) == p->pid) {
+                    close(p->pipe_fd);
+                    p->state = PROBE_TIMEOUT;
+                    active--;
+                } else if (now - p->end_ns >= grace_ns) {
+                    close(p->pipe_fd);
+                    p->state = PROBE_STUCK;
+                    stuck++;
+                    active--;
+                }
+            }
+        }
+        
+        // Wait for a report or the nearest deadline
+        for (int i = 0; i < count; i++) {
+            struct probe *p = &probes[i];
+            uint64_t due;
+            
+            if (p->state == PROBE_RUNNING) {
+                pfds[nfds].fd = p->pipe_fd;
+                pfds[nfds].events = POLLIN;
+                pfd_probe[nfds++] = i;
+                due = p->start_ns + timeout_ns;
+            } else if (p->state == PROBE_KILLED) {
+                due = p->end_ns + grace_ns;
+            } else {
+                continue;
+            }
+            int ms = due > now ? (int)((due - now + 999999) / 1000000) : 0;
+            
+            if (wait_ms < 0 || ms < wait_ms) {
+                wait_ms = ms;
+            }
+        }
+        if (wait_ms < 0) {
+            continue;
+        }
+        if (poll(pfds, (nfds_t)nfds, wait_ms) < 0 && errno != EINTR) {
+            printf("[ERROR] poll: %s\n", strerror(errno));
+            break;
+        }
+        now = now_ns();
+        for (int i = 0; i < nfds; i++) {
+            if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                probe_finish(&probes[pfd_probe[i]], now);
+                active--;
+            }
+        }
+    }
+    
+    probe_report(probes, count, &found);
+    for (int i = 0; i < count; i++) {
+        if (probes[i].overlapped && probes[i].state == PROBE_DONE) {
+            overlapped++;
+        }
+    }
+    printf("\n[INFO] %d responded, %d stuck, %.1f ms wall time\n", found, stuck,
+           (now_ns() - start) / 1e6);
+    if (overlapped > 0) {
+        printf("[WARNING] * %d responses overlapped another call; acpi_call has one result\n",
+               overlapped);
+        printf("[WARNING]   buffer, confirm them with --method\n");
+    }
+    if (stuck > 0) {
+        printf("[WARNING] %d workers are still inside firmware calls; ACPI may stay busy\n", stuck);
+    }
+    
+    free(probes);
+    free(pfds);
+    free(pfd_probe);
+    return found;
 }
 
 /*
@@ -171,12 +834,26 @@ static void print_usage(const char* progname) {
     printf("  --help          Show this help message\n");
     printf("  --verbose       Enable verbose debug output\n");
     printf("  --method <name> Test specific ACPI method\n");
+    printf("  --methods <file|-> Probe the candidate paths in a file, one per line\n");
+    printf("  --jobs <n>        Probes in flight at once (default 1, see below)\n");
+    printf("  --timeout <ms>    Per-probe deadline (default %d)\n", PROBE_TIMEOUT_MS);
     printf("  --call <method> <args> Call method with arguments\n");
+    printf("  --batch <file|->  Call one \"<method> [args]\" per line, tab separated results\n");
+    printf("  --repeat <n>      Batch: run the commands n times (benchmark)\n");
+    printf("  --quiet           Batch: only the calls/s summary\n");
+    printf("  --reopen          Batch: open /proc/acpi/call per call, for comparison\n");
     printf("\n");
     printf("Examples:\n");
     printf("  sudo %s                                    # Test all known methods\n", progname);
     printf("  sudo %s --method \"\\_SB.PC00.LPCB.EC0.KBCL\" # Test specific method\n", progname);
     printf("  sudo %s --call \"\\_SB.PC00.LPCB.EC0.WRAM\" \"0x01 0xFF 0x00 0x00\" # Call with args\n", progname);
+    printf("  sudo %s --methods paths.txt --timeout 500     # Unattended discovery\n", progname);
+    printf("  sudo %s --batch sweep.txt > results.tsv       # Payload sweep\n", progname);
+    printf("  sudo %s --batch sweep.txt --repeat 100 --quiet # Calls per second\n", progname);
+    printf("\n");
+    printf("Probes run in worker processes and are killed at the deadline, so a\n");
+    printf("hanging method cannot stall the run. acpi_call has one result buffer:\n");
+    printf("with --jobs > 1, responses of overlapping probes are marked with *.\n");
     printf("\n");
     printf("Prerequisites:\n");
     printf("  sudo modprobe acpi_call\n");
@@ -187,10 +864,15 @@ static void print_usage(const char* progname) {
  * Main function
  */
 int main(int argc, char *argv[]) {
-    int verbose_mode = 0;
     char *test_method = NULL;
     char *call_method = NULL;
     char *call_args = NULL;
+    char *batch_file = NULL;
+    char *methods_file = NULL;
+    int repeat = 1;
+    int quiet = 0;
+    int jobs = 1;
+    int timeout_ms = PROBE_TIMEOUT_MS;
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -204,6 +886,29 @@ int main(int argc, char *argv[]) {
         } else if (strcmp(argv[i], "--call") == 0 && i + 2 < argc) {
             call_method = argv[++i];
             call_args = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_file = argv[++i];
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+            if (repeat < 1) {
+                repeat = 1;
+            }
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--reopen") == 0) {
+            acpi_reopen = 1;
+        } else if (strcmp(argv[i], "--methods") == 0 && i + 1 < argc) {
+            methods_file = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+            if (jobs < 1) {
+                jobs = 1;
+            }
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeout_ms = atoi(argv[++i]);
+            if (timeout_ms < 1) {
+                timeout_ms = PROBE_TIMEOUT_MS;
+            }
         } else {
             printf("Unknown option: %s\n", argv[i]);
             print_usage(argv[0]);
@@ -211,6 +916,16 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    // Batch output is machine readable - no banner, diagnostics on stderr
+    if (batch_file) {
+        if (geteuid() != 0) {
+            fprintf(stderr, "[ERROR] This tool requires root privileges\n");
+            return 1;
+        }
+        read_board_name(stderr);
+        return run_batch(batch_file, repeat, quiet);
+    }
+    
     safety_info();
     
     printf("HP OMEN/Victus ACPI Method Test Tool\n");
@@ -228,10 +943,14 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    read_board_name(stdout);
+    
     // Handle specific method test
     if (test_method) {
+        const char *methods[] = { test_method };
+        
         printf("\n=== TESTING SPECIFIC METHOD ===\n");
-        return test_acpi_method(test_method);
+        return run_probes(methods, 1, 1, timeout_ms) > 0 ? 0 : 1;
     }
     
     // Handle method call with arguments
@@ -240,20 +959,36 @@ int main(int argc, char *argv[]) {
         return call_acpi_method(call_method, call_args);
     }
     
-    // Test all known HP ACPI methods
-    printf("\n=== TESTING ALL KNOWN HP ACPI METHODS ===\n");
+    // Test all known HP ACPI methods, or the candidates from --methods
+    const char **methods = hp_acpi_methods;
+    char **loaded = NULL;
+    int method_count = 0;
     
-    int found_methods = 0;
-    for (int i = 0; hp_acpi_methods[i]; i++) {
-        if (test_acpi_method(hp_acpi_methods[i]) == 0) {
-            found_methods++;
+    if (methods_file) {
+        method_count = load_methods(methods_file, &loaded);
+        if (method_count <= 0) {
+            printf("[ERROR] No methods in %s\n", methods_file);
+            return 1;
         }
-        printf("\n");
+        methods = (const char **)loaded;
+        printf("\n=== TESTING %d METHODS FROM %s ===\n", method_count, methods_file);
+    } else {
+        while (hp_acpi_methods[method_count]) {
+            method_count++;
+        }
+        printf("\n=== TESTING ALL KNOWN HP ACPI METHODS ===\n");
     }
     
-    printf("=== RESULTS ===\n");
-    printf("Found %d working ACPI methods out of %d tested\n", 
-           found_methods, (int)(sizeof(hp_acpi_methods)/sizeof(hp_acpi_methods[0]) - 1));
+    int found_methods = run_probes(methods, method_count, jobs, timeout_ms);
+    
+    for (int i = 0; loaded && i < method_count; i++) {
+        free(loaded[i]);
+    }
+    free(loaded);
+    if (found_methods < 0) {
+        return 1;
+    }
+    printf("Found %d working ACPI methods out of %d tested\n", found_methods, method_count);
     
     if (found_methods > 0) {
         printf("\n[SUCCESS] ACPI methods available for RGB control!\n");
@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * OMEN RGB Driver - per-board ACPI method signatures
+ *
+ * Shared by the kernel module and the userspace tools, so both check a
+ * call against the board's firmware before making it. Each entry gives a
+ * method's declared argument count and the smallest buffer its body (and
+ * every method it passes the buffer on to) indexes with constant offsets.
+ * A shorter buffer fails with AE_AML_BUFFER_LIMIT, and a method missing
+ * from a listed board fails with AE_NOT_FOUND, on every attempt.
+ *
+ * Entries come from the board's acpidump, not from live probing:
+ *
+ *   ./omen_aml_index sigs acpidump.txt
+ *
+ * Only the candidate methods the tools use are listed, so a board that is
+ * in the table but lacks an entry for a method does not implement it.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v2 - included by the kernel module
+ */
+
+#ifndef OMEN_ACPI_SIG_H
+#define OMEN_ACPI_SIG_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/string.h>
+#else
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#define OMEN_ACPI_SIG_NO_BUFFER     0xFF
+#define OMEN_ACPI_SIG_MAX_BUFFER    4096    // Largest HP WMI buffer class
+
+struct omen_acpi_sig {
+    const char *board;          // DMI board name (HP's SSDT OEM table ID)
+    const char *method;         // Full path as acpi_call takes it
+    uint8_t args;               // Declared argument count
+    uint8_t buffer_arg;         // Argument indexed as a buffer
+    uint16_t buffer_size;       // Smallest buffer every constant field fits in
+    uint8_t variable;           // Some fields are also sized at run time
+};
+
+static const struct omen_acpi_sig omen_acpi_sigs[] = {
+    // 8BD4 - test-tool/acpidump.txt; no SECU, WMAA dispatches through WHCM.
+    // The module calls \_SB.WMID.WMAA(0, 1, buffer) with a 1040 byte buffer.
+    { "8BD4", "\\AOD.WMAA", 3, 2, 8, 0 },        // Buffer in Arg2
+    { "8BD4", "\\_SB.WMID.WMAA", 3, 2, 1040, 1 }, // Buffer in Arg2, run-time sized fields
+    { "8BD4", "\\_SB.WMID.WMBA", 3, OMEN_ACPI_SIG_NO_BUFFER, 0, 0 },
+    { "8BD4", "\\_SB.CPWM.WMBB", 3, OMEN_ACPI_SIG_NO_BUFFER, 0, 0 },
+};
+
+static inline int omen_acpi_sig_board_known(const char *board)
+{
+    for (size_t i = 0; board && i < sizeof(omen_acpi_sigs) / sizeof(omen_acpi_sigs[0]); i++) {
+        if (strcmp(omen_acpi_sigs[i].board, board) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+static inline const struct omen_acpi_sig *omen_acpi_sig_find(const char *board,
+                                                             const char *method)
+{
+    for (size_t i = 0; board && i < sizeof(omen_acpi_sigs) / sizeof(omen_acpi_sigs[0]); i++) {
+        if (strcmp(omen_acpi_sigs[i].board, board) == 0 &&
+            strcmp(omen_acpi_sigs[i].method, method) == 0)
+            return &omen_acpi_sigs[i];
+    }
+    return NULL;
+}
+
+#endif /* OMEN_ACPI_SIG_H */
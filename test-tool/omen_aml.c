@@ -0,0 +1,1454 @@
+/*
+ * OMEN AML Namespace Library - table loader, AML walker and index
+ *
+ * The walker understands enough of the AML grammar to step over every
+ * term: named objects open scopes, methods and data packages are skipped
+ * by PkgLength, and expressions are skipped by their fixed operand lists.
+ * Method invocations outside method bodies take their argument count from
+ * Method or External declarations seen earlier in the same table. An
+ * unknown opcode abandons the rest of the enclosing package only.
+ *
+ * Signature inference reuses the walker on method bodies, resolving names
+ * against the finished namespace and noting how each ArgX is indexed.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "omen_aml.h"
+
+#define AML_MAX_DEPTH   64
+#define AML_MAX_CALLS   8       // Call depth followed by signature inference
+
+// Operand lists: T TermArg, S SuperName/Target, N NameString, b/w/d byte/word/dword
+static const char *const aml_ops[256] = {
+    [0x00] = "", [0x01] = "", [0xFF] = "",                  // Zero, One, Ones
+    [0x70] = "TS",      [0x71] = "S",       [0x72] = "TTS",     [0x73] = "TTS",
+    [0x74] = "TTS",     [0x75] = "S",       [0x76] = "S",       [0x77] = "TTS",
+    [0x78] = "TTSS",    [0x79] = "TTS",     [0x7A] = "TTS",     [0x7B] = "TTS",
+    [0x7C] = "TTS",     [0x7D] = "TTS",     [0x7E] = "TTS",     [0x7F] = "TTS",
+    [0x80] = "TS",      [0x81] = "TS",      [0x82] = "TS",      [0x83] = "T",
+    [0x84] = "TTS",     [0x85] = "TTS",     [0x86] = "ST",      [0x87] = "S",
+    [0x88] = "TTS",     [0x89] = "TbTbTT",  [0x8E] = "S",
+    [0x90] = "TT",      [0x91] = "TT",      [0x92] = "T",       [0x93] = "TT",
+    [0x94] = "TT",      [0x95] = "TT",      [0x96] = "TS",      [0x97] = "TS",
+    [0x98] = "TS",      [0x99] = "TS",      [0x9C] = "TTS",     [0x9D] = "TS",
+    [0x9E] = "TTTS",    [0x9F] = "",        [0xA3] = "",        [0xA4] = "T",
+    [0xA5] = "",        [0xCC] = "",
+};
+
+// Same, after the 0x5B ExtOpPrefix
+static const char *const aml_ext_ops[256] = {
+    [0x12] = "SS",      [0x1F] = "TTTTTT",  [0x20] = "NS",      [0x21] = "T",
+    [0x22] = "T",       [0x23] = "Sw",      [0x24] = "S",       [0x25] = "ST",
+    [0x26] = "S",       [0x27] = "S",       [0x28] = "TS",      [0x29] = "TS",
+    [0x2A] = "S",       [0x30] = "",        [0x31] = "",        [0x32] = "bdT",
+    [0x33] = "",
+};
+
+static const char *const aml_type_names[OMEN_AML_TYPES] = {
+    [OMEN_AML_DEVICE] = "Device",
+    [OMEN_AML_METHOD] = "Method",
+    [OMEN_AML_NAME] = "Name",
+    [OMEN_AML_REGION] = "OpRegion",
+    [OMEN_AML_FIELD] = "Field",
+    [OMEN_AML_BUFFER_FIELD] = "BufferField",
+    [OMEN_AML_MUTEX] = "Mutex",
+    [OMEN_AML_EVENT] = "Event",
+    [OMEN_AML_PROCESSOR] = "Processor",
+    [OMEN_AML_POWER] = "PowerResource",
+    [OMEN_AML_THERMAL] = "ThermalZone",
+    [OMEN_AML_ALIAS] = "Alias",
+    [OMEN_AML_DATA_REGION] = "DataRegion",
+    [OMEN_AML_EXTERNAL] = "External",
+};
+
+struct aml_name {
+    int root;                   // Leading '\'
+    int up;                     // Number of '^'
+    int segment_count;
+    const uint8_t *segments;    // 4 bytes each, inside the table
+};
+
+// Per-table walker state, one per worker
+struct aml_parser {
+    const uint8_t *aml;
+    uint32_t size;
+    uint16_t table;
+    int depth;
+    int failed;                 // Unknown opcode or overrun in the current package
+    int errors;
+    
+    struct omen_aml_node *nodes;
+    uint32_t count, capacity;
+    
+    uint32_t *hash;             // Method/External nodes by path, index + 1
+    uint32_t hash_size, hash_used;
+    
+    // Method body walks - names resolve in ns, nothing is declared
+    const struct omen_aml_ns *ns;
+    struct omen_aml_signature *sig;
+    int calls;
+};
+
+const char *omen_aml_type_name(int type) {
+    if (type <= 0 || type >= OMEN_AML_TYPES) {
+        return "Unknown";
+    }
+    return aml_type_names[type];
+}
+
+static uint32_t aml_fnv(const void *data, size_t size, uint32_t h) {
+    const uint8_t *p = data;
+    
+    while (size--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * Path helpers
+ */
+int omen_aml_normalize_path(const char *in, char *out, size_t size) {
+    size_t len = 1;
+    
+    if (size < 2) {
+        return -ENAMETOOLONG;
+    }
+    if (*in == '\\') {
+        in++;
+    }
+    strcpy(out, "\\");
+    
+    while (*in) {
+        int n = 0;
+        
+        if (len + 5 >= size) {
+            return -ENAMETOOLONG;
+        }
+        if (len > 1) {
+            out[len++] = '.';
+        }
+        while (*in && *in != '.') {
+            char c = (char)toupper((unsigned char)*in++);
+            
+            if (n == 4 || !(isupper((unsigned char)c) || isdigit((unsigned char)c) || c == '_') ||
+                (n == 0 && isdigit((unsigned char)c))) {
+                return -EINVAL;
+            }
+            out[len + n++] = c;
+        }
+        if (n == 0) {
+            return -EINVAL;
+        }
+        while (n < 4) {
+            out[len + n++] = '_';
+        }
+        len += 4;
+        out[len] = '\0';
+        if (*in == '.') {
+            in++;
+        }
+    }
+    return 0;
+}
+
+// "\\_SB_.PCI0.EC0_" -> "\\_SB.PCI0.EC0", the form acpi_call and iasl print
+void omen_aml_display_path(const char *path, char *out, size_t size) {
+    size_t len = 0;
+    
+    if (size == 0) {
+        return;
+    }
+    while (*path && len + 1 < size) {
+        if (*path == '\\' || *path == '.') {
+            out[len++] = *path++;
+            continue;
+        }
+        int n = 4;
+        
+        while (n > 1 && path[n - 1] == '_') {
+            n--;
+        }
+        for (int i = 0; i < n && len + 1 < size; i++) {
+            out[len++] = path[i];
+        }
+        path += 4;
+    }
+    out[len] = '\0';
+}
+
+/*
+ * Table loading
+ */
+static int aml_is_aml_table(const char *signature) {
+    return strcmp(signature, "DSDT") == 0 || strcmp(signature, "SSDT") == 0 ||
+           strcmp(signature, "PSDT") == 0;
+}
+
+static int aml_add_table(struct omen_aml_ns *ns, const uint8_t *data, uint32_t size) {
+    struct omen_aml_table *tables, *t;
+    uint32_t length;
+    
+    if (size < OMEN_AML_HEADER_SIZE) {
+        return -EINVAL;
+    }
+    memcpy(&length, data + 4, sizeof(length));
+    if (length < OMEN_AML_HEADER_SIZE || length > size) {
+        return -EINVAL;
+    }
+    
+    tables = realloc(ns->tables, sizeof(*tables) * (ns->table_count + 1));
+    if (!tables) {
+        return -ENOMEM;
+    }
+    ns->tables = tables;
+    t = &tables[ns->table_count];
+    memset(t, 0, sizeof(*t));
+    memcpy(t->signature, data, 4);
+    memcpy(t->oem_table_id, data + 16, 8);
+    t->length = length;
+    t->data = malloc(length);
+    if (!t->data) {
+        return -ENOMEM;
+    }
+    memcpy(t->data, data, length);
+    
+    // Only definition blocks carry a namespace
+    if (!aml_is_aml_table(t->signature)) {
+        free(t->data);
+        return 0;
+    }
+    ns->table_count++;
+    return 0;
+}
+
+static int aml_hex(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/*
+ * acpidump text: "DSDT @ 0x..." starts a table, then lines of
+ * "    0000: 44 53 44 54 ...  DSDT..." with up to 16 bytes each
+ */
+static int aml_load_text(struct omen_aml_ns *ns, FILE *fp) {
+    char line[256];
+    uint8_t *buf = NULL;
+    size_t cap = 0, used = 0;
+    int in_table = 0, ret = 0;
+    
+    while (ret == 0) {
+        char *eol = fgets(line, sizeof(line), fp);
+        
+        if (!eol || (!isspace((unsigned char)line[0]) && strstr(line, " @ 0x"))) {
+            // A new header or EOF closes the previous table
+            // Tables cut short in the dump are skipped, not fatal
+            if (in_table && used && aml_add_table(ns, buf, (uint32_t)used) == -ENOMEM) {
+                ret = -ENOMEM;
+            }
+            if (!eol) {
+                break;
+            }
+            in_table = 1;
+            used = 0;
+            continue;
+        }
+        if (!in_table) {
+            continue;
+        }
+        
+        char *p = line, *end;
+        unsigned long offset;
+        
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        offset = strtoul(p, &end, 16);
+        if (end == p || *end != ':') {
+            continue;
+        }
+        p = end + 1;
+        
+        // Bytes are " xx" pairs; the ASCII column starts after two spaces
+        uint8_t bytes[16];
+        int n = 0;
+        
+        while (n < 16 && p[0] == ' ' && aml_hex(p[1]) >= 0 && aml_hex(p[2]) >= 0 &&
+               (p[3] == ' ' || p[3] == '\n' || p[3] == '\r' || p[3] == '\0')) {
+            bytes[n++] = (uint8_t)(aml_hex(p[1]) << 4 | aml_hex(p[2]));
+            p += 3;
+        }
+        if (offset + n > cap) {
+            size_t new_cap = cap ? cap * 2 : 65536;
+            uint8_t *new_buf;
+            
+            while (new_cap < offset + n) {
+                new_cap *= 2;
+            }
+            new_buf = realloc(buf, new_cap);
+            if (!new_buf) {
+                ret = -ENOMEM;
+                break;
+            }
+            buf = new_buf;
+            cap = new_cap;
+        }
+        memcpy(buf + offset, bytes, n);
+        if (offset + n > used) {
+            used = offset + n;
+        }
+    }
+    free(buf);
+    return ret;
+}
+
+// Raw tables (acpidump -b, /sys/firmware/acpi/tables), possibly concatenated
+static int aml_load_raw(struct omen_aml_ns *ns, const uint8_t *data, size_t size) {
+    size_t pos = 0;
+    
+    while (pos + OMEN_AML_HEADER_SIZE <= size) {
+        uint32_t length;
+        int ret;
+        
+        memcpy(&length, data + pos + 4, sizeof(length));
+        ret = aml_add_table(ns, data + pos, (uint32_t)(size - pos));
+        if (ret) {
+            return ret;
+        }
+        pos += length;
+    }
+    return 0;
+}
+
+int omen_aml_load(struct omen_aml_ns *ns, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    uint8_t header[OMEN_AML_HEADER_SIZE];
+    size_t n;
+    int raw = 1, ret;
+    
+    if (!fp) {
+        return -errno;
+    }
+    
+    // Raw tables start with a signature; acpidump text has "XXXX @ 0x" there
+    n = fread(header, 1, sizeof(header), fp);
+    for (int i = 0; i < 4; i++) {
+        if (n < sizeof(header) || !(isupper(header[i]) || isdigit(header[i]))) {
+            raw = 0;
+        }
+    }
+    if (raw && memcmp(header + 4, " @ 0x", 5) == 0) {
+        raw = 0;
+    }
+    
+    if (raw) {
+        struct stat st;
+        uint8_t *data;
+        
+        if (fstat(fileno(fp), &st) != 0) {
+            ret = -errno;
+            fclose(fp);
+            return ret;
+        }
+        data = malloc(st.st_size);
+        if (!data) {
+            fclose(fp);
+            return -ENOMEM;
+        }
+        rewind(fp);
+        n = fread(data, 1, st.st_size, fp);
+        ret = aml_load_raw(ns, data, n);
+        free(data);
+    } else {
+        rewind(fp);
+        ret = aml_load_text(ns, fp);
+    }
+    fclose(fp);
+    return ret;
+}
+
+/*
+ * AML walker
+ */
+static uint32_t aml_fail(struct aml_parser *p) {
+    p->failed = 1;
+    return p->size;
+}
+
+static int aml_name_start(uint8_t c) {
+    return c == '\\' || c == '^' || c == 0x2E || c == 0x2F || c == '_' ||
+           (c >= 'A' && c <= 'Z');
+}
+
+static int aml_name_char(uint8_t c) {
+    return c == '_' || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+// PkgLength as a plain number (field widths use the same encoding)
+static uint32_t aml_pkg_value(struct aml_parser *p, uint32_t pos, uint32_t *value) {
+    int count;
+    
+    if (pos >= p->size) {
+        return aml_fail(p);
+    }
+    count = p->aml[pos] >> 6;
+    if (pos + 1 + count > p->size) {
+        return aml_fail(p);
+    }
+    if (count == 0) {
+        *value = p->aml[pos] & 0x3F;
+    } else {
+        *value = p->aml[pos] & 0x0F;
+        for (int i = 0; i < count; i++) {
+            *value |= (uint32_t)p->aml[pos + 1 + i] << (4 + 8 * i);
+        }
+    }
+    return pos + 1 + count;
+}
+
+// PkgLength counts its own bytes, so the package ends at its first byte + value
+static uint32_t aml_pkg_length(struct aml_parser *p, uint32_t pos, uint32_t *end) {
+    uint32_t value, next = aml_pkg_value(p, pos, &value);
+    
+    if (p->failed) {
+        return next;
+    }
+    *end = pos + value;
+    if (*end > p->size || *end < next) {
+        return aml_fail(p);
+    }
+    return next;
+}
+
+static uint32_t aml_name_string(struct aml_parser *p, uint32_t pos, struct aml_name *name) {
+    memset(name, 0, sizeof(*name));
+    
+    if (pos < p->size && p->aml[pos] == '\\') {
+        name->root = 1;
+        pos++;
+    } else {
+        while (pos < p->size && p->aml[pos] == '^') {
+            name->up++;
+            pos++;
+        }
+    }
+    if (pos >= p->size) {
+        return aml_fail(p);
+    }
+    
+    switch (p->aml[pos]) {
+    case 0x00:                  // NullName
+        return pos + 1;
+    case 0x2E:                  // DualNamePrefix
+        name->segment_count = 2;
+        pos++;
+        break;
+    case 0x2F:                  // MultiNamePrefix
+        if (pos + 1 >= p->size) {
+            return aml_fail(p);
+        }
+        name->segment_count = p->aml[pos + 1];
+        pos += 2;
+        break;
+    default:
+        name->segment_count = 1;
+        break;
+    }
+    
+    if (pos + 4 * (uint32_t)name->segment_count > p->size) {
+        return aml_fail(p);
+    }
+    for (int i = 0; i < 4 * name->segment_count; i++) {
+        uint8_t c = p->aml[pos + i];
+        
+        if (!aml_name_char(c) || (i % 4 == 0 && c >= '0' && c <= '9')) {
+            return aml_fail(p);
+        }
+    }
+    name->segments = &p->aml[pos];
+    return pos + 4 * name->segment_count;
+}
+
+// Resolve a name against the current scope (no search rules)
+static int aml_join(const char *scope, const struct aml_name *name, char *out) {
+    size_t len;
+    
+    if (name->root) {
+        strcpy(out, "\\");
+    } else {
+        strcpy(out, scope);
+        for (int i = 0; i < name->up; i++) {
+            char *dot = strrchr(out, '.');
+            
+            if (dot) {
+                *dot = '\0';
+            } else if (strlen(out) > 1) {
+                out[1] = '\0';
+            } else {
+                return -EINVAL;
+            }
+        }
+    }
+    
+    len = strlen(out);
+    for (int i = 0; i < name->segment_count; i++) {
+        if (len + 6 > OMEN_AML_PATH_MAX) {
+            return -ENAMETOOLONG;
+        }
+        if (len > 1) {
+            out[len++] = '.';
+        }
+        memcpy(out + len, name->segments + 4 * i, 4);
+        len += 4;
+        out[len] = '\0';
+    }
+    return 0;
+}
+
+static uint32_t *aml_hash_slot(struct aml_parser *p, const char *path) {
+    uint32_t mask = p->hash_size - 1;
+    uint32_t i = aml_fnv(path, strlen(path), 2166136261u) & mask;
+    
+    while (p->hash[i] && strcmp(p->nodes[p->hash[i] - 1].path, path) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &p->hash[i];
+}
+
+static int aml_hash_insert(struct aml_parser *p, uint32_t index) {
+    if ((p->hash_used + 1) * 2 > p->hash_size) {
+        uint32_t *old = p->hash, old_size = p->hash_size;
+        
+        p->hash_size = old_size ? old_size * 2 : 256;
+        p->hash = calloc(p->hash_size, sizeof(*p->hash));
+        if (!p->hash) {
+            p->hash = old;
+            p->hash_size = old_size;
+            return -ENOMEM;
+        }
+        for (uint32_t i = 0; i < old_size; i++) {
+            if (old[i]) {
+                *aml_hash_slot(p, p->nodes[old[i] - 1].path) = old[i];
+            }
+        }
+        free(old);
+    }
+    
+    uint32_t *slot = aml_hash_slot(p, p->nodes[index].path);
+    
+    if (!*slot) {
+        p->hash_used++;
+        *slot = index + 1;
+    }
+    return 0;
+}
+
+static struct omen_aml_node *aml_add_node(struct aml_parser *p, int type, const char *scope,
+                                          const struct aml_name *name, uint32_t offset) {
+    struct omen_aml_node *node;
+    
+    // Objects created inside a method body are locals
+    if (name->segment_count == 0 || p->ns) {
+        return NULL;
+    }
+    if (p->count == p->capacity) {
+        uint32_t capacity = p->capacity ? p->capacity * 2 : 1024;
+        struct omen_aml_node *nodes = realloc(p->nodes, sizeof(*nodes) * capacity);
+        
+        if (!nodes) {
+            aml_fail(p);
+            return NULL;
+        }
+        p->nodes = nodes;
+        p->capacity = capacity;
+    }
+    
+    node = &p->nodes[p->count];
+    memset(node, 0, sizeof(*node));
+    if (aml_join(scope, name, node->path)) {
+        return NULL;
+    }
+    node->type = (uint8_t)type;
+    node->table = p->table;
+    node->offset = offset;
+    p->count++;
+    
+    if ((type == OMEN_AML_METHOD || type == OMEN_AML_EXTERNAL) &&
+        aml_hash_insert(p, p->count - 1)) {
+        aml_fail(p);
+    }
+    return node;
+}
+
+static const struct omen_aml_node *aml_lookup(struct aml_parser *p, const char *path) {
+    uint32_t slot;
+    
+    if (p->ns) {
+        return omen_aml_find_path(p->ns, path);
+    }
+    if (!p->hash_size) {
+        return NULL;
+    }
+    slot = *aml_hash_slot(p, path);
+    return slot ? &p->nodes[slot - 1] : NULL;
+}
+
+// The method a name invokes, using ACPI search rules; NULL for plain objects
+static const struct omen_aml_node *aml_find_method(struct aml_parser *p, const char *scope,
+                                                   const struct aml_name *name) {
+    char path[OMEN_AML_PATH_MAX], base[OMEN_AML_PATH_MAX];
+    
+    if (name->segment_count == 0) {
+        return NULL;
+    }
+    
+    // Single segments search upward from the current scope
+    strcpy(base, scope);
+    for (;;) {
+        if (aml_join(base, name, path) == 0) {
+            const struct omen_aml_node *node = aml_lookup(p, path);
+            
+            if (node) {
+                if (node->type == OMEN_AML_METHOD ||
+                    (node->type == OMEN_AML_EXTERNAL && node->flags == 8)) {
+                    return node;
+                }
+                return NULL;
+            }
+        }
+        if (name->root || name->up || name->segment_count > 1 || strcmp(base, "\\") == 0) {
+            return NULL;
+        }
+        char *dot = strrchr(base, '.');
+        
+        if (dot) {
+            *dot = '\0';
+        } else {
+            base[1] = '\0';
+        }
+    }
+}
+
+static uint32_t aml_term(struct aml_parser *p, uint32_t pos, const char *scope);
+
+static uint32_t aml_super_name(struct aml_parser *p, uint32_t pos, const char *scope) {
+    struct aml_name name;
+    
+    if (pos < p->size && aml_name_start(p->aml[pos])) {
+        return aml_name_string(p, pos, &name);
+    }
+    return aml_term(p, pos, scope);
+}
+
+static uint32_t aml_operands(struct aml_parser *p, uint32_t pos, const char *spec,
+                             const char *scope) {
+    struct aml_name name;
+    
+    for (; *spec && !p->failed; spec++) {
+        switch (*spec) {
+        case 'T': pos = aml_term(p, pos, scope); break;
+        case 'S': pos = aml_super_name(p, pos, scope); break;
+        case 'N': pos = aml_name_string(p, pos, &name); break;
+        case 'b': pos += 1; break;
+        case 'w': pos += 2; break;
+        case 'd': pos += 4; break;
+        }
+        if (pos > p->size) {
+            return aml_fail(p);
+        }
+    }
+    return pos;
+}
+
+// Integer constant operand - returns its encoded size, 0 if not a constant
+static int aml_constant(const struct aml_parser *p, uint32_t pos, uint32_t *value) {
+    static const int sizes[] = { [0x0A] = 1, [0x0B] = 2, [0x0C] = 4 };
+    uint8_t op;
+    
+    if (pos >= p->size) {
+        return 0;
+    }
+    op = p->aml[pos];
+    if (op == 0x00 || op == 0x01) {
+        *value = op;
+        return 1;
+    }
+    if (op < 0x0A || op > 0x0C || pos + 1 + sizes[op] > p->size) {
+        return 0;
+    }
+    *value = 0;
+    for (int i = 0; i < sizes[op]; i++) {
+        *value |= (uint32_t)p->aml[pos + 1 + i] << (8 * i);
+    }
+    return 1 + sizes[op];
+}
+
+/*
+ * Signature inference hooks
+ */
+static int aml_arg_operand(const struct aml_parser *p, uint32_t pos) {
+    if (pos < p->size && p->aml[pos] >= 0x68 && p->aml[pos] <= 0x6E) {
+        return p->aml[pos] - 0x68;
+    }
+    return -1;
+}
+
+static void aml_sig_need(struct aml_parser *p, int arg, uint32_t size, int variable) {
+    p->sig->arg_flags[arg] |= OMEN_AML_ARG_BUFFER | (variable ? OMEN_AML_ARG_VARIABLE : 0);
+    if (size > p->sig->arg_size[arg]) {
+        p->sig->arg_size[arg] = size;
+    }
+}
+
+/*
+ * CreateBitField/ByteField/WordField/DWordField/QWordField, CreateField and
+ * Index with ArgX as the source; pos is the first operand
+ */
+static void aml_sig_field(struct aml_parser *p, uint32_t pos, int op) {
+    int arg = aml_arg_operand(p, pos);
+    uint32_t index, bits;
+    int n;
+    
+    if (arg < 0) {
+        return;
+    }
+    n = aml_constant(p, pos + 1, &index);
+    switch (op) {
+    case 0x8A: aml_sig_need(p, arg, index + 4, !n); break;
+    case 0x8B: aml_sig_need(p, arg, index + 2, !n); break;
+    case 0x8C: aml_sig_need(p, arg, index + 1, !n); break;
+    case 0x8F: aml_sig_need(p, arg, index + 8, !n); break;
+    case 0x88: aml_sig_need(p, arg, index + 1, !n); break;
+    case 0x8D: aml_sig_need(p, arg, index / 8 + 1, !n); break;
+    case 0x13:                  // CreateField, bit index and bit count
+        if (n && aml_constant(p, pos + 1 + n, &bits)) {
+            aml_sig_need(p, arg, (index + bits + 7) / 8, 0);
+        } else {
+            aml_sig_need(p, arg, n ? (index + 7) / 8 : 0, 1);
+        }
+        break;
+    }
+    if (!n) {
+        aml_sig_need(p, arg, 0, 1);
+    }
+}
+
+static int aml_infer(const struct omen_aml_ns *ns, const struct omen_aml_node *method,
+                     struct omen_aml_signature *sig, int calls);
+
+// The k-th argument of a call is our ArgX: it takes the callee's shape
+static void aml_sig_call(struct aml_parser *p, const struct omen_aml_node *callee,
+                         int k, int arg) {
+    struct omen_aml_signature inner;
+    
+    if (callee->type != OMEN_AML_METHOD || callee == p->sig->method ||
+        p->calls >= AML_MAX_CALLS || k >= OMEN_AML_MAX_ARGS) {
+        return;
+    }
+    if (aml_infer(p->ns, callee, &inner, p->calls + 1) < 0) {
+        return;
+    }
+    if (inner.arg_flags[k]) {
+        p->sig->arg_flags[arg] |= inner.arg_flags[k];
+        if (inner.arg_size[k] > p->sig->arg_size[arg]) {
+            p->sig->arg_size[arg] = inner.arg_size[k];
+        }
+    }
+}
+
+static void aml_term_list(struct aml_parser *p, uint32_t pos, uint32_t end, const char *scope) {
+    uint32_t size = p->size;
+    
+    if (++p->depth > AML_MAX_DEPTH) {
+        p->failed = 1;
+    }
+    
+    // Bound the walk to this package so an overrun cannot leak into siblings
+    p->size = end;
+    while (pos < end && !p->failed) {
+        pos = aml_term(p, pos, scope);
+    }
+    p->size = size;
+    
+    if (p->failed) {
+        p->errors++;
+        p->failed = 0;
+    }
+    p->depth--;
+}
+
+static uint32_t aml_field_list(struct aml_parser *p, uint32_t pos, uint32_t end,
+                               const char *scope) {
+    uint32_t bit = 0, width;
+    struct aml_name name;
+    
+    if (p->failed) {
+        return pos;
+    }
+    while (pos < end && !p->failed) {
+        switch (p->aml[pos]) {
+        case 0x00:              // ReservedField
+            pos = aml_pkg_value(p, pos + 1, &width);
+            bit += width;
+            break;
+        case 0x01:              // AccessField
+            pos += 3;
+            break;
+        case 0x02:              // ConnectField
+            if (pos + 1 < end && p->aml[pos + 1] == 0x11) {
+                pos = aml_term(p, pos + 1, scope);
+            } else {
+                pos = aml_name_string(p, pos + 1, &name);
+            }
+            break;
+        case 0x03:              // ExtendedAccessField
+            pos += 4;
+            break;
+        default: {
+            struct omen_aml_node *node;
+            uint32_t offset = pos;
+            
+            name.root = name.up = 0;
+            name.segment_count = 1;
+            name.segments = &p->aml[pos];
+            if (pos + 4 > end || !aml_name_char(p->aml[pos])) {
+                return aml_fail(p);
+            }
+            pos = aml_pkg_value(p, pos + 4, &width);
+            node = aml_add_node(p, OMEN_AML_FIELD, scope, &name, offset);
+            if (node) {
+                node->body = bit;
+                node->length = width;
+            }
+            bit += width;
+            break;
+        }
+        }
+    }
+    return pos > end ? aml_fail(p) : end;
+}
+
+/*
+ * Named object with a PkgLength and a term list: Device, ThermalZone,
+ * Processor (5 fixed bytes), PowerResource (3 fixed bytes)
+ */
+static uint32_t aml_named_scope(struct aml_parser *p, uint32_t start, uint32_t pos,
+                                int type, int fixed, const char *scope) {
+    char child[OMEN_AML_PATH_MAX];
+    struct aml_name name;
+    uint32_t end;
+    
+    pos = aml_pkg_length(p, pos, &end);
+    pos = aml_name_string(p, pos, &name);
+    if (p->failed || pos + fixed > end || aml_join(scope, &name, child)) {
+        return aml_fail(p);
+    }
+    if (type) {
+        aml_add_node(p, type, scope, &name, start);
+    }
+    aml_term_list(p, pos + fixed, end, child);
+    return end;
+}
+
+static uint32_t aml_ext_term(struct aml_parser *p, uint32_t start, const char *scope) {
+    uint32_t pos = start + 2, end, value;
+    struct omen_aml_node *node;
+    struct aml_name name;
+    
+    if (start + 1 >= p->size) {
+        return aml_fail(p);
+    }
+    
+    switch (p->aml[start + 1]) {
+    case 0x01:                  // Mutex
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_MUTEX, scope, &name, start);
+        return pos + 1;
+    case 0x02:                  // Event
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_EVENT, scope, &name, start);
+        return pos;
+    case 0x13:                  // CreateField
+        if (p->sig) {
+            aml_sig_field(p, pos, 0x13);
+        }
+        pos = aml_operands(p, pos, "TTT", scope);
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_BUFFER_FIELD, scope, &name, start);
+        return pos;
+    case 0x80:                  // OperationRegion
+        pos = aml_name_string(p, pos, &name);
+        if (p->failed || pos >= p->size) {
+            return aml_fail(p);
+        }
+        node = aml_add_node(p, OMEN_AML_REGION, scope, &name, start);
+        if (node) {
+            node->flags = p->aml[pos];
+        }
+        pos++;
+        if (node && aml_constant(p, pos, &value)) {
+            node->body = value;
+        }
+        pos = aml_term(p, pos, scope);
+        if (node && aml_constant(p, pos, &value)) {
+            node->length = value;
+        }
+        return aml_term(p, pos, scope);
+    case 0x81:                  // Field
+        pos = aml_pkg_length(p, pos, &end);
+        pos = aml_name_string(p, pos, &name);
+        return aml_field_list(p, pos + 1, end, scope);
+    case 0x82:
+        return aml_named_scope(p, start, pos, OMEN_AML_DEVICE, 0, scope);
+    case 0x83:
+        return aml_named_scope(p, start, pos, OMEN_AML_PROCESSOR, 6, scope);
+    case 0x84:
+        return aml_named_scope(p, start, pos, OMEN_AML_POWER, 3, scope);
+    case 0x85:
+        return aml_named_scope(p, start, pos, OMEN_AML_THERMAL, 0, scope);
+    case 0x86:                  // IndexField
+        pos = aml_pkg_length(p, pos, &end);
+        pos = aml_operands(p, pos, "NN", scope);
+        return aml_field_list(p, pos + 1, end, scope);
+    case 0x87:                  // BankField
+        pos = aml_pkg_length(p, pos, &end);
+        pos = aml_operands(p, pos, "NNT", scope);
+        return aml_field_list(p, pos + 1, end, scope);
+    case 0x88:                  // DataTableRegion
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_DATA_REGION, scope, &name, start);
+        return aml_operands(p, pos, "TTT", scope);
+    }
+    
+    if (aml_ext_ops[p->aml[start + 1]]) {
+        return aml_operands(p, pos, aml_ext_ops[p->aml[start + 1]], scope);
+    }
+    return aml_fail(p);
+}
+
+static uint32_t aml_term(struct aml_parser *p, uint32_t pos, const char *scope) {
+    struct omen_aml_node *node;
+    struct aml_name name;
+    uint32_t start = pos, end;
+    const uint8_t *nul;
+    uint8_t op;
+    
+    if (p->failed || pos >= p->size) {
+        return aml_fail(p);
+    }
+    op = p->aml[pos++];
+    
+    // Method invocation or named reference
+    if (aml_name_start(op)) {
+        const struct omen_aml_node *callee;
+        
+        pos = aml_name_string(p, start, &name);
+        callee = p->failed ? NULL : aml_find_method(p, scope, &name);
+        for (int k = 0; callee && k < callee->args && !p->failed; k++) {
+            int arg = aml_arg_operand(p, pos);
+            
+            if (p->sig && arg >= 0) {
+                aml_sig_call(p, callee, k, arg);
+            }
+            pos = aml_term(p, pos, scope);
+        }
+        return pos;
+    }
+    if (op >= 0x60 && op <= 0x6E) {     // LocalX, ArgX
+        return pos;
+    }
+    
+    switch (op) {
+    case 0x0A: return pos + 1;          // BytePrefix
+    case 0x0B: return pos + 2;          // WordPrefix
+    case 0x0C: return pos + 4;          // DWordPrefix
+    case 0x0E: return pos + 8;          // QWordPrefix
+    case 0x0D:                          // String
+        nul = memchr(p->aml + pos, 0, p->size - pos);
+        return nul ? (uint32_t)(nul - p->aml) + 1 : aml_fail(p);
+    case 0x11:                          // Buffer
+    case 0x12:                          // Package
+    case 0x13:                          // VarPackage
+        aml_pkg_length(p, pos, &end);
+        return p->failed ? pos : end;
+    case 0x06:                          // Alias
+        pos = aml_name_string(p, pos, &name);
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_ALIAS, scope, &name, start);
+        return pos;
+    case 0x08:                          // Name
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_NAME, scope, &name, start);
+        return aml_term(p, pos, scope);
+    case 0x10:                          // Scope
+        return aml_named_scope(p, start, pos, 0, 0, scope);
+    case 0x14:                          // Method
+        pos = aml_pkg_length(p, pos, &end);
+        pos = aml_name_string(p, pos, &name);
+        if (p->failed || pos >= end) {
+            return aml_fail(p);
+        }
+        node = aml_add_node(p, OMEN_AML_METHOD, scope, &name, start);
+        if (node) {
+            node->args = p->aml[pos] & 0x07;
+            node->flags = p->aml[pos];
+            node->body = pos + 1;
+            node->length = end - (pos + 1);
+        }
+        return end;
+    case 0x15:                          // External
+        pos = aml_name_string(p, pos, &name);
+        if (p->failed || pos + 2 > p->size) {
+            return aml_fail(p);
+        }
+        node = aml_add_node(p, OMEN_AML_EXTERNAL, scope, &name, start);
+        if (node) {
+            node->flags = p->aml[pos];
+            node->args = p->aml[pos + 1];
+        }
+        return pos + 2;
+    case 0x8A:                          // CreateDWordField
+    case 0x8B:                          // CreateWordField
+    case 0x8C:                          // CreateByteField
+    case 0x8D:                          // CreateBitField
+    case 0x8F:                          // CreateQWordField
+        if (p->sig) {
+            aml_sig_field(p, pos, op);
+        }
+        pos = aml_operands(p, pos, "TT", scope);
+        pos = aml_name_string(p, pos, &name);
+        aml_add_node(p, OMEN_AML_BUFFER_FIELD, scope, &name, start);
+        return pos;
+    case 0xA0:                          // If
+    case 0xA2:                          // While
+        pos = aml_pkg_length(p, pos, &end);
+        pos = aml_term(p, pos, scope);
+        if (p->failed || pos > end) {
+            return aml_fail(p);
+        }
+        aml_term_list(p, pos, end, scope);
+        return end;
+    case 0xA1:                          // Else
+        pos = aml_pkg_length(p, pos, &end);
+        if (!p->failed) {
+            aml_term_list(p, pos, end, scope);
+        }
+        return p->failed ? pos : end;
+    case 0x5B:
+        return aml_ext_term(p, start, scope);
+    }
+    
+    if (op == 0x88 && p->sig) {         // Index
+        aml_sig_field(p, pos, op);
+    }
+    if (aml_ops[op]) {
+        return aml_operands(p, pos, aml_ops[op], scope);
+    }
+    return aml_fail(p);
+}
+
+/*
+ * Signature inference - walk one method body against the built namespace
+ */
+static int aml_infer(const struct omen_aml_ns *ns, const struct omen_aml_node *method,
+                     struct omen_aml_signature *sig, int calls) {
+    const struct omen_aml_table *t;
+    struct aml_parser p = { 0 };
+    
+    memset(sig, 0, sizeof(*sig));
+    sig->method = method;
+    sig->args = method->args;
+    if (method->type != OMEN_AML_METHOD) {
+        return -EINVAL;
+    }
+    t = &ns->tables[method->table];
+    if (!t->data) {
+        return -ENODATA;
+    }
+    if (method->body + method->length > t->length) {
+        return -EINVAL;
+    }
+    
+    p.aml = t->data;
+    p.size = method->body + method->length;
+    p.table = method->table;
+    p.ns = ns;
+    p.sig = sig;
+    p.calls = calls;
+    aml_term_list(&p, method->body, p.size, method->path);
+    return p.errors;
+}
+
+int omen_aml_infer_signature(const struct omen_aml_ns *ns, const struct omen_aml_node *method,
+                             struct omen_aml_signature *sig) {
+    return aml_infer(ns, method, sig, 0);
+}
+
+/*
+ * Parallel build - workers take tables off a shared counter
+ */
+struct aml_work {
+    const struct omen_aml_ns *ns;
+    struct aml_parser *parsers;
+    int next;
+};
+
+static void *aml_worker(void *arg) {
+    struct aml_work *work = arg;
+    int i;
+    
+    while ((i = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED)) < work->ns->table_count) {
+        const struct omen_aml_table *t = &work->ns->tables[i];
+        struct aml_parser *p = &work->parsers[i];
+        
+        p->aml = t->data;
+        p->size = t->length;
+        p->table = (uint16_t)i;
+        aml_term_list(p, OMEN_AML_HEADER_SIZE, t->length, "\\");
+    }
+    return NULL;
+}
+
+// Same path: real definitions before Externals, then table load order
+static int aml_node_cmp(const void *a, const void *b) {
+    const struct omen_aml_node *x = a, *y = b;
+    int c = strcmp(x->path, y->path);
+    
+    if (c) {
+        return c;
+    }
+    c = (x->type == OMEN_AML_EXTERNAL) - (y->type == OMEN_AML_EXTERNAL);
+    if (c) {
+        return c;
+    }
+    return (int)x->table - (int)y->table;
+}
+
+static const char *aml_last_segment(const char *path) {
+    size_t len = strlen(path);
+    
+    return len >= 4 ? path + len - 4 : path;
+}
+
+static int aml_segment_cmp(const void *a, const void *b, void *arg) {
+    const struct omen_aml_node *nodes = arg;
+    const struct omen_aml_node *x = &nodes[*(const uint32_t *)a];
+    const struct omen_aml_node *y = &nodes[*(const uint32_t *)b];
+    int c = memcmp(aml_last_segment(x->path), aml_last_segment(y->path), 4);
+    
+    return c ? c : strcmp(x->path, y->path);
+}
+
+static void aml_free_nodes(struct omen_aml_ns *ns) {
+    if (ns->map) {
+        munmap(ns->map, ns->map_size);
+    } else {
+        free(ns->node_buf);
+    }
+    ns->map = NULL;
+    ns->node_buf = NULL;
+    ns->nodes = NULL;
+    ns->by_segment = NULL;
+    ns->node_count = 0;
+}
+
+int omen_aml_build(struct omen_aml_ns *ns, int threads) {
+    struct aml_work work = { .ns = ns };
+    pthread_t tids[64];
+    struct omen_aml_node *nodes;
+    uint32_t *by_segment;
+    uint32_t total = 0, count = 0;
+    int started = 0;
+    
+    if (ns->table_count == 0) {
+        return -ENOENT;
+    }
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > ns->table_count) threads = ns->table_count;
+    if (threads > 64) threads = 64;
+    if (threads < 1) threads = 1;
+    
+    work.parsers = calloc(ns->table_count, sizeof(*work.parsers));
+    if (!work.parsers) {
+        return -ENOMEM;
+    }
+    
+    // The calling thread is worker 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, aml_worker, &work) == 0) {
+            started++;
+        }
+    }
+    aml_worker(&work);
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    
+    ns->checksum = 2166136261u;
+    ns->parse_errors = 0;
+    for (int i = 0; i < ns->table_count; i++) {
+        total += work.parsers[i].count;
+        ns->parse_errors += work.parsers[i].errors;
+        ns->checksum = aml_fnv(ns->tables[i].data, ns->tables[i].length, ns->checksum);
+    }
+    
+    // One allocation: nodes, then the segment order
+    nodes = malloc(total * (sizeof(*nodes) + sizeof(*by_segment)) + 1);
+    if (!nodes) {
+        total = 0;
+    }
+    for (int i = 0; i < ns->table_count; i++) {
+        struct aml_parser *p = &work.parsers[i];
+        
+        if (nodes) {
+            memcpy(nodes + count, p->nodes, sizeof(*nodes) * p->count);
+            count += p->count;
+        }
+        free(p->nodes);
+        free(p->hash);
+    }
+    free(work.parsers);
+    if (!nodes) {
+        return -ENOMEM;
+    }
+    
+    // Keep one node per path
+    qsort(nodes, count, sizeof(*nodes), aml_node_cmp);
+    total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (total == 0 || strcmp(nodes[total - 1].path, nodes[i].path) != 0) {
+            nodes[total++] = nodes[i];
+        }
+    }
+    
+    by_segment = (uint32_t *)(nodes + count);
+    for (uint32_t i = 0; i < total; i++) {
+        by_segment[i] = i;
+    }
+    qsort_r(by_segment, total, sizeof(*by_segment), aml_segment_cmp, nodes);
+    
+    // Close the gap left by duplicates so the buffer matches the file layout
+    memmove(nodes + total, by_segment, total * sizeof(*by_segment));
+    
+    aml_free_nodes(ns);
+    ns->node_buf = nodes;
+    ns->nodes = nodes;
+    ns->by_segment = (const uint32_t *)(nodes + total);
+    ns->node_count = total;
+    return (int)total;
+}
+
+/*
+ * Index file: header, table records, nodes, segment order
+ */
+struct aml_index_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t table_count;
+    uint32_t checksum;
+};
+
+struct aml_index_table {
+    char signature[4];
+    char oem_table_id[8];
+    uint32_t length;
+};
+
+int omen_aml_save_index(const struct omen_aml_ns *ns, const char *path) {
+    struct aml_index_header header = { .version = OMEN_AML_INDEX_VERSION };
+    char tmp[4096];
+    FILE *fp;
+    int ok = 1;
+    
+    if (!ns->nodes) {
+        return -EINVAL;
+    }
+    memcpy(header.magic, OMEN_AML_INDEX_MAGIC, sizeof(header.magic));
+    header.node_count = ns->node_count;
+    header.table_count = (uint32_t)ns->table_count;
+    header.checksum = ns->checksum;
+    
+    // Written aside and renamed, so readers never map half an index
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    fp = fopen(tmp, "wb");
+    if (!fp) {
+        return -errno;
+    }
+    ok &= fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (int i = 0; i < ns->table_count; i++) {
+        struct aml_index_table t;
+        
+        memcpy(t.signature, ns->tables[i].signature, sizeof(t.signature));
+        memcpy(t.oem_table_id, ns->tables[i].oem_table_id, sizeof(t.oem_table_id));
+        t.length = ns->tables[i].length;
+        ok &= fwrite(&t, sizeof(t), 1, fp) == 1;
+    }
+    ok &= fwrite(ns->nodes, sizeof(*ns->nodes), ns->node_count, fp) == ns->node_count;
+    ok &= fwrite(ns->by_segment, sizeof(*ns->by_segment), ns->node_count, fp) == ns->node_count;
+    ok &= fclose(fp) == 0;
+    
+    if (!ok || rename(tmp, path) != 0) {
+        int ret = ok ? -errno : -EIO;
+        
+        unlink(tmp);
+        return ret;
+    }
+    return 0;
+}
+
+int omen_aml_open_index(struct omen_aml_ns *ns, const char *path) {
+    const struct aml_index_header *header;
+    const struct aml_index_table *t;
+    struct stat st;
+    size_t need;
+    void *map;
+    int fd, ret;
+    
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fstat(fd, &st) != 0) {
+        ret = -errno;
+        close(fd);
+        return ret;
+    }
+    if ((size_t)st.st_size < sizeof(*header)) {
+        close(fd);
+        return -EINVAL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -errno;
+    }
+    
+    header = map;
+    need = sizeof(*header) + (size_t)header->table_count * sizeof(*t) +
+           (size_t)header->node_count * (sizeof(struct omen_aml_node) + sizeof(uint32_t));
+    if (memcmp(header->magic, OMEN_AML_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != OMEN_AML_INDEX_VERSION || header->table_count > 0xFFFF ||
+        need != (size_t)st.st_size) {
+        munmap(map, st.st_size);
+        return -EINVAL;
+    }
+    
+    omen_aml_free(ns);
+    ns->tables = calloc(header->table_count ? header->table_count : 1, sizeof(*ns->tables));
+    if (!ns->tables) {
+        munmap(map, st.st_size);
+        return -ENOMEM;
+    }
+    t = (const struct aml_index_table *)(header + 1);
+    for (uint32_t i = 0; i < header->table_count; i++) {
+        memcpy(ns->tables[i].signature, t[i].signature, sizeof(t[i].signature));
+        memcpy(ns->tables[i].oem_table_id, t[i].oem_table_id, sizeof(t[i].oem_table_id));
+        ns->tables[i].length = t[i].length;
+    }
+    ns->table_count = (int)header->table_count;
+    ns->nodes = (const struct omen_aml_node *)(t + header->table_count);
+    ns->by_segment = (const uint32_t *)(ns->nodes + header->node_count);
+    ns->node_count = header->node_count;
+    ns->checksum = header->checksum;
+    ns->map = map;
+    ns->map_size = st.st_size;
+    
+    for (uint32_t i = 0; i < ns->node_count; i++) {
+        if (ns->by_segment[i] >= ns->node_count ||
+            memchr(ns->nodes[i].path, 0, OMEN_AML_PATH_MAX) == NULL) {
+            omen_aml_free(ns);
+            return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+void omen_aml_free(struct omen_aml_ns *ns) {
+    aml_free_nodes(ns);
+    for (int i = 0; i < ns->table_count; i++) {
+        free(ns->tables[i].data);
+    }
+    free(ns->tables);
+    memset(ns, 0, sizeof(*ns));
+}
+
+/*
+ * Lookups
+ */
+const struct omen_aml_node *omen_aml_find_path(const struct omen_aml_ns *ns,
+                                               const char *path) {
+    char key[OMEN_AML_PATH_MAX];
+    uint32_t lo = 0, hi = ns->node_count;
+    
+    if (omen_aml_normalize_path(path, key, sizeof(key))) {
+        return NULL;
+    }
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(ns->nodes[mid].path, key);
+        
+        if (c == 0) {
+            return &ns->nodes[mid];
+        }
+        if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+int omen_aml_find_segment(const struct omen_aml_ns *ns, const char *segment,
+                          const struct omen_aml_node **out, int max) {
+    char key[8];
+    uint32_t lo = 0, hi = ns->node_count;
+    int found = 0;
+    
+    if (strchr(segment, '.') || omen_aml_normalize_path(segment, key, sizeof(key))) {
+        return -EINVAL;
+    }
+    
+    // Lower bound on "\\XXXX" + 1, the padded segment
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        
+        if (memcmp(aml_last_segment(ns->nodes[ns->by_segment[mid]].path), key + 1, 4) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < ns->node_count; lo++) {
+        const struct omen_aml_node *node = &ns->nodes[ns->by_segment[lo]];
+        
+        if (memcmp(aml_last_segment(node->path), key + 1, 4) != 0) {
+            break;
+        }
+        if (found < max) {
+            out[found] = node;
+        }
+        found++;
+    }
+    return found;
+}
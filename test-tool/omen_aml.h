@@ -0,0 +1,152 @@
+/*
+ * OMEN AML Namespace Library
+ *
+ * Loads the DSDT and SSDTs from an acpidump text dump (or raw table
+ * binaries), walks the AML of every table and records each named object
+ * with its full path, type and location. Method bodies are skipped by
+ * PkgLength, so the whole namespace is built without executing anything.
+ * Tables are walked in parallel, one worker per CPU.
+ *
+ * The result can be saved as an index: nodes sorted by path plus a second
+ * order by last name segment, so "where is WMAA" is a binary search on a
+ * mapped file instead of a firmware call.
+ *
+ * All functions return 0 (or a positive count) on success and -errno on
+ * failure. Nothing here prints; callers decide how to report errors.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#ifndef OMEN_AML_H
+#define OMEN_AML_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMEN_AML_PATH_MAX       128     // "\\_SB_.PCI0.LPCB.EC0_.KBCL" and deeper
+#define OMEN_AML_HEADER_SIZE    36      // Standard ACPI table header
+#define OMEN_AML_INDEX_MAGIC    "OMENAMLI"
+#define OMEN_AML_INDEX_VERSION  1
+#define OMEN_AML_MAX_ARGS       7
+
+enum omen_aml_type {
+    OMEN_AML_DEVICE = 1,
+    OMEN_AML_METHOD,
+    OMEN_AML_NAME,
+    OMEN_AML_REGION,            // OperationRegion
+    OMEN_AML_FIELD,             // Field, IndexField or BankField unit
+    OMEN_AML_BUFFER_FIELD,      // CreateXxxField outside a method
+    OMEN_AML_MUTEX,
+    OMEN_AML_EVENT,
+    OMEN_AML_PROCESSOR,
+    OMEN_AML_POWER,             // PowerResource
+    OMEN_AML_THERMAL,           // ThermalZone
+    OMEN_AML_ALIAS,
+    OMEN_AML_DATA_REGION,
+    OMEN_AML_EXTERNAL,          // Declared here, defined in another table
+    OMEN_AML_TYPES
+};
+
+struct omen_aml_table {
+    char signature[5];          // "DSDT", "SSDT"
+    char oem_table_id[9];
+    uint32_t length;
+    uint8_t *data;              // Whole table, header included; NULL from an index
+};
+
+/*
+ * One named object. Fixed size, so the index file is an array of these.
+ * Paths always use full 4-character segments: "\\_SB_.WMID.WMAA".
+ *
+ *   METHOD    args = argument count, flags = MethodFlags,
+ *             body/length = AML byte range of the body
+ *   EXTERNAL  args = argument count, flags = ObjectType
+ *   REGION    flags = address space, body/length = offset and size when
+ *             both are constants
+ *   FIELD     body = bit offset in the region, length = width in bits
+ */
+struct omen_aml_node {
+    char path[OMEN_AML_PATH_MAX];
+    uint8_t type;               // enum omen_aml_type
+    uint8_t args;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t table;             // Index into omen_aml_ns.tables
+    uint16_t reserved2;
+    uint32_t offset;            // Opcode offset in the table
+    uint32_t body;
+    uint32_t length;
+};
+
+/*
+ * Argument shapes of a method, inferred from its body: which arguments it
+ * indexes as buffers (CreateXxxField, Index) and the smallest buffer every
+ * constant offset fits in. A smaller buffer fails with AE_AML_BUFFER_LIMIT
+ * no matter how often the call is retried.
+ */
+#define OMEN_AML_ARG_BUFFER     0x01    // Indexed as a buffer
+#define OMEN_AML_ARG_VARIABLE   0x02    // Some offset or width is computed at run time
+
+struct omen_aml_signature {
+    const struct omen_aml_node *method;
+    uint8_t args;
+    uint8_t arg_flags[OMEN_AML_MAX_ARGS];
+    uint32_t arg_size[OMEN_AML_MAX_ARGS];
+};
+
+struct omen_aml_ns {
+    struct omen_aml_table *tables;
+    int table_count;
+    const struct omen_aml_node *nodes;  // Sorted by path
+    uint32_t node_count;
+    const uint32_t *by_segment;         // Node indices sorted by last segment
+    uint32_t checksum;                  // Of all table bytes, detects stale indexes
+    int parse_errors;                   // Blocks skipped on unknown opcodes
+    
+    // Private
+    void *node_buf;
+    void *map;
+    size_t map_size;
+};
+
+// Loading - text dumps and raw tables may be mixed, call once per file
+int omen_aml_load(struct omen_aml_ns *ns, const char *path);
+
+// Walk every loaded table; threads <= 0 uses one per online CPU
+int omen_aml_build(struct omen_aml_ns *ns, int threads);
+
+// Index files
+int omen_aml_save_index(const struct omen_aml_ns *ns, const char *path);
+int omen_aml_open_index(struct omen_aml_ns *ns, const char *path);
+
+void omen_aml_free(struct omen_aml_ns *ns);
+
+/*
+ * Follows calls that pass arguments on (WMAA -> WHCM), so the shape is that
+ * of the whole call tree. Needs the tables loaded, not just an index.
+ * Returns the number of body blocks that could not be walked.
+ */
+int omen_aml_infer_signature(const struct omen_aml_ns *ns, const struct omen_aml_node *method,
+                             struct omen_aml_signature *sig);
+
+// Lookups - paths may use short segments ("\\_SB.WMID.WMAA")
+const struct omen_aml_node *omen_aml_find_path(const struct omen_aml_ns *ns,
+                                               const char *path);
+int omen_aml_find_segment(const struct omen_aml_ns *ns, const char *segment,
+                          const struct omen_aml_node **out, int max);
+
+// Path helpers
+int omen_aml_normalize_path(const char *in, char *out, size_t size);
+void omen_aml_display_path(const char *path, char *out, size_t size);
+const char *omen_aml_type_name(int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OMEN_AML_H */
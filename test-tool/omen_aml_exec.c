@@ -0,0 +1,3083 @@
+/*
+ * OMEN AML Sandbox - a subset AML interpreter with emulated regions
+ *
+ * Terms are evaluated straight from the table bytes; there is no parse
+ * tree. Objects are reference counted. Integers are never changed in
+ * place, buffers and packages are (Index, CreateXxxField), so a buffer
+ * passed to a method is shared with the caller the way ACPICA does it.
+ *
+ * Field units are accessed a byte at a time, whatever their AccessType:
+ * the EC only has byte access anyway, and the counts below are then EC
+ * transactions. Partial bytes follow the field's update rule.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+
+#include "omen_aml_exec.h"
+
+#define EX_HASH_SIZE        16384
+#define EX_MAX_DEPTH        48          // Nested method calls
+#define EX_STEP_LIMIT       20000000    // Terms per call
+#define EX_PAGE_SIZE        256         // Sparse memory granule
+
+// ACPI object types, as ObjectType() reports them
+enum ex_type {
+    EX_UNINIT = 0,
+    EX_INT = 1,
+    EX_STR = 2,
+    EX_BUF = 3,
+    EX_PKG = 4,
+    EX_FIELD = 5,
+    EX_DEVICE = 6,
+    EX_EVENT = 7,
+    EX_METHOD = 8,
+    EX_MUTEX = 9,
+    EX_REGION = 10,
+    EX_POWER = 11,
+    EX_PROCESSOR = 12,
+    EX_THERMAL = 13,
+    EX_BFIELD = 14,
+    EX_DEBUG = 16,
+    EX_REF = 20,                // RefOf/Index result
+};
+
+enum ex_ref_kind {
+    EX_TO_NONE = 0,
+    EX_TO_LOCAL,
+    EX_TO_ARG,
+    EX_TO_NODE,
+    EX_TO_INDEX,
+    EX_TO_DEBUG,
+};
+
+enum ex_field_kind {
+    EX_FIELD_REGION = 0,
+    EX_FIELD_INDEX,
+    EX_FIELD_BANK,
+};
+
+enum ex_flow {
+    EX_FLOW_NONE = 0,
+    EX_FLOW_RETURN,
+    EX_FLOW_BREAK,
+    EX_FLOW_CONTINUE,
+};
+
+enum ex_native {
+    EX_NATIVE_NONE = 0,
+    EX_NATIVE_OSI,
+};
+
+struct ex_node;
+
+struct ex_obj {
+    int refs;
+    uint8_t type;
+    union {
+        uint64_t integer;
+        struct {
+            uint8_t *data;      // Strings keep a trailing NUL
+            uint32_t length;
+        } buf;
+        struct {
+            struct ex_obj **items;
+            uint32_t count;
+        } pkg;
+        struct {
+            uint8_t kind;       // enum ex_field_kind
+            uint8_t flags;      // FieldFlags: access type, update rule
+            struct ex_node *region;
+            struct ex_node *index, *data;       // IndexField registers
+            struct ex_node *bank;               // BankField register
+            uint64_t bank_value;
+            uint32_t bit, bits;
+        } field;
+        struct {
+            struct ex_obj *source;
+            uint32_t bit, bits;
+        } bfield;
+        struct {
+            const uint8_t *aml;
+            uint32_t start, end, size;
+            uint8_t args;
+            uint8_t native;     // enum ex_native
+            uint8_t int_bits;
+            uint16_t table;
+        } method;
+        struct {
+            uint8_t space;
+            uint64_t base, length;
+        } region;
+        struct {
+            uint8_t kind;       // enum ex_ref_kind, NODE or INDEX
+            struct ex_node *node;
+            struct ex_obj *container;
+            uint32_t index;
+        } ref;
+    };
+};
+
+struct ex_node {
+    char path[OMEN_AML_PATH_MAX];
+    struct ex_obj *obj;
+    struct ex_node *next;       // Hash chain
+};
+
+struct ex_name {
+    int root;
+    int up;
+    int count;
+    const uint8_t *segments;
+};
+
+// Where a Store goes
+struct ex_target {
+    int kind;                   // enum ex_ref_kind
+    struct ex_obj **slot;       // LocalX/ArgX
+    struct ex_node *node;
+    struct ex_obj *container;   // Referenced while the target lives
+    uint32_t index;
+};
+
+struct ex_frame {
+    struct ex_node *method;
+    struct ex_obj *args[OMEN_AML_MAX_ARGS];
+    struct ex_obj *locals[8];
+};
+
+struct ex_page {
+    uint8_t space;
+    uint64_t base;
+    uint8_t data[EX_PAGE_SIZE];
+};
+
+struct omen_aml_sandbox {
+    const struct omen_aml_ns *ns;
+    
+    struct ex_node **hash;
+    struct ex_node **nodes;     // Creation order
+    uint32_t node_count, node_capacity;
+    
+    uint8_t ec[OMEN_AML_EC_SIZE];
+    const char *ec_fields[OMEN_AML_EC_SIZE];
+    uint64_t ec_window;         // SystemMemory address of EC RAM, 0 if none
+    struct ex_page *pages;
+    uint32_t page_count, page_capacity;
+    
+    // Code being executed
+    const uint8_t *aml;
+    uint32_t size;
+    uint32_t list_end;          // End of the current term list, bounds Else
+    uint16_t table;
+    uint8_t int_bits;           // 32 for revision 1 tables
+    struct ex_frame *frame;
+    int depth;
+    int loading;
+    int flow;
+    struct ex_obj *retval;
+    const char *field;          // Field unit being accessed, for events
+    
+    int error;
+    char message[256];
+    
+    uint64_t clock_ns;
+    uint64_t ec_latency_ns;
+    struct omen_aml_stats stats;
+    struct omen_aml_event *events;
+    int event_count;
+    struct ex_obj *result;
+};
+
+static struct ex_obj *ex_eval(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope);
+static void ex_exec_list(struct omen_aml_sandbox *s, uint32_t pos, uint32_t end,
+                         const char *scope);
+static int ex_store(struct omen_aml_sandbox *s, struct ex_obj *value, struct ex_target *t,
+                    uint32_t at);
+static struct ex_obj *ex_call(struct omen_aml_sandbox *s, struct ex_node *method,
+                              struct ex_obj **args, int count);
+
+static uint64_t ex_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Errors - the first one wins and unwinds everything
+ */
+static void ex_fail(struct omen_aml_sandbox *s, uint32_t at, int err, const char *status,
+                    const char *detail) {
+    char where[OMEN_AML_PATH_MAX];
+    
+    if (s->error) {
+        return;
+    }
+    s->error = err;
+    if (s->frame) {
+        omen_aml_display_path(s->frame->method->path, where, sizeof(where));
+    } else {
+        snprintf(where, sizeof(where), "definition block");
+    }
+    snprintf(s->message, sizeof(s->message), "%s%s%s%s in %s at %s+0x%x", status,
+             detail ? " (" : "", detail ? detail : "", detail ? ")" : "", where,
+             s->ns->tables[s->table].signature, at);
+}
+
+static uint32_t ex_overrun(struct omen_aml_sandbox *s, uint32_t at) {
+    ex_fail(s, at, -EINVAL, "AE_AML_BAD_OPCODE", "truncated term");
+    return s->size;
+}
+
+static void ex_event(struct omen_aml_sandbox *s, int type, const char *path, uint64_t address,
+                     uint64_t value, uint8_t old_value, uint8_t space) {
+    struct omen_aml_event *e;
+    
+    if (s->loading) {
+        return;
+    }
+    if (s->event_count >= OMEN_AML_MAX_EVENTS) {
+        s->stats.events_dropped++;
+        return;
+    }
+    e = &s->events[s->event_count++];
+    e->type = (uint8_t)type;
+    e->depth = (uint8_t)s->depth;
+    e->space = space;
+    e->old_value = old_value;
+    e->address = address;
+    e->value = value;
+    e->time_ns = s->clock_ns;
+    e->path = path;
+}
+
+/*
+ * Objects
+ */
+static struct ex_obj *ex_new(struct omen_aml_sandbox *s, int type) {
+    struct ex_obj *o = calloc(1, sizeof(*o));
+    
+    if (!o) {
+        ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return NULL;
+    }
+    o->refs = 1;
+    o->type = (uint8_t)type;
+    return o;
+}
+
+static struct ex_obj *ex_get(struct ex_obj *o) {
+    if (o) {
+        o->refs++;
+    }
+    return o;
+}
+
+static void ex_put(struct ex_obj *o) {
+    if (!o || --o->refs > 0) {
+        return;
+    }
+    switch (o->type) {
+    case EX_STR:
+    case EX_BUF:
+        free(o->buf.data);
+        break;
+    case EX_PKG:
+        for (uint32_t i = 0; i < o->pkg.count; i++) {
+            ex_put(o->pkg.items[i]);
+        }
+        free(o->pkg.items);
+        break;
+    case EX_BFIELD:
+        ex_put(o->bfield.source);
+        break;
+    case EX_REF:
+        ex_put(o->ref.container);
+        break;
+    }
+    free(o);
+}
+
+static struct ex_obj *ex_int(struct omen_aml_sandbox *s, uint64_t value) {
+    struct ex_obj *o = ex_new(s, EX_INT);
+    
+    if (o) {
+        o->integer = s->int_bits == 32 ? value & 0xFFFFFFFFu : value;
+    }
+    return o;
+}
+
+// Buffer or string of length bytes, zeroed unless data is given
+static struct ex_obj *ex_bytes_obj(struct omen_aml_sandbox *s, int type, const void *data,
+                                   uint32_t length) {
+    struct ex_obj *o = ex_new(s, type);
+    
+    if (!o) {
+        return NULL;
+    }
+    o->buf.data = calloc(1, (size_t)length + 1);
+    if (!o->buf.data) {
+        free(o);
+        ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return NULL;
+    }
+    if (data) {
+        memcpy(o->buf.data, data, length);
+    }
+    o->buf.length = length;
+    return o;
+}
+
+static struct ex_obj *ex_pkg(struct omen_aml_sandbox *s, uint32_t count) {
+    struct ex_obj *o = ex_new(s, EX_PKG);
+    
+    if (!o) {
+        return NULL;
+    }
+    o->pkg.items = calloc(count ? count : 1, sizeof(*o->pkg.items));
+    if (!o->pkg.items) {
+        free(o);
+        ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return NULL;
+    }
+    o->pkg.count = count;
+    return o;
+}
+
+// Data objects are copied on Store, everything else is shared
+static struct ex_obj *ex_copy(struct omen_aml_sandbox *s, struct ex_obj *o) {
+    struct ex_obj *c;
+    
+    switch (o->type) {
+    case EX_INT:
+        c = ex_new(s, EX_INT);
+        if (c) {
+            c->integer = o->integer;
+        }
+        return c;
+    case EX_STR:
+    case EX_BUF:
+        return ex_bytes_obj(s, o->type, o->buf.data, o->buf.length);
+    case EX_PKG:
+        c = ex_pkg(s, o->pkg.count);
+        for (uint32_t i = 0; c && i < o->pkg.count; i++) {
+            c->pkg.items[i] = o->pkg.items[i] ? ex_copy(s, o->pkg.items[i]) : NULL;
+        }
+        return c;
+    default:
+        return ex_get(o);
+    }
+}
+
+/*
+ * Namespace
+ */
+static uint32_t ex_hash(const char *path) {
+    uint32_t h = 2166136261u;
+    
+    while (*path) {
+        h ^= (uint8_t)*path++;
+        h *= 16777619u;
+    }
+    return h & (EX_HASH_SIZE - 1);
+}
+
+static struct ex_node *ex_find(struct omen_aml_sandbox *s, const char *path) {
+    for (struct ex_node *n = s->hash[ex_hash(path)]; n; n = n->next) {
+        if (strcmp(n->path, path) == 0) {
+            return n;
+        }
+    }
+    return NULL;
+}
+
+static struct ex_node *ex_node(struct omen_aml_sandbox *s, const char *path) {
+    struct ex_node *n = ex_find(s, path);
+    uint32_t h;
+    
+    if (n) {
+        return n;
+    }
+    if (s->node_count == s->node_capacity) {
+        uint32_t capacity = s->node_capacity ? s->node_capacity * 2 : 1024;
+        struct ex_node **nodes = realloc(s->nodes, sizeof(*nodes) * capacity);
+        
+        if (!nodes) {
+            ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+            return NULL;
+        }
+        s->nodes = nodes;
+        s->node_capacity = capacity;
+    }
+    n = calloc(1, sizeof(*n));
+    if (!n) {
+        ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return NULL;
+    }
+    snprintf(n->path, sizeof(n->path), "%s", path);
+    h = ex_hash(path);
+    n->next = s->hash[h];
+    s->hash[h] = n;
+    s->nodes[s->node_count++] = n;
+    return n;
+}
+
+static int ex_name_start(uint8_t c) {
+    return c == '\\' || c == '^' || c == 0x2E || c == 0x2F || c == '_' ||
+           (c >= 'A' && c <= 'Z');
+}
+
+static uint32_t ex_name_string(struct omen_aml_sandbox *s, uint32_t pos, struct ex_name *name) {
+    uint32_t at = pos;
+    
+    memset(name, 0, sizeof(*name));
+    if (pos < s->size && s->aml[pos] == '\\') {
+        name->root = 1;
+        pos++;
+    } else {
+        while (pos < s->size && s->aml[pos] == '^') {
+            name->up++;
+            pos++;
+        }
+    }
+    if (pos >= s->size) {
+        return ex_overrun(s, at);
+    }
+    
+    switch (s->aml[pos]) {
+    case 0x00:                  // NullName
+        return pos + 1;
+    case 0x2E:                  // DualNamePrefix
+        name->count = 2;
+        pos++;
+        break;
+    case 0x2F:                  // MultiNamePrefix
+        if (pos + 1 >= s->size) {
+            return ex_overrun(s, at);
+        }
+        name->count = s->aml[pos + 1];
+        pos += 2;
+        break;
+    default:
+        name->count = 1;
+        break;
+    }
+    if (pos + 4 * (uint32_t)name->count > s->size) {
+        return ex_overrun(s, at);
+    }
+    name->segments = &s->aml[pos];
+    return pos + 4 * name->count;
+}
+
+static int ex_join(const char *scope, const struct ex_name *name, char *out) {
+    size_t len;
+    
+    if (name->root) {
+        strcpy(out, "\\");
+    } else {
+        strcpy(out, scope);
+        for (int i = 0; i < name->up; i++) {
+            char *dot = strrchr(out, '.');
+            
+            if (dot) {
+                *dot = '\0';
+            } else if (strlen(out) > 1) {
+                out[1] = '\0';
+            } else {
+                return -EINVAL;
+            }
+        }
+    }
+    
+    len = strlen(out);
+    for (int i = 0; i < name->count; i++) {
+        if (len + 6 > OMEN_AML_PATH_MAX) {
+            return -ENAMETOOLONG;
+        }
+        if (len > 1) {
+            out[len++] = '.';
+        }
+        memcpy(out + len, name->segments + 4 * i, 4);
+        len += 4;
+        out[len] = '\0';
+    }
+    return 0;
+}
+
+// ACPI search rules: single segments are looked up towards the root
+static struct ex_node *ex_resolve(struct omen_aml_sandbox *s, const char *scope,
+                                  const struct ex_name *name) {
+    char path[OMEN_AML_PATH_MAX], base[OMEN_AML_PATH_MAX];
+    
+    if (name->count == 0) {
+        return NULL;
+    }
+    strcpy(base, scope);
+    for (;;) {
+        if (ex_join(base, name, path) == 0) {
+            struct ex_node *n = ex_find(s, path);
+            
+            if (n && n->obj) {
+                return n;
+            }
+        }
+        if (name->root || name->up || name->count > 1 || strcmp(base, "\\") == 0) {
+            return NULL;
+        }
+        char *dot = strrchr(base, '.');
+        
+        if (dot) {
+            *dot = '\0';
+        } else {
+            base[1] = '\0';
+        }
+    }
+}
+
+// The name as written: "^^^GPP0.VGA.AFN2"
+static void ex_name_text(const struct ex_name *name, char *out, size_t size) {
+    char raw[OMEN_AML_PATH_MAX];
+    size_t len = 0;
+    size_t prefix = 0;
+    
+    if (size == 0) {
+        return;
+    }
+    for (int i = 0; i < name->up && prefix + 1 < size; i++) {
+        out[prefix++] = '^';
+    }
+    if (name->root && prefix + 1 < size) {
+        out[prefix++] = '\\';
+    }
+    for (int i = 0; i < name->count && len + 6 < sizeof(raw); i++) {
+        if (i) {
+            raw[len++] = '.';
+        }
+        memcpy(raw + len, name->segments + 4 * i, 4);
+        len += 4;
+    }
+    raw[len] = '\0';
+    omen_aml_display_path(raw, out + prefix, size - prefix);
+}
+
+static void ex_not_found(struct omen_aml_sandbox *s, uint32_t at, const struct ex_name *name) {
+    char text[OMEN_AML_PATH_MAX];
+    
+    ex_name_text(name, text, sizeof(text));
+    ex_fail(s, at, -ENOENT, "AE_NOT_FOUND", text);
+}
+
+// Defines a named object; takes over obj
+static struct ex_node *ex_define(struct omen_aml_sandbox *s, const char *scope,
+                                 const struct ex_name *name, struct ex_obj *obj) {
+    char path[OMEN_AML_PATH_MAX];
+    struct ex_node *n;
+    
+    if (!obj) {
+        return NULL;
+    }
+    if (name->count == 0 || ex_join(scope, name, path)) {
+        ex_put(obj);
+        return NULL;
+    }
+    n = ex_node(s, path);
+    if (!n) {
+        ex_put(obj);
+        return NULL;
+    }
+    ex_put(n->obj);
+    n->obj = obj;
+    return n;
+}
+
+/*
+ * Encoding helpers
+ */
+static uint32_t ex_pkg_value(struct omen_aml_sandbox *s, uint32_t pos, uint32_t *value) {
+    int count;
+    
+    if (pos >= s->size) {
+        return ex_overrun(s, pos);
+    }
+    count = s->aml[pos] >> 6;
+    if (pos + 1 + count > s->size) {
+        return ex_overrun(s, pos);
+    }
+    if (count == 0) {
+        *value = s->aml[pos] & 0x3F;
+    } else {
+        *value = s->aml[pos] & 0x0F;
+        for (int i = 0; i < count; i++) {
+            *value |= (uint32_t)s->aml[pos + 1 + i] << (4 + 8 * i);
+        }
+    }
+    return pos + 1 + count;
+}
+
+// PkgLength at pos; returns the first byte after it and sets the package end
+static uint32_t ex_pkg_length(struct omen_aml_sandbox *s, uint32_t pos, uint32_t *end) {
+    uint32_t value = 0, next = ex_pkg_value(s, pos, &value);
+    
+    *end = pos + value;
+    if (!s->error && (*end > s->size || *end < next)) {
+        *end = s->size;
+        return ex_overrun(s, pos);
+    }
+    return next;
+}
+
+/*
+ * Conversions
+ */
+static int ex_to_int(struct omen_aml_sandbox *s, struct ex_obj *o, uint64_t *value, uint32_t at);
+
+static struct ex_obj *ex_ref_read(struct omen_aml_sandbox *s, struct ex_obj *ref, uint32_t at);
+
+static int ex_to_int(struct omen_aml_sandbox *s, struct ex_obj *o, uint64_t *value, uint32_t at) {
+    uint32_t bytes = s->int_bits / 8;
+    
+    *value = 0;
+    switch (o->type) {
+    case EX_INT:
+        *value = o->integer;
+        return 0;
+    case EX_BUF:
+        for (uint32_t i = 0; i < o->buf.length && i < bytes; i++) {
+            *value |= (uint64_t)o->buf.data[i] << (8 * i);
+        }
+        return 0;
+    case EX_STR: {
+        const char *p = (const char *)o->buf.data;
+        
+        // Implicit conversion reads hex digits
+        if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            p += 2;
+        }
+        for (int n = 0; isxdigit((unsigned char)*p) && n < (int)bytes * 2; p++, n++) {
+            *value = *value << 4 |
+                     (uint64_t)(isdigit((unsigned char)*p) ? *p - '0' : (tolower(*p) - 'a' + 10));
+        }
+        return 0;
+    }
+    case EX_REF: {
+        struct ex_obj *target = ex_ref_read(s, o, at);
+        int ret;
+        
+        if (!target) {
+            return -1;
+        }
+        ret = ex_to_int(s, target, value, at);
+        ex_put(target);
+        return ret;
+    }
+    }
+    ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "integer expected");
+    return -1;
+}
+
+// Byte view of a data object; integers go through tmp
+static int ex_view(struct omen_aml_sandbox *s, struct ex_obj *o, uint8_t tmp[8],
+                   const uint8_t **data, uint32_t *length, uint32_t at) {
+    switch (o->type) {
+    case EX_INT:
+        for (int i = 0; i < 8; i++) {
+            tmp[i] = (uint8_t)(o->integer >> (8 * i));
+        }
+        *data = tmp;
+        *length = s->int_bits / 8;
+        return 0;
+    case EX_STR:
+    case EX_BUF:
+        *data = o->buf.data;
+        *length = o->buf.length;
+        return 0;
+    }
+    ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "data object expected");
+    return -1;
+}
+
+static struct ex_obj *ex_to_buffer(struct omen_aml_sandbox *s, struct ex_obj *o, uint32_t at) {
+    const uint8_t *data;
+    uint32_t length;
+    uint8_t tmp[8];
+    
+    if (ex_view(s, o, tmp, &data, &length, at)) {
+        return NULL;
+    }
+    return ex_bytes_obj(s, EX_BUF, data, length);
+}
+
+// Implicit conversion to string: integers in hex, buffers as hex bytes
+static struct ex_obj *ex_to_string(struct omen_aml_sandbox *s, struct ex_obj *o, uint32_t at) {
+    struct ex_obj *r;
+    char text[20];
+    
+    switch (o->type) {
+    case EX_STR:
+        return ex_get(o);
+    case EX_INT:
+        snprintf(text, sizeof(text), "%0*llX", s->int_bits / 4, (unsigned long long)o->integer);
+        return ex_bytes_obj(s, EX_STR, text, (uint32_t)strlen(text));
+    case EX_BUF:
+        r = ex_bytes_obj(s, EX_STR, NULL, o->buf.length ? o->buf.length * 3 - 1 : 0);
+        for (uint32_t i = 0; r && i < o->buf.length; i++) {
+            snprintf(text, sizeof(text), "%02X", o->buf.data[i]);
+            memcpy(r->buf.data + i * 3, text, 2);
+            if (i + 1 < o->buf.length) {
+                r->buf.data[i * 3 + 2] = ' ';
+            }
+        }
+        return r;
+    }
+    ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "string expected");
+    return NULL;
+}
+
+static void ex_bits_get(const uint8_t *src, uint32_t bit, uint32_t bits, uint8_t *dst) {
+    for (uint32_t i = 0; i < bits; i++) {
+        if (src[(bit + i) / 8] >> ((bit + i) % 8) & 1) {
+            dst[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+}
+
+static void ex_bits_put(uint8_t *dst, uint32_t bit, uint32_t bits, const uint8_t *src,
+                        uint32_t length) {
+    for (uint32_t i = 0; i < bits; i++) {
+        uint32_t d = bit + i;
+        int v = i / 8 < length ? src[i / 8] >> (i % 8) & 1 : 0;
+        
+        dst[d / 8] = (uint8_t)((dst[d / 8] & ~(1 << (d % 8))) | (v << (d % 8)));
+    }
+}
+
+// Field and buffer field values are integers when they fit
+static struct ex_obj *ex_bits_obj(struct omen_aml_sandbox *s, const uint8_t *data, uint32_t bits) {
+    struct ex_obj *o;
+    
+    if (bits > s->int_bits) {
+        return ex_bytes_obj(s, EX_BUF, data, (bits + 7) / 8);
+    }
+    o = ex_new(s, EX_INT);
+    for (uint32_t i = 0; o && i < (bits + 7) / 8; i++) {
+        o->integer |= (uint64_t)data[i] << (8 * i);
+    }
+    return o;
+}
+
+/*
+ * Address spaces
+ */
+static uint8_t *ex_memory(struct omen_aml_sandbox *s, uint8_t space, uint64_t address,
+                          int create) {
+    uint64_t base = address & ~(uint64_t)(EX_PAGE_SIZE - 1);
+    
+    for (uint32_t i = s->page_count; i-- > 0;) {
+        if (s->pages[i].base == base && s->pages[i].space == space) {
+            return &s->pages[i].data[address - base];
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    if (s->page_count == s->page_capacity) {
+        uint32_t capacity = s->page_capacity ? s->page_capacity * 2 : 64;
+        struct ex_page *pages = realloc(s->pages, sizeof(*pages) * capacity);
+        
+        if (!pages) {
+            ex_fail(s, 0, -ENOMEM, "AE_NO_MEMORY", NULL);
+            return NULL;
+        }
+        s->pages = pages;
+        s->page_capacity = capacity;
+    }
+    memset(&s->pages[s->page_count], 0, sizeof(s->pages[0]));
+    s->pages[s->page_count].space = space;
+    s->pages[s->page_count].base = base;
+    return &s->pages[s->page_count++].data[address - base];
+}
+
+static int ex_region_access(struct omen_aml_sandbox *s, struct ex_node *region, uint64_t byte,
+                            uint8_t *value, int write, uint32_t at) {
+    struct ex_obj *r = region->obj;
+    uint64_t address;
+    
+    if (!r || r->type != EX_REGION) {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "field without a region");
+        return -1;
+    }
+    if (byte >= r->region.length) {
+        ex_fail(s, at, -ERANGE, "AE_AML_REGION_LIMIT", region->path);
+        return -1;
+    }
+    address = r->region.base + byte;
+    
+    if (r->region.space == 3 || (r->region.space == 0 && s->ec_window &&
+                                 address - s->ec_window < OMEN_AML_EC_SIZE)) {
+        uint8_t offset = (uint8_t)(r->region.space == 3 ? address : address - s->ec_window);
+        
+        s->clock_ns += s->ec_latency_ns;
+        s->stats.ec_ns += s->ec_latency_ns;
+        if (write) {
+            uint8_t old = s->ec[offset];
+            
+            s->ec[offset] = *value;
+            s->stats.ec_writes++;
+            ex_event(s, OMEN_AML_EVENT_EC_WRITE, s->field, offset, *value, old, 3);
+        } else {
+            *value = s->ec[offset];
+            s->stats.ec_reads++;
+            ex_event(s, OMEN_AML_EVENT_EC_READ, s->field, offset, *value, 0, 3);
+        }
+        return 0;
+    }
+    
+    if (write) {
+        uint8_t *p = ex_memory(s, r->region.space, address, 1);
+        
+        if (!p) {
+            return -1;
+        }
+        s->stats.io_writes++;
+        ex_event(s, OMEN_AML_EVENT_IO_WRITE, s->field, address, *value, *p, r->region.space);
+        *p = *value;
+    } else {
+        uint8_t *p = ex_memory(s, r->region.space, address, 0);
+        
+        s->stats.io_reads++;
+        *value = p ? *p : 0;
+    }
+    return 0;
+}
+
+static int ex_field_unit(struct omen_aml_sandbox *s, struct ex_obj *f, uint32_t byte,
+                         uint8_t *value, int write, uint32_t at);
+
+static int ex_store_node(struct omen_aml_sandbox *s, struct ex_obj *value, struct ex_node *node,
+                         uint32_t at);
+
+static struct ex_obj *ex_field_read(struct omen_aml_sandbox *s, struct ex_node *node,
+                                    uint32_t at) {
+    struct ex_obj *f = node->obj, *r = NULL;
+    uint32_t first = f->field.bit / 8, n, bytes = (f->field.bits + 7) / 8;
+    uint8_t *raw, *out;
+    const char *field = s->field;
+    
+    if (!f->field.bits) {
+        return ex_int(s, 0);
+    }
+    n = (f->field.bit + f->field.bits - 1) / 8 - first + 1;
+    raw = calloc(n, 1);
+    out = calloc(bytes, 1);
+    if (!raw || !out) {
+        ex_fail(s, at, -ENOMEM, "AE_NO_MEMORY", NULL);
+    }
+    
+    s->field = node->path;
+    for (uint32_t i = 0; raw && out && i < n && !s->error; i++) {
+        ex_field_unit(s, f, first + i, &raw[i], 0, at);
+    }
+    s->field = field;
+    if (!s->error) {
+        ex_bits_get(raw, f->field.bit % 8, f->field.bits, out);
+        r = ex_bits_obj(s, out, f->field.bits);
+    }
+    free(raw);
+    free(out);
+    return r;
+}
+
+static int ex_field_write(struct omen_aml_sandbox *s, struct ex_node *node, struct ex_obj *value,
+                          uint32_t at) {
+    struct ex_obj *f = node->obj;
+    uint32_t first = f->field.bit / 8, n, length, tail;
+    const uint8_t *data;
+    const char *field = s->field;
+    uint8_t tmp[8], *raw;
+    int update = (f->field.flags >> 5) & 3;
+    
+    if (!f->field.bits) {
+        return 0;
+    }
+    if (ex_view(s, value, tmp, &data, &length, at)) {
+        return -1;
+    }
+    n = (f->field.bit + f->field.bits - 1) / 8 - first + 1;
+    tail = (f->field.bit + f->field.bits) % 8;
+    raw = calloc(n, 1);
+    if (!raw) {
+        ex_fail(s, at, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return -1;
+    }
+    
+    // Bytes the field only partly covers follow the update rule
+    s->field = node->path;
+    for (uint32_t i = 0; i < n && !s->error; i++) {
+        if (!((i == 0 && f->field.bit % 8) || (i == n - 1 && tail))) {
+            continue;
+        }
+        if (update == 1) {
+            raw[i] = 0xFF;      // WriteAsOnes
+        } else if (update == 0) {
+            ex_field_unit(s, f, first + i, &raw[i], 0, at);
+        }
+    }
+    ex_bits_put(raw, f->field.bit % 8, f->field.bits, data, length);
+    for (uint32_t i = 0; i < n && !s->error; i++) {
+        ex_field_unit(s, f, first + i, &raw[i], 1, at);
+    }
+    s->field = field;
+    free(raw);
+    return s->error ? -1 : 0;
+}
+
+// One byte of a field unit, through its region or index/data pair
+static int ex_field_unit(struct omen_aml_sandbox *s, struct ex_obj *f, uint32_t byte,
+                         uint8_t *value, int write, uint32_t at) {
+    struct ex_obj *tmp;
+    uint64_t v;
+    int ret;
+    
+    switch (f->field.kind) {
+    case EX_FIELD_BANK:
+        tmp = ex_int(s, f->field.bank_value);
+        ret = tmp ? ex_store_node(s, tmp, f->field.bank, at) : -1;
+        ex_put(tmp);
+        if (ret) {
+            return ret;
+        }
+        // Fall through
+    case EX_FIELD_REGION:
+        return ex_region_access(s, f->field.region, byte, value, write, at);
+    case EX_FIELD_INDEX:
+        tmp = ex_int(s, byte);
+        ret = tmp ? ex_store_node(s, tmp, f->field.index, at) : -1;
+        ex_put(tmp);
+        if (ret) {
+            return ret;
+        }
+        if (write) {
+            tmp = ex_int(s, *value);
+            ret = tmp ? ex_store_node(s, tmp, f->field.data, at) : -1;
+            ex_put(tmp);
+            return ret;
+        }
+        tmp = ex_field_read(s, f->field.data, at);
+        if (!tmp || ex_to_int(s, tmp, &v, at)) {
+            ex_put(tmp);
+            return -1;
+        }
+        ex_put(tmp);
+        *value = (uint8_t)v;
+        return 0;
+    }
+    return -1;
+}
+
+static struct ex_obj *ex_bfield_read(struct omen_aml_sandbox *s, struct ex_obj *f, uint32_t at) {
+    struct ex_obj *src = f->bfield.source, *r;
+    uint8_t *out;
+    
+    if (f->bfield.bit + f->bfield.bits > src->buf.length * 8) {
+        ex_fail(s, at, -ERANGE, "AE_AML_BUFFER_LIMIT", NULL);
+        return NULL;
+    }
+    out = calloc((f->bfield.bits + 7) / 8 + 1, 1);
+    if (!out) {
+        ex_fail(s, at, -ENOMEM, "AE_NO_MEMORY", NULL);
+        return NULL;
+    }
+    ex_bits_get(src->buf.data, f->bfield.bit, f->bfield.bits, out);
+    r = ex_bits_obj(s, out, f->bfield.bits);
+    free(out);
+    return r;
+}
+
+static int ex_bfield_write(struct omen_aml_sandbox *s, struct ex_obj *f, struct ex_obj *value,
+                           uint32_t at) {
+    struct ex_obj *src = f->bfield.source;
+    const uint8_t *data;
+    uint32_t length;
+    uint8_t tmp[8];
+    
+    if (f->bfield.bit + f->bfield.bits > src->buf.length * 8) {
+        ex_fail(s, at, -ERANGE, "AE_AML_BUFFER_LIMIT", NULL);
+        return -1;
+    }
+    if (ex_view(s, value, tmp, &data, &length, at)) {
+        return -1;
+    }
+    ex_bits_put(src->buf.data, f->bfield.bit, f->bfield.bits, data, length);
+    return 0;
+}
+
+/*
+ * Values of names, references and targets
+ */
+static struct ex_obj *ex_node_value(struct omen_aml_sandbox *s, struct ex_node *node,
+                                    uint32_t at) {
+    if (!node->obj) {
+        ex_fail(s, at, -EINVAL, "AE_AML_UNINITIALIZED_ELEMENT", node->path);
+        return NULL;
+    }
+    switch (node->obj->type) {
+    case EX_FIELD:
+        return ex_field_read(s, node, at);
+    case EX_BFIELD:
+        return ex_bfield_read(s, node->obj, at);
+    }
+    return ex_get(node->obj);
+}
+
+static struct ex_obj *ex_ref_read(struct omen_aml_sandbox *s, struct ex_obj *ref, uint32_t at) {
+    struct ex_obj *c = ref->ref.container;
+    
+    if (ref->ref.kind == EX_TO_NODE) {
+        return ex_node_value(s, ref->ref.node, at);
+    }
+    switch (c->type) {
+    case EX_STR:
+    case EX_BUF:
+        if (ref->ref.index >= c->buf.length) {
+            break;
+        }
+        return ex_int(s, c->buf.data[ref->ref.index]);
+    case EX_PKG:
+        if (ref->ref.index >= c->pkg.count) {
+            break;
+        }
+        if (!c->pkg.items[ref->ref.index]) {
+            ex_fail(s, at, -EINVAL, "AE_AML_UNINITIALIZED_ELEMENT", NULL);
+            return NULL;
+        }
+        return ex_get(c->pkg.items[ref->ref.index]);
+    }
+    ex_fail(s, at, -ERANGE, c->type == EX_PKG ? "AE_AML_PACKAGE_LIMIT" : "AE_AML_BUFFER_LIMIT",
+            NULL);
+    return NULL;
+}
+
+static void ex_target_release(struct ex_target *t) {
+    ex_put(t->container);
+    t->container = NULL;
+}
+
+static uint32_t ex_local_target(struct omen_aml_sandbox *s, uint32_t pos, struct ex_target *t) {
+    uint8_t op = s->aml[pos];
+    
+    if (!s->frame) {
+        ex_fail(s, pos, -EINVAL, "AE_AML_OPERAND_TYPE", "LocalX/ArgX outside a method");
+        return pos + 1;
+    }
+    if (op < 0x68) {
+        t->kind = EX_TO_LOCAL;
+        t->slot = &s->frame->locals[op - 0x60];
+    } else {
+        t->kind = EX_TO_ARG;
+        t->slot = &s->frame->args[op - 0x68];
+    }
+    return pos + 1;
+}
+
+static void ex_target_from_ref(struct ex_target *t, struct ex_obj *ref) {
+    t->kind = ref->ref.kind;
+    t->node = ref->ref.node;
+    t->container = ex_get(ref->ref.container);
+    t->index = ref->ref.index;
+}
+
+// SuperName or Target: NullName, LocalX, ArgX, Debug, a name, or a reference
+static uint32_t ex_target(struct omen_aml_sandbox *s, uint32_t pos, const char *scope,
+                          struct ex_target *t) {
+    struct ex_obj *ref;
+    struct ex_name name;
+    uint32_t at = pos;
+    uint8_t op;
+    
+    memset(t, 0, sizeof(*t));
+    if (s->error) {
+        return pos;
+    }
+    if (pos >= s->size) {
+        return ex_overrun(s, pos);
+    }
+    op = s->aml[pos];
+    if (op == 0x00) {
+        return pos + 1;
+    }
+    if (op >= 0x60 && op <= 0x6E) {
+        return ex_local_target(s, pos, t);
+    }
+    if (op == 0x5B && pos + 1 < s->size && s->aml[pos + 1] == 0x31) {
+        t->kind = EX_TO_DEBUG;
+        return pos + 2;
+    }
+    if (ex_name_start(op)) {
+        pos = ex_name_string(s, pos, &name);
+        t->node = ex_resolve(s, scope, &name);
+        if (!t->node) {
+            ex_not_found(s, at, &name);
+        } else if (t->node->obj->type == EX_METHOD) {
+            ex_fail(s, at, -EOPNOTSUPP, "AE_SUPPORT", "method call as a target");
+        }
+        t->kind = EX_TO_NODE;
+        return pos;
+    }
+    
+    // DerefOf as a target stores through the reference it holds
+    if (op == 0x83) {
+        pos++;
+    }
+    ref = ex_eval(s, &pos, scope);
+    if (!ref) {
+        if (!s->error) {
+            ex_fail(s, at, -EINVAL, "AE_AML_NO_RETURN_VALUE", NULL);
+        }
+        return pos;
+    }
+    if (ref->type == EX_REF) {
+        ex_target_from_ref(t, ref);
+    } else {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "reference expected");
+    }
+    ex_put(ref);
+    return pos;
+}
+
+static struct ex_obj *ex_target_read(struct omen_aml_sandbox *s, struct ex_target *t,
+                                     uint32_t at) {
+    struct ex_obj ref;
+    
+    switch (t->kind) {
+    case EX_TO_LOCAL:
+    case EX_TO_ARG:
+        if (!*t->slot) {
+            ex_fail(s, at, -EINVAL, t->kind == EX_TO_LOCAL ? "AE_AML_UNINITIALIZED_LOCAL" :
+                    "AE_AML_UNINITIALIZED_ARG", NULL);
+            return NULL;
+        }
+        if (t->kind == EX_TO_ARG && (*t->slot)->type == EX_REF) {
+            return ex_ref_read(s, *t->slot, at);
+        }
+        return ex_get(*t->slot);
+    case EX_TO_NODE:
+        return ex_node_value(s, t->node, at);
+    case EX_TO_INDEX:
+        memset(&ref, 0, sizeof(ref));
+        ref.type = EX_REF;
+        ref.ref.kind = EX_TO_INDEX;
+        ref.ref.container = t->container;
+        ref.ref.index = t->index;
+        return ex_ref_read(s, &ref, at);
+    }
+    ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "no value to read");
+    return NULL;
+}
+
+/*
+ * Store - implicit conversion to the type already in a named object,
+ * plain replacement for locals
+ */
+static int ex_store_node(struct omen_aml_sandbox *s, struct ex_obj *value, struct ex_node *node,
+                         uint32_t at) {
+    struct ex_obj *cur = node->obj, *c;
+    uint64_t v;
+    
+    if (value->type == EX_REF && cur && cur->type != EX_REF && cur->type != EX_PKG &&
+        cur->type != EX_UNINIT) {
+        struct ex_obj *target = ex_ref_read(s, value, at);
+        int ret = target ? ex_store_node(s, target, node, at) : -1;
+        
+        ex_put(target);
+        return ret;
+    }
+    
+    switch (cur ? cur->type : EX_UNINIT) {
+    case EX_FIELD:
+        return ex_field_write(s, node, value, at);
+    case EX_BFIELD:
+        return ex_bfield_write(s, cur, value, at);
+    case EX_INT:
+        if (ex_to_int(s, value, &v, at)) {
+            return -1;
+        }
+        c = ex_int(s, v);
+        break;
+    case EX_BUF: {
+        const uint8_t *data;
+        uint32_t length;
+        uint8_t tmp[8];
+        
+        // In place, so buffer fields created on it see the new bytes
+        if (ex_view(s, value, tmp, &data, &length, at)) {
+            return -1;
+        }
+        if (length > cur->buf.length) {
+            uint8_t *grown = realloc(cur->buf.data, (size_t)length + 1);
+            
+            if (!grown) {
+                ex_fail(s, at, -ENOMEM, "AE_NO_MEMORY", NULL);
+                return -1;
+            }
+            cur->buf.data = grown;
+            cur->buf.length = length;
+        }
+        memset(cur->buf.data, 0, cur->buf.length + 1);
+        memmove(cur->buf.data, data, length);
+        return 0;
+    }
+    case EX_STR:
+        c = ex_to_string(s, value, at);
+        break;
+    default:
+        c = ex_copy(s, value);
+        break;
+    }
+    if (!c) {
+        return -1;
+    }
+    ex_put(node->obj);
+    node->obj = c;
+    return 0;
+}
+
+static int ex_store(struct omen_aml_sandbox *s, struct ex_obj *value, struct ex_target *t,
+                    uint32_t at) {
+    struct ex_obj *c = NULL, *container = t->container;
+    uint64_t v;
+    
+    if (s->error) {
+        return -1;
+    }
+    switch (t->kind) {
+    case EX_TO_NONE:
+    case EX_TO_DEBUG:
+        return 0;
+    case EX_TO_ARG:
+        // An ArgX holding RefOf() stores through it
+        if (*t->slot && (*t->slot)->type == EX_REF) {
+            struct ex_target inner = { 0 };
+            int ret;
+            
+            ex_target_from_ref(&inner, *t->slot);
+            ret = ex_store(s, value, &inner, at);
+            ex_target_release(&inner);
+            return ret;
+        }
+        // Fall through
+    case EX_TO_LOCAL:
+        c = ex_copy(s, value);
+        if (!c) {
+            return -1;
+        }
+        ex_put(*t->slot);
+        *t->slot = c;
+        return 0;
+    case EX_TO_NODE:
+        return ex_store_node(s, value, t->node, at);
+    case EX_TO_INDEX:
+        if (container->type == EX_PKG) {
+            if (t->index >= container->pkg.count) {
+                ex_fail(s, at, -ERANGE, "AE_AML_PACKAGE_LIMIT", NULL);
+                return -1;
+            }
+            c = ex_copy(s, value);
+            if (!c) {
+                return -1;
+            }
+            ex_put(container->pkg.items[t->index]);
+            container->pkg.items[t->index] = c;
+            return 0;
+        }
+        if (t->index >= container->buf.length) {
+            ex_fail(s, at, -ERANGE, "AE_AML_BUFFER_LIMIT", NULL);
+            return -1;
+        }
+        if (ex_to_int(s, value, &v, at)) {
+            return -1;
+        }
+        container->buf.data[t->index] = (uint8_t)v;
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * Operands
+ */
+static struct ex_obj *ex_operand(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    uint32_t at = *pos;
+    struct ex_obj *o = ex_eval(s, pos, scope);
+    
+    if (!o && !s->error) {
+        ex_fail(s, at, -EINVAL, "AE_AML_NO_RETURN_VALUE", NULL);
+    }
+    return o;
+}
+
+static int ex_int_operand(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                          uint64_t *value) {
+    uint32_t at = *pos;
+    struct ex_obj *o = ex_operand(s, pos, scope);
+    int ret;
+    
+    if (!o) {
+        return -1;
+    }
+    ret = ex_to_int(s, o, value, at);
+    ex_put(o);
+    return ret;
+}
+
+// Stores a result into the Target operand at *pos and hands it back
+static struct ex_obj *ex_result(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                struct ex_obj *result, uint32_t at) {
+    struct ex_target t;
+    
+    *pos = ex_target(s, *pos, scope, &t);
+    if (result) {
+        ex_store(s, result, &t, at);
+    }
+    ex_target_release(&t);
+    if (s->error) {
+        ex_put(result);
+        return NULL;
+    }
+    return result;
+}
+
+/*
+ * Method invocation
+ */
+static const char *const ex_osi_strings[] = {
+    "Windows 2000", "Windows 2001", "Windows 2001 SP1", "Windows 2001.1", "Windows 2001 SP2",
+    "Windows 2001.1 SP1", "Windows 2006", "Windows 2006 SP1", "Windows 2006.1",
+    "Windows 2006 SP2", "Windows 2009", "Windows 2012", "Windows 2013", "Windows 2015",
+    "Windows 2016", "Windows 2017", "Windows 2017.2", "Windows 2018", "Windows 2018.2",
+    "Windows 2019", "Windows 2020", "Windows 2021", "Windows 2022", "Module Device",
+    "Processor Device", "3.0 Thermal Model", "3.0 _SCP Extensions",
+    "Processor Aggregator Device", "Extended Address Space Descriptor", NULL
+};
+
+// \_OSI answers like Linux does: every Windows version, never "Linux"
+static struct ex_obj *ex_osi(struct omen_aml_sandbox *s, struct ex_obj *arg) {
+    if (!arg || arg->type != EX_STR) {
+        ex_fail(s, 0, -EINVAL, "AE_AML_OPERAND_TYPE", "_OSI takes a string");
+        return NULL;
+    }
+    for (int i = 0; ex_osi_strings[i]; i++) {
+        if (strcmp((const char *)arg->buf.data, ex_osi_strings[i]) == 0) {
+            return ex_int(s, ~0ULL);
+        }
+    }
+    return ex_int(s, 0);
+}
+
+static struct ex_obj *ex_call(struct omen_aml_sandbox *s, struct ex_node *method,
+                              struct ex_obj **args, int count) {
+    struct ex_obj *m = method->obj, *ret = NULL;
+    struct ex_frame frame, *saved_frame = s->frame;
+    const uint8_t *saved_aml = s->aml;
+    uint32_t saved_size = s->size, saved_end = s->list_end;
+    uint16_t saved_table = s->table;
+    uint8_t saved_bits = s->int_bits;
+    
+    if (m->method.native == EX_NATIVE_OSI) {
+        return ex_osi(s, count > 0 ? args[0] : NULL);
+    }
+    if (s->depth >= EX_MAX_DEPTH) {
+        ex_fail(s, m->method.start, -ELOOP, "AE_AML_METHOD_LIMIT", method->path);
+        return NULL;
+    }
+    
+    memset(&frame, 0, sizeof(frame));
+    frame.method = method;
+    for (int i = 0; i < count && i < m->method.args; i++) {
+        frame.args[i] = ex_get(args[i]);
+    }
+    
+    s->stats.calls++;
+    ex_event(s, OMEN_AML_EVENT_CALL, method->path, 0, (uint64_t)count, 0, 0);
+    s->aml = m->method.aml;
+    s->size = m->method.size;
+    s->table = m->method.table;
+    s->int_bits = m->method.int_bits;
+    s->frame = &frame;
+    s->depth++;
+    
+    ex_exec_list(s, m->method.start, m->method.end, method->path);
+    if (s->flow == EX_FLOW_RETURN) {
+        ret = s->retval;
+        s->retval = NULL;
+    }
+    s->flow = EX_FLOW_NONE;
+    
+    s->depth--;
+    ex_event(s, OMEN_AML_EVENT_RETURN, method->path, 0, 0, 0, 0);
+    s->frame = saved_frame;
+    s->aml = saved_aml;
+    s->size = saved_size;
+    s->list_end = saved_end;
+    s->table = saved_table;
+    s->int_bits = saved_bits;
+    
+    for (int i = 0; i < OMEN_AML_MAX_ARGS; i++) {
+        ex_put(frame.args[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        ex_put(frame.locals[i]);
+    }
+    if (s->error) {
+        ex_put(ret);
+        return NULL;
+    }
+    return ret ? ret : ex_int(s, 0);
+}
+
+static struct ex_obj *ex_invoke(struct omen_aml_sandbox *s, struct ex_node *method, uint32_t *pos,
+                                const char *scope) {
+    struct ex_obj *args[OMEN_AML_MAX_ARGS] = { 0 }, *ret = NULL;
+    int count = method->obj->method.args;
+    int i;
+    
+    for (i = 0; i < count; i++) {
+        args[i] = ex_operand(s, pos, scope);
+        if (!args[i]) {
+            break;
+        }
+    }
+    if (i == count) {
+        ret = ex_call(s, method, args, count);
+    }
+    for (i = 0; i < count; i++) {
+        ex_put(args[i]);
+    }
+    return ret;
+}
+
+/*
+ * Named object definitions
+ */
+static uint32_t ex_field_list(struct omen_aml_sandbox *s, uint32_t pos, uint32_t end,
+                              const char *scope, const struct ex_obj *tmpl) {
+    uint32_t bit = 0, width = 0;
+    uint8_t flags = tmpl->field.flags;
+    struct ex_name name;
+    
+    while (pos < end && !s->error) {
+        switch (s->aml[pos]) {
+        case 0x00:              // ReservedField
+            pos = ex_pkg_value(s, pos + 1, &width);
+            bit += width;
+            break;
+        case 0x01:              // AccessField
+            if (pos + 2 < end) {
+                flags = (uint8_t)((flags & 0xF0) | (s->aml[pos + 1] & 0x0F));
+            }
+            pos += 3;
+            break;
+        case 0x02:              // ConnectField
+            if (pos + 1 < end && s->aml[pos + 1] == 0x11) {
+                pos++;
+                ex_put(ex_eval(s, &pos, scope));
+            } else {
+                pos = ex_name_string(s, pos + 1, &name);
+            }
+            break;
+        case 0x03:              // ExtendedAccessField
+            pos += 4;
+            break;
+        default: {
+            struct ex_obj *unit;
+            
+            if (pos + 4 > end) {
+                return ex_overrun(s, pos);
+            }
+            name.root = name.up = 0;
+            name.count = 1;
+            name.segments = &s->aml[pos];
+            pos = ex_pkg_value(s, pos + 4, &width);
+            unit = ex_new(s, EX_FIELD);
+            if (unit) {
+                unit->field = tmpl->field;
+                unit->field.flags = flags;
+                unit->field.bit = bit;
+                unit->field.bits = width;
+            }
+            ex_define(s, scope, &name, unit);
+            bit += width;
+            break;
+        }
+        }
+    }
+    return end;
+}
+
+// Field, IndexField and BankField; pos is after the ExtOp
+static uint32_t ex_field(struct omen_aml_sandbox *s, uint32_t pos, int op, const char *scope) {
+    struct ex_obj tmpl;
+    struct ex_name name;
+    uint32_t end, at = pos - 2;
+    
+    memset(&tmpl, 0, sizeof(tmpl));
+    pos = ex_pkg_length(s, pos, &end);
+    pos = ex_name_string(s, pos, &name);
+    if (s->error) {
+        return end;
+    }
+    
+    if (op == 0x86) {           // IndexField: index and data field units
+        struct ex_name data;
+        
+        tmpl.field.kind = EX_FIELD_INDEX;
+        tmpl.field.index = ex_resolve(s, scope, &name);
+        pos = ex_name_string(s, pos, &data);
+        tmpl.field.data = ex_resolve(s, scope, &data);
+        if (!tmpl.field.index || !tmpl.field.data) {
+            ex_not_found(s, at, tmpl.field.index ? &data : &name);
+            return end;
+        }
+    } else {
+        tmpl.field.kind = op == 0x87 ? EX_FIELD_BANK : EX_FIELD_REGION;
+        tmpl.field.region = ex_resolve(s, scope, &name);
+        if (!tmpl.field.region) {
+            ex_not_found(s, at, &name);
+            return end;
+        }
+        if (op == 0x87) {       // BankField: bank register and its value
+            struct ex_name bank;
+            
+            pos = ex_name_string(s, pos, &bank);
+            tmpl.field.bank = ex_resolve(s, scope, &bank);
+            if (!tmpl.field.bank) {
+                ex_not_found(s, at, &bank);
+                return end;
+            }
+            if (ex_int_operand(s, &pos, scope, &tmpl.field.bank_value)) {
+                return end;
+            }
+        }
+    }
+    if (pos >= end) {
+        return ex_overrun(s, at);
+    }
+    tmpl.field.flags = s->aml[pos++];
+    return ex_field_list(s, pos, end, scope, &tmpl);
+}
+
+// Device, Processor, PowerResource, ThermalZone; fixed bytes follow the name
+static uint32_t ex_scope_object(struct omen_aml_sandbox *s, uint32_t pos, int type, int fixed,
+                                const char *scope) {
+    char child[OMEN_AML_PATH_MAX];
+    struct ex_name name;
+    struct ex_node *node;
+    uint32_t end;
+    
+    pos = ex_pkg_length(s, pos, &end);
+    pos = ex_name_string(s, pos, &name);
+    if (s->error || pos + fixed > end || ex_join(scope, &name, child)) {
+        return s->error ? end : ex_overrun(s, pos);
+    }
+    node = ex_node(s, child);
+    if (node && (!node->obj || node->obj->type != type)) {
+        ex_put(node->obj);
+        node->obj = ex_new(s, type);
+    }
+    ex_exec_list(s, pos + fixed, end, child);
+    return end;
+}
+
+// CreateBitField .. CreateQWordField and CreateField
+static uint32_t ex_create_field(struct omen_aml_sandbox *s, uint32_t pos, int op,
+                                const char *scope) {
+    static const uint8_t widths[] = { [0x8A] = 32, [0x8B] = 16, [0x8C] = 8, [0x8D] = 1,
+                                      [0x8F] = 64 };
+    struct ex_obj *src, *f;
+    struct ex_name name;
+    uint64_t index = 0, bits = op == 0x13 ? 0 : widths[op];
+    uint32_t at = pos - (op == 0x13 ? 2 : 1);
+    
+    src = ex_operand(s, &pos, scope);
+    if (!src) {
+        return pos;
+    }
+    if (ex_int_operand(s, &pos, scope, &index) ||
+        (op == 0x13 && ex_int_operand(s, &pos, scope, &bits))) {
+        ex_put(src);
+        return pos;
+    }
+    pos = ex_name_string(s, pos, &name);
+    if (src->type != EX_BUF && src->type != EX_STR) {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "buffer expected");
+    }
+    
+    // Whole bytes except for CreateBitField and CreateField
+    if (op != 0x8D && op != 0x13) {
+        index *= 8;
+    }
+    if (!s->error && index + bits > (uint64_t)src->buf.length * 8) {
+        char detail[64];
+        
+        snprintf(detail, sizeof(detail), "bits %llu..%llu of a %u byte buffer",
+                 (unsigned long long)index, (unsigned long long)(index + bits - 1),
+                 src->buf.length);
+        ex_fail(s, at, -ERANGE, "AE_AML_BUFFER_LIMIT", detail);
+    }
+    if (s->error) {
+        ex_put(src);
+        return pos;
+    }
+    f = ex_new(s, EX_BFIELD);
+    if (!f) {
+        ex_put(src);
+        return pos;
+    }
+    f->bfield.source = src;
+    f->bfield.bit = (uint32_t)index;
+    f->bfield.bits = (uint32_t)bits;
+    ex_define(s, scope, &name, f);
+    return pos;
+}
+
+static uint32_t ex_method(struct omen_aml_sandbox *s, uint32_t pos, const char *scope) {
+    struct ex_name name;
+    struct ex_obj *m;
+    uint32_t end;
+    
+    pos = ex_pkg_length(s, pos, &end);
+    pos = ex_name_string(s, pos, &name);
+    if (s->error || pos >= end) {
+        return s->error ? end : ex_overrun(s, pos);
+    }
+    m = ex_new(s, EX_METHOD);
+    if (m) {
+        m->method.aml = s->aml;
+        m->method.size = s->size;
+        m->method.start = pos + 1;
+        m->method.end = end;
+        m->method.args = s->aml[pos] & 7;
+        m->method.table = s->table;
+        m->method.int_bits = s->int_bits;
+    }
+    ex_define(s, scope, &name, m);
+    return end;
+}
+
+/*
+ * Data objects
+ */
+static struct ex_obj *ex_buffer(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    uint32_t p = *pos, end;
+    uint64_t size;
+    struct ex_obj *b;
+    
+    p = ex_pkg_length(s, p, &end);
+    *pos = end;
+    if (s->error || ex_int_operand(s, &p, scope, &size)) {
+        return NULL;
+    }
+    if (p > end) {
+        ex_overrun(s, p);
+        return NULL;
+    }
+    if (size < end - p) {
+        size = end - p;
+    }
+    if (size > 0x1000000) {
+        ex_fail(s, p, -ERANGE, "AE_AML_BUFFER_LIMIT", "buffer over 16 MiB");
+        return NULL;
+    }
+    b = ex_bytes_obj(s, EX_BUF, NULL, (uint32_t)size);
+    if (b) {
+        memcpy(b->buf.data, s->aml + p, end - p);
+    }
+    return b;
+}
+
+// Package elements: data objects, or names that stay references
+static struct ex_obj *ex_package(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                 int variable) {
+    uint32_t p = *pos, end;
+    uint64_t count;
+    struct ex_obj *pkg;
+    
+    p = ex_pkg_length(s, p, &end);
+    *pos = end;
+    if (s->error) {
+        return NULL;
+    }
+    if (variable) {
+        if (ex_int_operand(s, &p, scope, &count)) {
+            return NULL;
+        }
+    } else {
+        count = p < end ? s->aml[p++] : 0;
+    }
+    if (count > 0x10000) {
+        ex_fail(s, p, -ERANGE, "AE_AML_PACKAGE_LIMIT", NULL);
+        return NULL;
+    }
+    pkg = ex_pkg(s, (uint32_t)count);
+    
+    for (uint32_t i = 0; pkg && p < end && !s->error; i++) {
+        struct ex_obj *item;
+        
+        if (ex_name_start(s->aml[p])) {
+            struct ex_name name;
+            struct ex_node *node;
+            
+            p = ex_name_string(s, p, &name);
+            node = ex_resolve(s, scope, &name);
+            item = node ? ex_new(s, EX_REF) : ex_int(s, 0);
+            if (node && item) {
+                item->ref.kind = EX_TO_NODE;
+                item->ref.node = node;
+            }
+        } else {
+            item = ex_operand(s, &p, scope);
+        }
+        if (i < count) {
+            pkg->pkg.items[i] = item;
+        } else {
+            ex_put(item);
+        }
+    }
+    if (s->error) {
+        ex_put(pkg);
+        return NULL;
+    }
+    return pkg;
+}
+
+/*
+ * Expressions
+ */
+static struct ex_obj *ex_name_value(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    struct ex_name name;
+    struct ex_node *node;
+    uint32_t at = *pos;
+    
+    *pos = ex_name_string(s, *pos, &name);
+    if (s->error) {
+        return NULL;
+    }
+    node = ex_resolve(s, scope, &name);
+    if (!node) {
+        ex_not_found(s, at, &name);
+        return NULL;
+    }
+    if (node->obj->type == EX_METHOD) {
+        return ex_invoke(s, node, pos, scope);
+    }
+    return ex_node_value(s, node, at);
+}
+
+static int ex_compare(struct omen_aml_sandbox *s, struct ex_obj *a, struct ex_obj *b,
+                      int *result, uint32_t at) {
+    uint64_t x, y;
+    
+    if (a->type == EX_STR || a->type == EX_BUF) {
+        const uint8_t *data;
+        uint32_t length, n;
+        uint8_t tmp[8];
+        int c;
+        
+        if (ex_view(s, b, tmp, &data, &length, at)) {
+            return -1;
+        }
+        n = a->buf.length < length ? a->buf.length : length;
+        c = memcmp(a->buf.data, data, n);
+        *result = c ? c : (a->buf.length > length) - (a->buf.length < length);
+        return 0;
+    }
+    if (ex_to_int(s, a, &x, at) || ex_to_int(s, b, &y, at)) {
+        return -1;
+    }
+    *result = (x > y) - (x < y);
+    return 0;
+}
+
+static struct ex_obj *ex_concat(struct omen_aml_sandbox *s, struct ex_obj *a, struct ex_obj *b,
+                                uint32_t at) {
+    const uint8_t *da, *db;
+    uint32_t la, lb;
+    uint8_t ta[8], tb[8];
+    struct ex_obj *r, *sb = NULL;
+    int type = a->type == EX_STR ? EX_STR : EX_BUF;
+    
+    if (type == EX_STR) {
+        sb = ex_to_string(s, b, at);
+        b = sb;
+    } else if (a->type == EX_INT) {
+        uint64_t v;
+        
+        // Integer first: both become integers, side by side
+        if (ex_to_int(s, b, &v, at)) {
+            return NULL;
+        }
+        sb = ex_int(s, v);
+        b = sb;
+    }
+    if (!b || ex_view(s, a, ta, &da, &la, at) || ex_view(s, b, tb, &db, &lb, at)) {
+        ex_put(sb);
+        return NULL;
+    }
+    r = ex_bytes_obj(s, type, NULL, la + lb);
+    if (r) {
+        memcpy(r->buf.data, da, la);
+        memcpy(r->buf.data + la, db, lb);
+    }
+    ex_put(sb);
+    return r;
+}
+
+static int ex_match_one(uint64_t value, int op, uint64_t operand) {
+    switch (op) {
+    case 0: return 1;                   // MTR
+    case 1: return value == operand;    // MEQ
+    case 2: return value <= operand;    // MLE
+    case 3: return value < operand;     // MLT
+    case 4: return value >= operand;    // MGE
+    case 5: return value > operand;     // MGT
+    }
+    return 0;
+}
+
+static struct ex_obj *ex_match(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                               uint32_t at) {
+    struct ex_obj *pkg = ex_operand(s, pos, scope), *r = NULL;
+    uint64_t first, second, start;
+    int op1, op2;
+    
+    if (!pkg) {
+        return NULL;
+    }
+    op1 = *pos < s->size ? s->aml[(*pos)++] : 0;
+    if (ex_int_operand(s, pos, scope, &first)) {
+        goto out;
+    }
+    op2 = *pos < s->size ? s->aml[(*pos)++] : 0;
+    if (ex_int_operand(s, pos, scope, &second) || ex_int_operand(s, pos, scope, &start)) {
+        goto out;
+    }
+    if (pkg->type != EX_PKG) {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "package expected");
+        goto out;
+    }
+    for (uint64_t i = start; i < pkg->pkg.count; i++) {
+        struct ex_obj *item = pkg->pkg.items[i];
+        
+        if (item && item->type == EX_INT && ex_match_one(item->integer, op1, first) &&
+            ex_match_one(item->integer, op2, second)) {
+            r = ex_int(s, i);
+            goto out;
+        }
+    }
+    r = ex_int(s, ~0ULL);
+out:
+    ex_put(pkg);
+    return r;
+}
+
+// Add .. XOr, ShiftLeft/Right, Mod, NAnd, NOr: two integers and a target
+static struct ex_obj *ex_arith(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                               int op, uint32_t at) {
+    uint64_t a, b, r = 0;
+    
+    if (ex_int_operand(s, pos, scope, &a) || ex_int_operand(s, pos, scope, &b)) {
+        return NULL;
+    }
+    switch (op) {
+    case 0x72: r = a + b; break;
+    case 0x74: r = a - b; break;
+    case 0x77: r = a * b; break;
+    case 0x79: r = b >= 64 ? 0 : a << b; break;
+    case 0x7A: r = b >= 64 ? 0 : a >> b; break;
+    case 0x7B: r = a & b; break;
+    case 0x7C: r = ~(a & b); break;
+    case 0x7D: r = a | b; break;
+    case 0x7E: r = ~(a | b); break;
+    case 0x7F: r = a ^ b; break;
+    case 0x85:
+        if (!b) {
+            ex_fail(s, at, -EDOM, "AE_AML_DIVIDE_BY_ZERO", NULL);
+            return NULL;
+        }
+        r = a % b;
+        break;
+    }
+    return ex_result(s, pos, scope, ex_int(s, r), at);
+}
+
+static struct ex_obj *ex_divide(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                uint32_t at) {
+    struct ex_obj *rem, *quot;
+    struct ex_target t;
+    uint64_t a, b;
+    
+    if (ex_int_operand(s, pos, scope, &a) || ex_int_operand(s, pos, scope, &b)) {
+        return NULL;
+    }
+    if (!b) {
+        ex_fail(s, at, -EDOM, "AE_AML_DIVIDE_BY_ZERO", NULL);
+        return NULL;
+    }
+    rem = ex_int(s, a % b);
+    *pos = ex_target(s, *pos, scope, &t);
+    if (rem) {
+        ex_store(s, rem, &t, at);
+    }
+    ex_target_release(&t);
+    ex_put(rem);
+    quot = ex_int(s, a / b);
+    return ex_result(s, pos, scope, quot, at);
+}
+
+// Increment, Decrement
+static struct ex_obj *ex_step(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                              int delta, uint32_t at) {
+    struct ex_obj *cur, *r = NULL;
+    struct ex_target t;
+    uint64_t v;
+    
+    *pos = ex_target(s, *pos, scope, &t);
+    cur = s->error ? NULL : ex_target_read(s, &t, at);
+    if (cur && ex_to_int(s, cur, &v, at) == 0) {
+        r = ex_int(s, v + (uint64_t)(int64_t)delta);
+        if (r && ex_store(s, r, &t, at)) {
+            ex_put(r);
+            r = NULL;
+        }
+    }
+    ex_put(cur);
+    ex_target_release(&t);
+    return r;
+}
+
+static struct ex_obj *ex_index(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                               uint32_t at) {
+    struct ex_obj *src = ex_operand(s, pos, scope), *ref;
+    uint64_t index;
+    uint32_t limit;
+    
+    if (!src) {
+        return NULL;
+    }
+    if (src->type == EX_REF) {
+        struct ex_obj *target = ex_ref_read(s, src, at);
+        
+        ex_put(src);
+        src = target;
+        if (!src) {
+            return NULL;
+        }
+    }
+    if (ex_int_operand(s, pos, scope, &index)) {
+        ex_put(src);
+        return NULL;
+    }
+    if (src->type != EX_PKG && src->type != EX_BUF && src->type != EX_STR) {
+        ex_put(src);
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "Index of a non-container");
+        return NULL;
+    }
+    limit = src->type == EX_PKG ? src->pkg.count : src->buf.length;
+    if (index >= limit) {
+        int pkg = src->type == EX_PKG;
+        
+        ex_put(src);
+        ex_fail(s, at, -ERANGE, pkg ? "AE_AML_PACKAGE_LIMIT" : "AE_AML_BUFFER_LIMIT", NULL);
+        return NULL;
+    }
+    ref = ex_new(s, EX_REF);
+    if (!ref) {
+        ex_put(src);
+        return NULL;
+    }
+    ref->ref.kind = EX_TO_INDEX;
+    ref->ref.container = src;
+    ref->ref.index = (uint32_t)index;
+    return ex_result(s, pos, scope, ref, at);
+}
+
+static struct ex_obj *ex_deref(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                               uint32_t at) {
+    struct ex_obj *o = ex_operand(s, pos, scope), *r = NULL;
+    
+    if (!o) {
+        return NULL;
+    }
+    if (o->type == EX_REF) {
+        r = ex_ref_read(s, o, at);
+    } else if (o->type == EX_STR) {
+        char path[OMEN_AML_PATH_MAX];
+        struct ex_node *node = NULL;
+        
+        // A path in a string
+        if (omen_aml_normalize_path((const char *)o->buf.data, path, sizeof(path)) == 0) {
+            node = ex_find(s, path);
+        }
+        if (node && node->obj) {
+            r = ex_node_value(s, node, at);
+        } else {
+            ex_fail(s, at, -ENOENT, "AE_NOT_FOUND", (const char *)o->buf.data);
+        }
+    } else {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "reference expected");
+    }
+    ex_put(o);
+    return r;
+}
+
+// RefOf, CondRefOf - references to named objects and container elements
+static struct ex_obj *ex_ref_of(struct omen_aml_sandbox *s, struct ex_target *t, uint32_t at) {
+    struct ex_obj *ref;
+    
+    if (t->kind == EX_TO_LOCAL || t->kind == EX_TO_ARG) {
+        if (*t->slot && (*t->slot)->type == EX_REF) {
+            return ex_get(*t->slot);
+        }
+        ex_fail(s, at, -EOPNOTSUPP, "AE_SUPPORT", "RefOf(LocalX/ArgX)");
+        return NULL;
+    }
+    if (t->kind != EX_TO_NODE && t->kind != EX_TO_INDEX) {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", NULL);
+        return NULL;
+    }
+    ref = ex_new(s, EX_REF);
+    if (ref) {
+        ref->ref.kind = (uint8_t)t->kind;
+        ref->ref.node = t->node;
+        ref->ref.container = ex_get(t->container);
+        ref->ref.index = t->index;
+    }
+    return ref;
+}
+
+static struct ex_obj *ex_cond_ref_of(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                     uint32_t at) {
+    struct ex_obj *ref = NULL;
+    struct ex_target t;
+    struct ex_name name;
+    int found = 0;
+    
+    memset(&t, 0, sizeof(t));
+    if (*pos < s->size && ex_name_start(s->aml[*pos])) {
+        *pos = ex_name_string(s, *pos, &name);
+        t.node = s->error ? NULL : ex_resolve(s, scope, &name);
+        t.kind = EX_TO_NODE;
+        found = t.node != NULL;
+    } else {
+        *pos = ex_target(s, *pos, scope, &t);
+        found = t.kind == EX_TO_INDEX || (t.slot && *t.slot);
+    }
+    if (found && !s->error) {
+        ref = ex_ref_of(s, &t, at);
+    }
+    ex_target_release(&t);
+    
+    *pos = ex_target(s, *pos, scope, &t);
+    if (ref) {
+        ex_store(s, ref, &t, at);
+    }
+    ex_target_release(&t);
+    ex_put(ref);
+    return s->error ? NULL : ex_int(s, found ? ~0ULL : 0);
+}
+
+static struct ex_obj *ex_convert(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                 int op, uint32_t at) {
+    struct ex_obj *o = ex_operand(s, pos, scope), *r = NULL;
+    char text[24];
+    uint64_t v;
+    
+    if (!o) {
+        return NULL;
+    }
+    switch (op) {
+    case 0x96:                  // ToBuffer, strings keep their NUL
+        r = o->type == EX_STR ? ex_bytes_obj(s, EX_BUF, o->buf.data, o->buf.length + 1) :
+            ex_to_buffer(s, o, at);
+        break;
+    case 0x97:                  // ToDecimalString
+    case 0x98:                  // ToHexString
+        if (o->type == EX_STR) {
+            r = ex_get(o);
+        } else if (o->type == EX_BUF) {
+            r = ex_bytes_obj(s, EX_STR, NULL, o->buf.length * 5);
+            for (uint32_t i = 0, len = 0; r && i < o->buf.length; i++) {
+                len += (uint32_t)snprintf((char *)r->buf.data + len, 6, op == 0x97 ? "%s%u" :
+                                          "%s0x%02X", i ? "," : "", o->buf.data[i]);
+                r->buf.length = len;
+            }
+        } else if (ex_to_int(s, o, &v, at) == 0) {
+            snprintf(text, sizeof(text), op == 0x97 ? "%llu" : "0x%llX", (unsigned long long)v);
+            r = ex_bytes_obj(s, EX_STR, text, (uint32_t)strlen(text));
+        }
+        break;
+    case 0x99:                  // ToInteger, strings are decimal unless 0x
+        if (o->type == EX_STR) {
+            r = ex_int(s, strtoull((const char *)o->buf.data, NULL, 0));
+        } else if (ex_to_int(s, o, &v, at) == 0) {
+            r = ex_int(s, v);
+        }
+        break;
+    case 0x80:                  // Not
+        if (ex_to_int(s, o, &v, at) == 0) {
+            r = ex_int(s, ~v);
+        }
+        break;
+    case 0x81:                  // FindSetLeftBit
+    case 0x82:                  // FindSetRightBit
+        if (ex_to_int(s, o, &v, at) == 0) {
+            int bit = 0;
+            
+            if (v) {
+                bit = op == 0x81 ? 64 - __builtin_clzll(v) : __builtin_ctzll(v) + 1;
+            }
+            r = ex_int(s, (uint64_t)bit);
+        }
+        break;
+    case 0x28:                  // FromBCD
+    case 0x29:                  // ToBCD
+        if (ex_to_int(s, o, &v, at) == 0) {
+            uint64_t out = 0, scale = 1;
+            
+            for (; v; scale *= op == 0x28 ? 10 : 16) {
+                out += (op == 0x28 ? (v & 0xF) : (v % 10)) * scale;
+                v = op == 0x28 ? v >> 4 : v / 10;
+            }
+            r = ex_int(s, out);
+        }
+        break;
+    }
+    ex_put(o);
+    return s->error ? NULL : ex_result(s, pos, scope, r, at);
+}
+
+static struct ex_obj *ex_mid(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                             uint32_t at) {
+    struct ex_obj *o = ex_operand(s, pos, scope), *r = NULL;
+    uint64_t index, length;
+    
+    if (!o) {
+        return NULL;
+    }
+    if (ex_int_operand(s, pos, scope, &index) || ex_int_operand(s, pos, scope, &length)) {
+        ex_put(o);
+        return NULL;
+    }
+    if (o->type != EX_STR && o->type != EX_BUF) {
+        ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "Mid of a non-string");
+    } else {
+        if (index > o->buf.length) {
+            index = o->buf.length;
+        }
+        if (length > o->buf.length - index) {
+            length = o->buf.length - index;
+        }
+        r = ex_bytes_obj(s, o->type, o->buf.data + index, (uint32_t)length);
+    }
+    ex_put(o);
+    return s->error ? NULL : ex_result(s, pos, scope, r, at);
+}
+
+static struct ex_obj *ex_ext_op(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope,
+                                uint32_t at) {
+    uint32_t p = *pos;
+    struct ex_target t;
+    struct ex_name name;
+    struct ex_obj *o = NULL;
+    uint64_t v, w;
+    uint8_t op;
+    
+    if (p >= s->size) {
+        *pos = ex_overrun(s, at);
+        return NULL;
+    }
+    op = s->aml[p++];
+    switch (op) {
+    case 0x01:                  // Mutex
+    case 0x02:                  // Event
+        p = ex_name_string(s, p, &name);
+        if (op == 0x01) {
+            p++;
+        }
+        ex_define(s, scope, &name, ex_new(s, op == 0x01 ? EX_MUTEX : EX_EVENT));
+        break;
+    case 0x12:                  // CondRefOf
+        o = ex_cond_ref_of(s, &p, scope, at);
+        break;
+    case 0x13:                  // CreateField
+        p = ex_create_field(s, p, 0x13, scope);
+        break;
+    case 0x21:                  // Stall
+    case 0x22:                  // Sleep
+        if (ex_int_operand(s, &p, scope, &v) == 0) {
+            uint64_t ns = op == 0x21 ? v * 1000 : v * 1000000;
+            
+            s->clock_ns += ns;
+            if (op == 0x21) {
+                s->stats.stall_ns += ns;
+            } else {
+                s->stats.sleep_ns += ns;
+            }
+            ex_event(s, op == 0x21 ? OMEN_AML_EVENT_STALL : OMEN_AML_EVENT_SLEEP,
+                     s->frame ? s->frame->method->path : NULL, 0, v, 0, 0);
+        }
+        break;
+    case 0x23:                  // Acquire - never times out here
+        p = ex_target(s, p, scope, &t);
+        ex_target_release(&t);
+        p += 2;
+        o = s->error ? NULL : ex_int(s, 0);
+        break;
+    case 0x24:                  // Signal
+    case 0x26:                  // Reset
+    case 0x27:                  // Release
+        p = ex_target(s, p, scope, &t);
+        ex_target_release(&t);
+        break;
+    case 0x25:                  // Wait - events are always signalled
+        p = ex_target(s, p, scope, &t);
+        ex_target_release(&t);
+        if (ex_int_operand(s, &p, scope, &v) == 0) {
+            o = ex_int(s, 0);
+        }
+        break;
+    case 0x28:                  // FromBCD
+    case 0x29:                  // ToBCD
+        o = ex_convert(s, &p, scope, op, at);
+        break;
+    case 0x30:                  // Revision
+        o = ex_int(s, 2);
+        break;
+    case 0x32:                  // Fatal
+        if (p + 5 <= s->size) {
+            char detail[48];
+            uint32_t code;
+            
+            memcpy(&code, s->aml + p + 1, 4);
+            snprintf(detail, sizeof(detail), "type 0x%02x code 0x%08x", s->aml[p], code);
+            ex_fail(s, at, -EIO, "AE_AML_FATAL", detail);
+        }
+        break;
+    case 0x33:                  // Timer, 100 ns units of the modelled clock
+        o = ex_int(s, s->clock_ns / 100);
+        break;
+    case 0x80: {                // OperationRegion
+        uint8_t space;
+        
+        p = ex_name_string(s, p, &name);
+        if (p >= s->size) {
+            p = ex_overrun(s, at);
+            break;
+        }
+        space = s->aml[p++];
+        if (ex_int_operand(s, &p, scope, &v) || ex_int_operand(s, &p, scope, &w)) {
+            break;
+        }
+        o = ex_new(s, EX_REGION);
+        if (o) {
+            o->region.space = space;
+            o->region.base = v;
+            o->region.length = w;
+        }
+        ex_define(s, scope, &name, o);
+        o = NULL;
+        break;
+    }
+    case 0x81:                  // Field
+    case 0x86:                  // IndexField
+    case 0x87:                  // BankField
+        p = ex_field(s, p, op, scope);
+        break;
+    case 0x82:                  // Device
+        p = ex_scope_object(s, p, EX_DEVICE, 0, scope);
+        break;
+    case 0x83:                  // Processor
+        p = ex_scope_object(s, p, EX_PROCESSOR, 6, scope);
+        break;
+    case 0x84:                  // PowerResource
+        p = ex_scope_object(s, p, EX_POWER, 3, scope);
+        break;
+    case 0x85:                  // ThermalZone
+        p = ex_scope_object(s, p, EX_THERMAL, 0, scope);
+        break;
+    case 0x88: {                // DataRegion - a table in memory, reads as zeros
+        struct ex_obj *region;
+        
+        p = ex_name_string(s, p, &name);
+        if (ex_int_operand(s, &p, scope, &v) || ex_int_operand(s, &p, scope, &v) ||
+            ex_int_operand(s, &p, scope, &v)) {
+            break;
+        }
+        region = ex_new(s, EX_REGION);
+        if (region) {
+            region->region.space = 0;
+            region->region.base = 0;
+            region->region.length = ~0ULL;
+        }
+        ex_define(s, scope, &name, region);
+        break;
+    }
+    default: {
+        char detail[32];
+        
+        // Load, LoadTable, Unload, Debug as an operand, and anything unknown
+        snprintf(detail, sizeof(detail), "opcode 0x5b%02x", op);
+        ex_fail(s, at, op == 0x1F || op == 0x20 || op == 0x2A ? -EOPNOTSUPP : -EINVAL,
+                op == 0x1F || op == 0x20 || op == 0x2A ? "AE_SUPPORT" : "AE_AML_BAD_OPCODE",
+                detail);
+        break;
+    }
+    }
+    *pos = p;
+    return o;
+}
+
+static struct ex_obj *ex_if(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    uint32_t p = *pos, end, else_start = 0, else_end;
+    uint64_t cond;
+    
+    p = ex_pkg_length(s, p, &end);
+    else_end = end;
+    if (s->error || ex_int_operand(s, &p, scope, &cond)) {
+        *pos = end;
+        return NULL;
+    }
+    
+    // An Else right after the If belongs to it, unless it starts the next list
+    if (end < s->list_end && s->aml[end] == 0xA1) {
+        else_start = ex_pkg_length(s, end + 1, &else_end);
+    }
+    *pos = else_end;
+    if (cond) {
+        ex_exec_list(s, p, end, scope);
+    } else if (else_start) {
+        ex_exec_list(s, else_start, else_end, scope);
+    }
+    return NULL;
+}
+
+static struct ex_obj *ex_while(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    uint32_t p = *pos, end;
+    
+    p = ex_pkg_length(s, p, &end);
+    *pos = end;
+    for (int n = 0; !s->error; n++) {
+        uint32_t body = p;
+        uint64_t cond;
+        
+        if (ex_int_operand(s, &body, scope, &cond) || !cond) {
+            break;
+        }
+        if (n == OMEN_AML_LOOP_LIMIT) {
+            s->stats.loops_cut++;
+            ex_event(s, OMEN_AML_EVENT_LOOP_CUT, s->frame ? s->frame->method->path : NULL,
+                     p, 0, 0, 0);
+            break;
+        }
+        ex_exec_list(s, body, end, scope);
+        if (s->flow == EX_FLOW_BREAK) {
+            s->flow = EX_FLOW_NONE;
+            break;
+        }
+        if (s->flow == EX_FLOW_CONTINUE) {
+            s->flow = EX_FLOW_NONE;
+        }
+        if (s->flow) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static struct ex_obj *ex_eval(struct omen_aml_sandbox *s, uint32_t *pos, const char *scope) {
+    uint32_t at = *pos, p = *pos;
+    struct ex_obj *o = NULL, *a = NULL, *b = NULL;
+    struct ex_target t;
+    struct ex_name name;
+    uint64_t x, y;
+    uint8_t op;
+    int cmp;
+    
+    if (s->error) {
+        return NULL;
+    }
+    if (p >= s->size) {
+        *pos = ex_overrun(s, p);
+        return NULL;
+    }
+    if (++s->stats.terms > EX_STEP_LIMIT) {
+        ex_fail(s, at, -ETIME, "AE_AML_LOOP_TIMEOUT", "term budget exhausted");
+        return NULL;
+    }
+    op = s->aml[p++];
+    
+    if (ex_name_start(op)) {
+        *pos = at;
+        return ex_name_value(s, pos, scope);
+    }
+    
+    switch (op) {
+    case 0x00:                  // Zero
+    case 0x01:                  // One
+        o = ex_int(s, op);
+        break;
+    case 0xFF:                  // Ones
+        o = ex_int(s, ~0ULL);
+        break;
+    case 0x0A:                  // BytePrefix
+    case 0x0B:                  // WordPrefix
+    case 0x0C:                  // DWordPrefix
+    case 0x0E: {                // QWordPrefix
+        int n = op == 0x0A ? 1 : op == 0x0B ? 2 : op == 0x0C ? 4 : 8;
+        
+        if (p + n > s->size) {
+            p = ex_overrun(s, at);
+            break;
+        }
+        x = 0;
+        for (int i = 0; i < n; i++) {
+            x |= (uint64_t)s->aml[p + i] << (8 * i);
+        }
+        p += n;
+        o = ex_int(s, x);
+        break;
+    }
+    case 0x0D: {                // StringPrefix
+        const uint8_t *nul = memchr(s->aml + p, 0, s->size - p);
+        
+        if (!nul) {
+            p = ex_overrun(s, at);
+            break;
+        }
+        o = ex_bytes_obj(s, EX_STR, s->aml + p, (uint32_t)(nul - (s->aml + p)));
+        p = (uint32_t)(nul - s->aml) + 1;
+        break;
+    }
+    case 0x06: {                // Alias
+        struct ex_name alias;
+        struct ex_node *node;
+        
+        p = ex_name_string(s, p, &name);
+        p = ex_name_string(s, p, &alias);
+        node = s->error ? NULL : ex_resolve(s, scope, &name);
+        if (node) {
+            ex_define(s, scope, &alias, ex_get(node->obj));
+        }
+        break;
+    }
+    case 0x08:                  // Name
+        p = ex_name_string(s, p, &name);
+        o = s->error ? NULL : ex_operand(s, &p, scope);
+        if (o) {
+            ex_define(s, scope, &name, ex_copy(s, o));
+            ex_put(o);
+            o = NULL;
+        }
+        break;
+    case 0x10: {                // Scope
+        char child[OMEN_AML_PATH_MAX];
+        uint32_t end;
+        
+        p = ex_pkg_length(s, p, &end);
+        p = ex_name_string(s, p, &name);
+        if (!s->error && ex_join(scope, &name, child) == 0) {
+            ex_exec_list(s, p, end, child);
+        }
+        p = end;
+        break;
+    }
+    case 0x11:                  // Buffer
+        o = ex_buffer(s, &p, scope);
+        break;
+    case 0x12:                  // Package
+    case 0x13:                  // VarPackage
+        o = ex_package(s, &p, scope, op == 0x13);
+        break;
+    case 0x14:                  // Method
+        p = ex_method(s, p, scope);
+        break;
+    case 0x15:                  // External - the definition lives in another table
+        p = ex_name_string(s, p, &name) + 2;
+        break;
+    case 0x5B:                  // ExtOpPrefix
+        o = ex_ext_op(s, &p, scope, at);
+        break;
+    case 0x60: case 0x61: case 0x62: case 0x63:
+    case 0x64: case 0x65: case 0x66: case 0x67:
+    case 0x68: case 0x69: case 0x6A: case 0x6B:
+    case 0x6C: case 0x6D: case 0x6E:
+        p = ex_local_target(s, at, &t);
+        if (s->error) {
+            break;
+        }
+        if (!*t.slot) {
+            ex_fail(s, at, -EINVAL, op < 0x68 ? "AE_AML_UNINITIALIZED_LOCAL" :
+                    "AE_AML_UNINITIALIZED_ARG", NULL);
+            break;
+        }
+        o = ex_get(*t.slot);
+        break;
+    case 0x70:                  // Store
+    case 0x9D:                  // CopyObject
+        a = ex_operand(s, &p, scope);
+        if (!a) {
+            break;
+        }
+        p = ex_target(s, p, scope, &t);
+        if (op == 0x9D && t.kind == EX_TO_NODE && !s->error) {
+            // CopyObject replaces, no conversion
+            struct ex_obj *c = ex_copy(s, a);
+            
+            if (c) {
+                ex_put(t.node->obj);
+                t.node->obj = c;
+            }
+        } else {
+            ex_store(s, a, &t, at);
+        }
+        ex_target_release(&t);
+        o = s->error ? NULL : ex_get(a);
+        break;
+    case 0x71:                  // RefOf
+        p = ex_target(s, p, scope, &t);
+        if (!s->error) {
+            o = ex_ref_of(s, &t, at);
+        }
+        ex_target_release(&t);
+        break;
+    case 0x72: case 0x74: case 0x77: case 0x79: case 0x7A: case 0x7B:
+    case 0x7C: case 0x7D: case 0x7E: case 0x7F: case 0x85:
+        o = ex_arith(s, &p, scope, op, at);
+        break;
+    case 0x73:                  // Concatenate
+    case 0x84:                  // ConcatenateResTemplate
+        a = ex_operand(s, &p, scope);
+        b = a ? ex_operand(s, &p, scope) : NULL;
+        if (!b) {
+            break;
+        }
+        if (op == 0x84 && a->type == EX_BUF && a->buf.length >= 2) {
+            a->buf.length -= 2;         // Drop the first EndTag
+            o = ex_concat(s, a, b, at);
+            a->buf.length += 2;
+        } else {
+            o = ex_concat(s, a, b, at);
+        }
+        o = s->error ? NULL : ex_result(s, &p, scope, o, at);
+        break;
+    case 0x75:                  // Increment
+    case 0x76:                  // Decrement
+        o = ex_step(s, &p, scope, op == 0x75 ? 1 : -1, at);
+        break;
+    case 0x78:                  // Divide
+        o = ex_divide(s, &p, scope, at);
+        break;
+    case 0x80: case 0x81: case 0x82: case 0x96: case 0x97: case 0x98: case 0x99:
+        o = ex_convert(s, &p, scope, op, at);
+        break;
+    case 0x83:                  // DerefOf
+        o = ex_deref(s, &p, scope, at);
+        break;
+    case 0x86:                  // Notify
+        p = ex_target(s, p, scope, &t);
+        if (!s->error && ex_int_operand(s, &p, scope, &x) == 0) {
+            ex_event(s, OMEN_AML_EVENT_NOTIFY, t.node ? t.node->path : NULL, 0, x, 0, 0);
+        }
+        ex_target_release(&t);
+        break;
+    case 0x87:                  // SizeOf
+    case 0x8E:                  // ObjectType
+        p = ex_target(s, p, scope, &t);
+        if (s->error) {
+            ex_target_release(&t);
+            break;
+        }
+        if (op == 0x8E) {
+            struct ex_obj *cur = t.kind == EX_TO_NODE ? t.node->obj :
+                                 t.slot ? *t.slot : NULL;
+            
+            o = ex_int(s, cur ? (cur->type == EX_REF ? 20 : cur->type) : 0);
+            ex_target_release(&t);
+            break;
+        }
+        a = ex_target_read(s, &t, at);
+        ex_target_release(&t);
+        if (a && a->type == EX_REF) {
+            b = ex_ref_read(s, a, at);
+            ex_put(a);
+            a = b;
+            b = NULL;
+        }
+        if (!a) {
+            break;
+        }
+        if (a->type == EX_STR || a->type == EX_BUF) {
+            o = ex_int(s, a->buf.length);
+        } else if (a->type == EX_PKG) {
+            o = ex_int(s, a->pkg.count);
+        } else {
+            ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "SizeOf");
+        }
+        break;
+    case 0x88:                  // Index
+        o = ex_index(s, &p, scope, at);
+        break;
+    case 0x89:                  // Match
+        o = ex_match(s, &p, scope, at);
+        break;
+    case 0x8A: case 0x8B: case 0x8C: case 0x8D: case 0x8F:
+        p = ex_create_field(s, p, op, scope);
+        break;
+    case 0x90:                  // LAnd
+    case 0x91:                  // LOr
+        if (ex_int_operand(s, &p, scope, &x) == 0 && ex_int_operand(s, &p, scope, &y) == 0) {
+            o = ex_int(s, (op == 0x90 ? x && y : x || y) ? ~0ULL : 0);
+        }
+        break;
+    case 0x92:                  // LNot
+        if (ex_int_operand(s, &p, scope, &x) == 0) {
+            o = ex_int(s, x ? 0 : ~0ULL);
+        }
+        break;
+    case 0x93:                  // LEqual
+    case 0x94:                  // LGreater
+    case 0x95:                  // LLess
+        a = ex_operand(s, &p, scope);
+        b = a ? ex_operand(s, &p, scope) : NULL;
+        if (b && ex_compare(s, a, b, &cmp, at) == 0) {
+            int r = op == 0x93 ? cmp == 0 : op == 0x94 ? cmp > 0 : cmp < 0;
+            
+            o = ex_int(s, r ? ~0ULL : 0);
+        }
+        break;
+    case 0x9C:                  // ToString
+        a = ex_operand(s, &p, scope);
+        if (!a || ex_int_operand(s, &p, scope, &x)) {
+            break;
+        }
+        if (a->type != EX_BUF) {
+            ex_fail(s, at, -EINVAL, "AE_AML_OPERAND_TYPE", "ToString of a non-buffer");
+            break;
+        }
+        y = 0;
+        while (y < a->buf.length && y < x && a->buf.data[y]) {
+            y++;
+        }
+        o = ex_result(s, &p, scope, ex_bytes_obj(s, EX_STR, a->buf.data, (uint32_t)y), at);
+        break;
+    case 0x9E:                  // Mid
+        o = ex_mid(s, &p, scope, at);
+        break;
+    case 0x9F:                  // Continue
+        s->flow = EX_FLOW_CONTINUE;
+        break;
+    case 0xA0:                  // If
+        o = ex_if(s, &p, scope);
+        break;
+    case 0xA1: {                // Else without its If - skip it
+        uint32_t end;
+        
+        ex_pkg_length(s, p, &end);
+        p = end;
+        break;
+    }
+    case 0xA2:                  // While
+        o = ex_while(s, &p, scope);
+        break;
+    case 0xA3:                  // Noop
+    case 0xCC:                  // BreakPoint
+        break;
+    case 0xA4:                  // Return
+        a = ex_operand(s, &p, scope);
+        if (a) {
+            ex_put(s->retval);
+            s->retval = a;
+            a = NULL;
+            s->flow = EX_FLOW_RETURN;
+        }
+        break;
+    case 0xA5:                  // Break
+        s->flow = EX_FLOW_BREAK;
+        break;
+    default: {
+        char detail[32];
+        
+        snprintf(detail, sizeof(detail), "opcode 0x%02x", op);
+        ex_fail(s, at, -EINVAL, "AE_AML_BAD_OPCODE", detail);
+        break;
+    }
+    }
+    
+    ex_put(a);
+    ex_put(b);
+    *pos = p;
+    if (s->error) {
+        ex_put(o);
+        return NULL;
+    }
+    return o;
+}
+
+/*
+ * Term lists. While loading, a failing term abandons the rest of its
+ * package only, the way the OS skips what it cannot parse.
+ */
+static void ex_exec_list(struct omen_aml_sandbox *s, uint32_t pos, uint32_t end,
+                         const char *scope) {
+    uint32_t saved_end = s->list_end;
+    
+    s->list_end = end;
+    while (pos < end && !s->error && !s->flow) {
+        ex_put(ex_eval(s, &pos, scope));
+    }
+    s->list_end = saved_end;
+    
+    if (s->loading && s->error) {
+        s->loading++;           // Counts skipped blocks, from 1
+        s->error = 0;
+    }
+}
+
+/*
+ * Setup
+ */
+static int ex_predefine(struct omen_aml_sandbox *s) {
+    static const char *const scopes[] = { "\\_GPE", "\\_PR_", "\\_SB_", "\\_SI_", "\\_TZ_" };
+    struct ex_node *n;
+    
+    s->int_bits = 64;
+    for (size_t i = 0; i < sizeof(scopes) / sizeof(scopes[0]); i++) {
+        n = ex_node(s, scopes[i]);
+        if (n) {
+            n->obj = ex_new(s, EX_DEVICE);
+        }
+    }
+    n = ex_node(s, "\\_OSI");
+    if (n && (n->obj = ex_new(s, EX_METHOD))) {
+        n->obj->method.args = 1;
+        n->obj->method.native = EX_NATIVE_OSI;
+    }
+    n = ex_node(s, "\\_OS_");
+    if (n) {
+        n->obj = ex_bytes_obj(s, EX_STR, "Microsoft Windows NT", 20);
+    }
+    n = ex_node(s, "\\_REV");
+    if (n) {
+        n->obj = ex_int(s, 2);
+    }
+    n = ex_node(s, "\\_GL_");
+    if (n) {
+        n->obj = ex_new(s, EX_MUTEX);
+    }
+    return s->error;
+}
+
+static void ex_load_table(struct omen_aml_sandbox *s, int index) {
+    const struct omen_aml_table *t = &s->ns->tables[index];
+    
+    s->aml = t->data;
+    s->size = t->length;
+    s->table = (uint16_t)index;
+    s->int_bits = t->data[8] >= 2 ? 64 : 32;
+    ex_exec_list(s, OMEN_AML_HEADER_SIZE, t->length, "\\");
+}
+
+// Call a method by path if it exists, during setup; failures only count
+static void ex_setup_call(struct omen_aml_sandbox *s, const char *path, uint64_t a0, uint64_t a1) {
+    struct ex_node *n = ex_find(s, path);
+    struct ex_obj *args[2];
+    
+    if (!n || !n->obj || n->obj->type != EX_METHOD) {
+        return;
+    }
+    args[0] = ex_int(s, a0);
+    args[1] = ex_int(s, a1);
+    ex_put(ex_call(s, n, args, n->obj->method.args < 2 ? n->obj->method.args : 2));
+    ex_put(args[0]);
+    ex_put(args[1]);
+    if (s->error) {
+        s->loading++;
+        s->error = 0;
+    }
+    s->flow = EX_FLOW_NONE;
+}
+
+// EC offsets to the field units covering them, for reports
+static void ex_map_ec_fields(struct omen_aml_sandbox *s) {
+    memset(s->ec_fields, 0, sizeof(s->ec_fields));
+    for (uint32_t i = 0; i < s->node_count; i++) {
+        struct ex_obj *o = s->nodes[i]->obj;
+        struct ex_obj *r;
+        
+        if (!o || o->type != EX_FIELD || o->field.kind == EX_FIELD_INDEX || !o->field.bits) {
+            continue;
+        }
+        r = o->field.region->obj;
+        if (!r || r->type != EX_REGION || (r->region.space != 3 &&
+                                           (r->region.space != 0 || !s->ec_window))) {
+            continue;
+        }
+        for (uint32_t b = o->field.bit / 8; b <= (o->field.bit + o->field.bits - 1) / 8; b++) {
+            uint64_t offset = r->region.base + b - (r->region.space == 3 ? 0 : s->ec_window);
+            
+            if (offset < OMEN_AML_EC_SIZE && !s->ec_fields[offset]) {
+                s->ec_fields[offset] = s->nodes[i]->path;
+            }
+        }
+    }
+}
+
+int omen_aml_sandbox_create(struct omen_aml_sandbox **out, const struct omen_aml_ns *ns,
+                            const uint8_t *ec_image) {
+    struct omen_aml_sandbox *s;
+    char message[sizeof(s->message)] = "";
+    int dsdt = -1;
+    
+    if (!out || !ns || !ns->table_count) {
+        return -EINVAL;
+    }
+    for (int i = 0; i < ns->table_count; i++) {
+        if (!ns->tables[i].data) {
+            return -ENODATA;    // An index has no AML
+        }
+    }
+    
+    s = calloc(1, sizeof(*s));
+    if (!s) {
+        return -ENOMEM;
+    }
+    s->ns = ns;
+    s->ec_latency_ns = OMEN_AML_EC_LATENCY_NS;
+    s->hash = calloc(EX_HASH_SIZE, sizeof(*s->hash));
+    s->events = calloc(OMEN_AML_MAX_EVENTS, sizeof(*s->events));
+    if (!s->hash || !s->events || ex_predefine(s)) {
+        omen_aml_sandbox_destroy(s);
+        return -ENOMEM;
+    }
+    if (ec_image) {
+        memcpy(s->ec, ec_image, sizeof(s->ec));
+    }
+    
+    // DSDT first, then the SSDTs in dump order
+    s->loading = 1;
+    for (int i = 0; i < ns->table_count; i++) {
+        if (strcmp(ns->tables[i].signature, "DSDT") == 0) {
+            dsdt = i;
+            ex_load_table(s, i);
+        }
+    }
+    for (int i = 0; i < ns->table_count; i++) {
+        if (i != dsdt) {
+            ex_load_table(s, i);
+        }
+    }
+    if (s->loading > 1) {
+        snprintf(message, sizeof(message), "%d blocks skipped while loading", s->loading - 1);
+    }
+    
+    // The OS connects its EC handler: _REG(EmbeddedControl, 1), then \_SB._INI
+    for (uint32_t i = 0; i < s->node_count; i++) {
+        struct ex_obj *o = s->nodes[i]->obj;
+        char reg[OMEN_AML_PATH_MAX];
+        char *dot;
+        
+        if (!o || o->type != EX_REGION || o->region.space != 3) {
+            continue;
+        }
+        snprintf(reg, sizeof(reg), "%s", s->nodes[i]->path);
+        dot = strrchr(reg, '.');
+        if (dot && (size_t)(dot - reg) + 6 <= sizeof(reg)) {
+            strcpy(dot, "._REG");
+            ex_setup_call(s, reg, 3, 1);
+        }
+    }
+    ex_setup_call(s, "\\_SB_._INI", 0, 0);
+    
+    ex_map_ec_fields(s);
+    
+    s->loading = 0;
+    snprintf(s->message, sizeof(s->message), "%s", message);
+    *out = s;
+    return 0;
+}
+
+void omen_aml_sandbox_destroy(struct omen_aml_sandbox *sb) {
+    if (!sb) {
+        return;
+    }
+    for (uint32_t i = 0; i < sb->node_count; i++) {
+        ex_put(sb->nodes[i]->obj);
+    }
+    for (uint32_t i = 0; i < sb->node_count; i++) {
+        free(sb->nodes[i]);
+    }
+    ex_put(sb->result);
+    ex_put(sb->retval);
+    free(sb->nodes);
+    free(sb->hash);
+    free(sb->pages);
+    free(sb->events);
+    free(sb);
+}
+
+void omen_aml_sandbox_set_ec_latency(struct omen_aml_sandbox *sb, uint64_t ns) {
+    sb->ec_latency_ns = ns;
+}
+
+void omen_aml_sandbox_map_ec(struct omen_aml_sandbox *sb, uint64_t address) {
+    sb->ec_window = address;
+    ex_map_ec_fields(sb);
+}
+
+uint64_t omen_aml_sandbox_find_ec_window(const struct omen_aml_sandbox *sb) {
+    const struct ex_node *ecmm = NULL;
+    uint32_t first = UINT32_MAX;
+    
+    for (uint32_t i = 0; i < sb->node_count; i++) {
+        const struct ex_obj *o = sb->nodes[i]->obj;
+        const struct ex_node *region;
+        size_t len;
+        
+        if (!o || o->type != EX_FIELD || o->field.kind == EX_FIELD_INDEX || !o->field.bits) {
+            continue;
+        }
+        region = o->field.region;
+        len = strlen(region->path);
+        if (!region->obj || region->obj->type != EX_REGION || region->obj->region.space != 0 ||
+            len < 5 || strcmp(region->path + len - 4, "ECMM") != 0 ||
+            (region->path[len - 5] != '.' && region->path[len - 5] != '\\')) {
+            continue;
+        }
+        // The first ECMM region with fields wins, \ECMM and EC0.ECMM alias anyway
+        if (!ecmm) {
+            ecmm = region;
+        }
+        if (region == ecmm && o->field.bit / 8 < first) {
+            first = o->field.bit / 8;
+        }
+    }
+    // Fields start past unused bytes (0x81f on the 8BD4), EC RAM windows are 256 aligned
+    return ecmm ? (ecmm->obj->region.base + first) & ~(uint64_t)(OMEN_AML_EC_SIZE - 1) : 0;
+}
+
+static struct ex_obj *ex_from_value(struct omen_aml_sandbox *s, const struct omen_aml_value *v) {
+    switch (v->type) {
+    case OMEN_AML_VALUE_INTEGER:
+        return ex_int(s, v->integer);
+    case OMEN_AML_VALUE_STRING:
+        return ex_bytes_obj(s, EX_STR, v->data, v->length);
+    case OMEN_AML_VALUE_BUFFER:
+        return ex_bytes_obj(s, EX_BUF, v->data, v->length);
+    }
+    return NULL;
+}
+
+int omen_aml_sandbox_call(struct omen_aml_sandbox *sb, const char *path,
+                          const struct omen_aml_value *args, int arg_count,
+                          struct omen_aml_value *result) {
+    struct ex_obj *objs[OMEN_AML_MAX_ARGS] = { 0 }, *ret;
+    char normalized[OMEN_AML_PATH_MAX];
+    struct ex_node *n;
+    uint64_t start;
+    int err;
+    
+    if (!sb || !path || arg_count < 0 || arg_count > OMEN_AML_MAX_ARGS) {
+        return -EINVAL;
+    }
+    memset(&sb->stats, 0, sizeof(sb->stats));
+    sb->event_count = 0;
+    sb->clock_ns = 0;
+    sb->error = 0;
+    sb->message[0] = '\0';
+    ex_put(sb->result);
+    sb->result = NULL;
+    
+    err = omen_aml_normalize_path(path, normalized, sizeof(normalized));
+    if (err) {
+        return err;
+    }
+    n = ex_find(sb, normalized);
+    if (!n || !n->obj || n->obj->type != EX_METHOD) {
+        snprintf(sb->message, sizeof(sb->message), "AE_NOT_FOUND (%s)", path);
+        return -ENOENT;
+    }
+    
+    // Arguments the caller leaves out stay uninitialized, as in ACPICA
+    sb->int_bits = 64;
+    for (int i = 0; i < arg_count; i++) {
+        objs[i] = ex_from_value(sb, &args[i]);
+        if (!objs[i]) {
+            for (int j = 0; j < i; j++) {
+                ex_put(objs[j]);
+            }
+            return sb->error ? sb->error : -EINVAL;
+        }
+    }
+    
+    start = ex_now_ns();
+    ret = ex_call(sb, n, objs, arg_count);
+    sb->stats.host_ns = ex_now_ns() - start;
+    sb->stats.firmware_ns = sb->stats.sleep_ns + sb->stats.stall_ns + sb->stats.ec_ns;
+    for (int i = 0; i < arg_count; i++) {
+        ex_put(objs[i]);
+    }
+    
+    if (!ret) {
+        return sb->error ? sb->error : -EIO;
+    }
+    sb->result = ret;
+    if (result) {
+        memset(result, 0, sizeof(*result));
+        switch (ret->type) {
+        case EX_INT:
+            result->type = OMEN_AML_VALUE_INTEGER;
+            result->integer = ret->integer;
+            break;
+        case EX_STR:
+        case EX_BUF:
+            result->type = ret->type == EX_STR ? OMEN_AML_VALUE_STRING : OMEN_AML_VALUE_BUFFER;
+            result->data = ret->buf.data;
+            result->length = ret->buf.length;
+            break;
+        case EX_PKG:
+            result->type = OMEN_AML_VALUE_PACKAGE;
+            result->length = ret->pkg.count;
+            break;
+        }
+    }
+    return 0;
+}
+
+const struct omen_aml_event *omen_aml_sandbox_events(const struct omen_aml_sandbox *sb,
+                                                     int *count) {
+    *count = sb->event_count;
+    return sb->events;
+}
+
+const struct omen_aml_stats *omen_aml_sandbox_stats(const struct omen_aml_sandbox *sb) {
+    return &sb->stats;
+}
+
+const uint8_t *omen_aml_sandbox_ec(const struct omen_aml_sandbox *sb) {
+    return sb->ec;
+}
+
+const char *omen_aml_sandbox_error(const struct omen_aml_sandbox *sb) {
+    return sb->message;
+}
+
+const char *omen_aml_sandbox_ec_field(const struct omen_aml_sandbox *sb, uint8_t offset) {
+    return sb->ec_fields[offset];
+}
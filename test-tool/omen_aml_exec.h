@@ -0,0 +1,147 @@
+/*
+ * OMEN AML Sandbox
+ *
+ * A small AML interpreter for replaying firmware calls offline. Tables
+ * come from omen_aml_load(); the definition blocks are executed into a
+ * private namespace the way the OS loads them (DSDT first, then SSDTs),
+ * and _REG runs for every EmbeddedControl region. Methods can then be
+ * called with real payloads.
+ *
+ * Operation regions are emulated: EmbeddedControl reads and writes 256
+ * bytes of EC RAM (seed it with an ec_before.bin snapshot), every other
+ * address space is sparse memory that reads as zero until written. Sleep,
+ * Stall and EC accesses advance a modelled firmware clock instead of
+ * waiting, so a call reports both what it did and what it would cost.
+ *
+ * Not covered: Load/LoadTable, Notify handlers, GPEs and real hardware.
+ * While loops are cut after a fixed number of iterations, so a status
+ * bit the emulation never sets cannot hang the run.
+ *
+ * All functions return 0 (or a positive count) on success and -errno on
+ * failure; omen_aml_sandbox_error() explains AML level failures. Nothing
+ * here prints.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#ifndef OMEN_AML_EXEC_H
+#define OMEN_AML_EXEC_H
+
+#include <stdint.h>
+
+#include "omen_aml.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMEN_AML_EC_SIZE        256
+#define OMEN_AML_LOOP_LIMIT     100000  // While iterations before a loop is cut
+#define OMEN_AML_MAX_EVENTS     4096    // Recorded per call, later ones are counted only
+#define OMEN_AML_EC_LATENCY_NS  50000   // Default modelled EC byte access, as hp_ec_safe_test
+
+// Arguments and results - data points into the caller's or sandbox's memory
+enum omen_aml_value_type {
+    OMEN_AML_VALUE_NONE = 0,
+    OMEN_AML_VALUE_INTEGER,
+    OMEN_AML_VALUE_STRING,
+    OMEN_AML_VALUE_BUFFER,
+    OMEN_AML_VALUE_PACKAGE,     // Only the element count is returned
+};
+
+struct omen_aml_value {
+    int type;                   // enum omen_aml_value_type
+    uint64_t integer;
+    const uint8_t *data;        // String or buffer bytes
+    uint32_t length;            // Bytes, or package elements
+};
+
+// What a call did, in order
+enum omen_aml_event_type {
+    OMEN_AML_EVENT_CALL = 1,    // path = method, value = argument count
+    OMEN_AML_EVENT_RETURN,      // path = method
+    OMEN_AML_EVENT_EC_READ,     // address = EC offset, value = byte
+    OMEN_AML_EVENT_EC_WRITE,    // address = EC offset, old_value -> value
+    OMEN_AML_EVENT_IO_WRITE,    // space and address of a non-EC region write, old_value -> value
+    OMEN_AML_EVENT_SLEEP,       // value = ms
+    OMEN_AML_EVENT_STALL,       // value = us
+    OMEN_AML_EVENT_NOTIFY,      // path = object, value = notification
+    OMEN_AML_EVENT_LOOP_CUT,    // path = method holding the While
+};
+
+struct omen_aml_event {
+    uint8_t type;               // enum omen_aml_event_type
+    uint8_t depth;              // Call depth
+    uint8_t space;              // Address space of IO_WRITE
+    uint8_t old_value;
+    uint64_t address;
+    uint64_t value;
+    uint64_t time_ns;           // Modelled firmware time at the event
+    const char *path;           // Valid while the sandbox lives
+};
+
+struct omen_aml_stats {
+    uint64_t terms;             // AML terms evaluated
+    uint64_t calls;             // Method invocations, nested ones included
+    uint64_t ec_reads;
+    uint64_t ec_writes;
+    uint64_t io_reads;          // Every other address space
+    uint64_t io_writes;
+    uint64_t sleep_ns;
+    uint64_t stall_ns;
+    uint64_t ec_ns;             // EC accesses times the modelled latency
+    uint64_t firmware_ns;       // Modelled total: sleep + stall + EC
+    uint64_t host_ns;           // Time the interpreter itself took
+    uint64_t events_dropped;    // Past OMEN_AML_MAX_EVENTS
+    int loops_cut;
+};
+
+struct omen_aml_sandbox;
+
+// ns needs loaded tables (not an index) and must outlive the sandbox; ec_image may be NULL
+int omen_aml_sandbox_create(struct omen_aml_sandbox **out, const struct omen_aml_ns *ns,
+                            const uint8_t *ec_image);
+void omen_aml_sandbox_destroy(struct omen_aml_sandbox *sb);
+
+// Modelled cost of one EC byte access, in ns
+void omen_aml_sandbox_set_ec_latency(struct omen_aml_sandbox *sb, uint64_t ns);
+
+/*
+ * Some boards also reach EC RAM through a SystemMemory window (ECMM on the
+ * 8BD4). SystemMemory bytes from address on are then EC RAM as well, with
+ * EC events and latency.
+ */
+void omen_aml_sandbox_map_ec(struct omen_aml_sandbox *sb, uint64_t address);
+
+/*
+ * The window an ECMM SystemMemory region maps EC RAM at: its first field
+ * unit rounded down to 256 bytes (0xfc7e0800 on the 8BD4). 0 if the tables
+ * have no such region.
+ */
+uint64_t omen_aml_sandbox_find_ec_window(const struct omen_aml_sandbox *sb);
+
+/*
+ * Run a method. Events and stats are reset first and describe only this
+ * call; result data stays valid until the next call.
+ */
+int omen_aml_sandbox_call(struct omen_aml_sandbox *sb, const char *path,
+                          const struct omen_aml_value *args, int arg_count,
+                          struct omen_aml_value *result);
+
+const struct omen_aml_event *omen_aml_sandbox_events(const struct omen_aml_sandbox *sb,
+                                                     int *count);
+const struct omen_aml_stats *omen_aml_sandbox_stats(const struct omen_aml_sandbox *sb);
+const uint8_t *omen_aml_sandbox_ec(const struct omen_aml_sandbox *sb);
+
+// Last AML error ("AE_AML_BUFFER_LIMIT in \\_SB.WMID.WHCM at SSDT+0x9c80")
+const char *omen_aml_sandbox_error(const struct omen_aml_sandbox *sb);
+
+// Name of the EC field covering an offset ("\\_SB.PCI0.LPC0.EC0.KBCL"), NULL if none
+const char *omen_aml_sandbox_ec_field(const struct omen_aml_sandbox *sb, uint8_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OMEN_AML_EXEC_H */
@@ -0,0 +1,296 @@
+/*
+ * OMEN AML Namespace Index
+ *
+ * Builds a persistent index of every named object in the DSDT/SSDTs of an
+ * acpidump and answers "does this method exist, and where" from it. This
+ * replaces live probing of candidate paths through /proc/acpi/call: no
+ * firmware is called, no root is needed, and lookups take microseconds.
+ *
+ *   omen_aml_index build acpidump.txt -o omen_aml.idx
+ *   omen_aml_index find omen_aml.idx WMID WQAB WMAA SECU KBCL
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _POSIX_C_SOURCE 199309L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "omen_aml.h"
+
+#define DEFAULT_INDEX   "omen_aml.idx"
+#define MAX_MATCHES     64
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void print_node(const struct omen_aml_ns *ns, const char *query,
+                       const struct omen_aml_node *node) {
+    const struct omen_aml_table *t = &ns->tables[node->table];
+    char path[OMEN_AML_PATH_MAX];
+    char detail[32] = "";
+    
+    omen_aml_display_path(node->path, path, sizeof(path));
+    if (node->type == OMEN_AML_METHOD ||
+        (node->type == OMEN_AML_EXTERNAL && node->flags == 8)) {
+        snprintf(detail, sizeof(detail), "%u arg%s", node->args, node->args == 1 ? "" : "s");
+    } else if (node->type == OMEN_AML_FIELD) {
+        snprintf(detail, sizeof(detail), "%u bits", node->length);
+    }
+    
+    printf("%-6s %-13s %-36s %-8s %s %-8s +0x%05x\n", query, omen_aml_type_name(node->type),
+           path, detail, t->signature, t->oem_table_id, node->offset);
+}
+
+static int cmd_build(int argc, char *argv[]) {
+    struct omen_aml_ns ns = { 0 };
+    const char *out = DEFAULT_INDEX;
+    int threads = 0, inputs = 0, ret;
+    uint64_t start;
+    
+    start = now_ns();
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else {
+            ret = omen_aml_load(&ns, argv[i]);
+            if (ret) {
+                printf("[ERROR] Cannot load %s: %s\n", argv[i], strerror(-ret));
+                omen_aml_free(&ns);
+                return 1;
+            }
+            inputs++;
+        }
+    }
+    if (!inputs) {
+        printf("[ERROR] No acpidump or table files given\n");
+        return 1;
+    }
+    
+    ret = omen_aml_build(&ns, threads);
+    if (ret < 0) {
+        printf("[ERROR] Cannot build namespace: %s\n", strerror(-ret));
+        omen_aml_free(&ns);
+        return 1;
+    }
+    printf("[INFO] %d tables, %u objects, %d skipped blocks, %.2f ms\n", ns.table_count,
+           ns.node_count, ns.parse_errors, (double)(now_ns() - start) / 1e6);
+    
+    ret = omen_aml_save_index(&ns, out);
+    omen_aml_free(&ns);
+    if (ret) {
+        printf("[ERROR] Cannot write %s: %s\n", out, strerror(-ret));
+        return 1;
+    }
+    printf("[INFO] Index written to %s\n", out);
+    return 0;
+}
+
+static int cmd_find(const char *index, int argc, char *argv[]) {
+    const struct omen_aml_node *matches[MAX_MATCHES];
+    struct omen_aml_ns ns = { 0 };
+    int missing = 0, ret;
+    uint64_t start;
+    
+    ret = omen_aml_open_index(&ns, index);
+    if (ret) {
+        printf("[ERROR] Cannot open index %s: %s\n", index, strerror(-ret));
+        return 1;
+    }
+    
+    start = now_ns();
+    for (int i = 0; i < argc; i++) {
+        const struct omen_aml_node *node;
+        int n;
+        
+        // A bare name segment lists every object with it, anything else is a path
+        if (strchr(argv[i], '.') || argv[i][0] == '\\') {
+            node = omen_aml_find_path(&ns, argv[i]);
+            n = node ? 1 : 0;
+            matches[0] = node;
+        } else {
+            n = omen_aml_find_segment(&ns, argv[i], matches, MAX_MATCHES);
+        }
+        
+        if (n <= 0) {
+            printf("%-6s %-13s\n", argv[i], "-");
+            missing++;
+        }
+        for (int m = 0; m < n && m < MAX_MATCHES; m++) {
+            print_node(&ns, argv[i], matches[m]);
+        }
+    }
+    printf("[INFO] %d lookups, %d not found, %.3f ms\n", argc, missing,
+           (double)(now_ns() - start) / 1e6);
+    
+    omen_aml_free(&ns);
+    return 0;
+}
+
+static int cmd_list(const char *index, const char *type) {
+    struct omen_aml_ns ns = { 0 };
+    int ret;
+    
+    ret = omen_aml_open_index(&ns, index);
+    if (ret) {
+        printf("[ERROR] Cannot open index %s: %s\n", index, strerror(-ret));
+        return 1;
+    }
+    for (uint32_t i = 0; i < ns.node_count; i++) {
+        const struct omen_aml_node *node = &ns.nodes[i];
+        
+        if (!type || strcasecmp(type, omen_aml_type_name(node->type)) == 0) {
+            print_node(&ns, "", node);
+        }
+    }
+    omen_aml_free(&ns);
+    return 0;
+}
+
+// Candidates from the driver and hp_acpi_safe_test; --method adds more
+static const char *const sig_methods[] = {
+    "WMAA", "WMBA", "WMBB", "WMBC", "WMBD", "WMBE", "SECU", "WRAM", "KBCL", "SKBL", NULL
+};
+
+static void print_signature(const struct omen_aml_ns *ns, const char *board,
+                            const struct omen_aml_node *method) {
+    struct omen_aml_signature sig;
+    char path[OMEN_AML_PATH_MAX], entry[OMEN_AML_PATH_MAX + 64], id[9];
+    int buffer_arg = -1, skipped;
+    
+    skipped = omen_aml_infer_signature(ns, method, &sig);
+    if (skipped < 0) {
+        printf("    // %s: %s\n", method->path, strerror(-skipped));
+        return;
+    }
+    for (int i = 0; i < sig.args; i++) {
+        if ((sig.arg_flags[i] & OMEN_AML_ARG_BUFFER) &&
+            (buffer_arg < 0 || sig.arg_size[i] > sig.arg_size[buffer_arg])) {
+            buffer_arg = i;
+        }
+    }
+    
+    // Board defaults to the OEM table ID; HP uses the DMI board name there
+    if (!board) {
+        snprintf(id, sizeof(id), "%s", ns->tables[method->table].oem_table_id);
+        id[strcspn(id, " ")] = '\0';
+        board = id;
+    }
+    
+    omen_aml_display_path(method->path, path, sizeof(path));
+    if (buffer_arg < 0) {
+        snprintf(entry, sizeof(entry), "{ \"%s\", \"\\\\%s\", %u, OMEN_ACPI_SIG_NO_BUFFER, 0, 0 },",
+                 board, path + 1, sig.args);
+        printf("    %s\n", entry);
+        return;
+    }
+    snprintf(entry, sizeof(entry), "{ \"%s\", \"\\\\%s\", %u, %d, %u, %d },", board, path + 1,
+             sig.args, buffer_arg, sig.arg_size[buffer_arg],
+             !!(sig.arg_flags[buffer_arg] & OMEN_AML_ARG_VARIABLE));
+    printf("    %-44s // Buffer in Arg%d%s%s\n", entry, buffer_arg,
+           sig.arg_flags[buffer_arg] & OMEN_AML_ARG_VARIABLE ? ", run-time sized fields" : "",
+           skipped ? ", body partly walked" : "");
+}
+
+static int cmd_sigs(int argc, char *argv[]) {
+    const struct omen_aml_node *matches[MAX_MATCHES];
+    const char *methods[MAX_MATCHES];
+    struct omen_aml_ns ns = { 0 };
+    const char *board = NULL;
+    int method_count = 0, ret;
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            board = argv[++i];
+        } else if (strcmp(argv[i], "--method") == 0 && i + 1 < argc) {
+            if (method_count < MAX_MATCHES) {
+                methods[method_count++] = argv[++i];
+            }
+        } else {
+            ret = omen_aml_load(&ns, argv[i]);
+            if (ret) {
+                printf("[ERROR] Cannot load %s: %s\n", argv[i], strerror(-ret));
+                omen_aml_free(&ns);
+                return 1;
+            }
+        }
+    }
+    for (int i = 0; !method_count && sig_methods[i]; i++) {
+        methods[i] = sig_methods[i];
+        if (!sig_methods[i + 1]) {
+            method_count = i + 1;
+        }
+    }
+    
+    ret = omen_aml_build(&ns, 0);
+    if (ret < 0) {
+        printf("[ERROR] Cannot build namespace: %s\n", strerror(-ret));
+        omen_aml_free(&ns);
+        return 1;
+    }
+    
+    // Entries for omen_acpi_sig.h
+    for (int i = 0; i < method_count; i++) {
+        int n;
+        
+        if (strchr(methods[i], '.') || methods[i][0] == '\\') {
+            matches[0] = omen_aml_find_path(&ns, methods[i]);
+            n = matches[0] ? 1 : 0;
+        } else {
+            n = omen_aml_find_segment(&ns, methods[i], matches, MAX_MATCHES);
+        }
+        for (int m = 0; m < n && m < MAX_MATCHES; m++) {
+            if (matches[m]->type == OMEN_AML_METHOD) {
+                print_signature(&ns, board, matches[m]);
+            }
+        }
+    }
+    
+    omen_aml_free(&ns);
+    return 0;
+}
+
+static void print_usage(const char* progname) {
+    printf("OMEN AML Namespace Index\n\n");
+    printf("Usage: %s build <acpidump.txt|table.dat>... [-o <index>] [--threads <n>]\n", progname);
+    printf("       %s find <index> <NAME|\\PATH>...\n", progname);
+    printf("       %s list <index> [type]\n", progname);
+    printf("       %s sigs <acpidump.txt|table.dat>... [--board <name>] [--method <NAME|\\PATH>]...\n\n",
+           progname);
+    printf("Input is acpidump text output or raw tables (acpidump -b, /sys/firmware/acpi/tables).\n");
+    printf("Default index: %s\n", DEFAULT_INDEX);
+    printf("sigs prints argument shapes as omen_acpi_sig.h entries.\n\n");
+    printf("Examples:\n");
+    printf("  %s build acpidump.txt\n", progname);
+    printf("  %s find %s WMID WQAB WMAA SECU KBCL\n", progname, DEFAULT_INDEX);
+    printf("  %s find %s \\_SB.WMID.WMAA\n", progname, DEFAULT_INDEX);
+    printf("  %s list %s method\n", progname, DEFAULT_INDEX);
+    printf("  %s sigs acpidump.txt\n", progname);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "build") == 0) {
+        return cmd_build(argc - 2, argv + 2);
+    }
+    if (argc >= 4 && strcmp(argv[1], "find") == 0) {
+        return cmd_find(argv[2], argc - 3, argv + 3);
+    }
+    if (argc >= 3 && strcmp(argv[1], "sigs") == 0) {
+        return cmd_sigs(argc - 2, argv + 2);
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "list") == 0) {
+        return cmd_list(argv[2], argc == 4 ? argv[3] : NULL);
+    }
+    print_usage(argv[0]);
+    return argc > 1 && strcmp(argv[1], "--help") != 0;
+}
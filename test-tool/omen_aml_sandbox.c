@@ -0,0 +1,545 @@
+/*
+ * OMEN AML Sandbox
+ *
+ * Replays firmware calls from an acpidump on any Linux box: the tables are
+ * loaded into the interpreter in omen_aml_exec.c, the EC operation region
+ * is 256 bytes of emulated RAM, and the call reports the methods it went
+ * through, every EC byte it wrote and what the firmware would spend on it.
+ * Nothing touches real hardware; no root is needed.
+ *
+ *   omen_aml_sandbox acpidump.txt --ec-image ec_before.bin \
+ *       \\_SB.WMID.WMAA 0 1 secu:laptop:ff0000
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _POSIX_C_SOURCE 199309L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "omen_aml_exec.h"
+#include "omen_acpi_sig.h"
+#include "omen_rgb_lib.h"
+
+#define MAX_BUFFER      OMEN_ACPI_SIG_MAX_BUFFER
+#define MAX_METHODS     256
+#define RESULT_BYTES    32      // Result bytes printed
+#define EC_WINDOW_AUTO  UINT64_MAX      // --ec-window not given: take it from ECMM
+
+struct run_options {
+    const char *ec_image;
+    const char *save_ec;
+    uint64_t ec_latency_ns;
+    uint64_t ec_window;         // 0 for none
+    int repeat;
+    int trace;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int read_ec_image(const char *path, uint8_t *ec) {
+    FILE *fp = fopen(path, "rb");
+    size_t got;
+    
+    if (!fp) {
+        printf("[ERROR] Cannot open EC image %s\n", path);
+        return -1;
+    }
+    got = fread(ec, 1, OMEN_AML_EC_SIZE, fp);
+    fclose(fp);
+    if (got != OMEN_AML_EC_SIZE) {
+        printf("[ERROR] %s: expected %d bytes, got %zu\n", path, OMEN_AML_EC_SIZE, got);
+        return -1;
+    }
+    return 0;
+}
+
+static int write_ec_image(const char *path, const uint8_t *ec) {
+    FILE *fp = fopen(path, "wb");
+    
+    if (!fp || fwrite(ec, 1, OMEN_AML_EC_SIZE, fp) != OMEN_AML_EC_SIZE) {
+        printf("[ERROR] Cannot write %s\n", path);
+        if (fp) {
+            fclose(fp);
+        }
+        return -1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Buffer size the board's signature asks for, from the tables' OEM IDs
+static int signature_size(const struct omen_aml_ns *ns, const char *method) {
+    for (int i = 0; i < ns->table_count; i++) {
+        const struct omen_acpi_sig *sig;
+        char board[9];
+        
+        snprintf(board, sizeof(board), "%s", ns->tables[i].oem_table_id);
+        board[strcspn(board, " ")] = '\0';
+        sig = omen_acpi_sig_find(board, method);
+        if (sig && sig->buffer_arg != OMEN_ACPI_SIG_NO_BUFFER) {
+            return sig->buffer_size;
+        }
+    }
+    return 0;
+}
+
+/*
+ * secu[:laptop|desktop][:RRGGBB][:size] - the SECU command the driver
+ * sends for a solid color, zero padded like the driver pads it
+ */
+static int parse_secu(const char *spec, int default_size, uint8_t *buf, uint32_t *length) {
+    struct omen_rgb_zone zones[OMEN_RGB_MAX_ZONES];
+    struct omen_secu_command cmd;
+    enum omen_layout layout = OMEN_LAYOUT_LAPTOP;
+    unsigned long color = 0xFFFFFF, size = default_size;
+    char copy[64], *field, *save = NULL;
+    int n = 0;
+    
+    snprintf(copy, sizeof(copy), "%s", spec);
+    for (field = strtok_r(copy, ":", &save); field; field = strtok_r(NULL, ":", &save), n++) {
+        if (n == 0) {
+            continue;           // "secu"
+        }
+        if (strcmp(field, "laptop") == 0) {
+            layout = OMEN_LAYOUT_LAPTOP;
+        } else if (strcmp(field, "desktop") == 0) {
+            layout = OMEN_LAYOUT_DESKTOP;
+        } else if (strlen(field) == 6 && strspn(field, "0123456789abcdefABCDEF") == 6) {
+            color = strtoul(field, NULL, 16);
+        } else {
+            size = strtoul(field, NULL, 0);
+        }
+    }
+    if (size < sizeof(cmd)) {
+        size = sizeof(cmd);
+    }
+    if (size > MAX_BUFFER) {
+        return -1;
+    }
+    
+    for (int i = 0; i < OMEN_RGB_MAX_ZONES; i++) {
+        zones[i].r = (uint8_t)(color >> 16);
+        zones[i].g = (uint8_t)(color >> 8);
+        zones[i].b = (uint8_t)color;
+    }
+    omen_encode_init(&cmd, layout);
+    omen_encode_frame(&cmd, layout, zones, omen_layout_zones(layout));
+    memset(buf, 0, size);
+    memcpy(buf, &cmd, sizeof(cmd));
+    *length = (uint32_t)size;
+    return 0;
+}
+
+// acpi_call argument syntax: 0x20009, 42, b0102ff, "text", plus secu:...
+static int parse_arg(const char *text, int secu_size, uint8_t *buf, struct omen_aml_value *v) {
+    char *end;
+    
+    memset(v, 0, sizeof(*v));
+    if (strncmp(text, "secu", 4) == 0 && (text[4] == '\0' || text[4] == ':')) {
+        v->type = OMEN_AML_VALUE_BUFFER;
+        v->data = buf;
+        return parse_secu(text, secu_size, buf, &v->length);
+    }
+    if (text[0] == 'b') {
+        size_t len = strlen(text + 1);
+        
+        if (len % 2 || len / 2 > MAX_BUFFER) {
+            return -1;
+        }
+        for (size_t i = 0; i < len / 2; i++) {
+            char byte[3] = { text[1 + 2 * i], text[2 + 2 * i], '\0' };
+            
+            if (!isxdigit((unsigned char)byte[0]) || !isxdigit((unsigned char)byte[1])) {
+                return -1;
+            }
+            buf[i] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+        v->type = OMEN_AML_VALUE_BUFFER;
+        v->data = buf;
+        v->length = (uint32_t)(len / 2);
+        return 0;
+    }
+    if (text[0] == '"') {
+        size_t len = strlen(text + 1);
+        
+        if (len && text[len] == '"') {
+            len--;
+        }
+        v->type = OMEN_AML_VALUE_STRING;
+        v->data = (const uint8_t *)text + 1;
+        v->length = (uint32_t)len;
+        return 0;
+    }
+    v->type = OMEN_AML_VALUE_INTEGER;
+    v->integer = strtoull(text, &end, 0);
+    return *text && !*end ? 0 : -1;
+}
+
+static const char *short_path(const char *path, char *out, size_t size) {
+    if (!path) {
+        return "-";
+    }
+    omen_aml_display_path(path, out, size);
+    return out;
+}
+
+static void print_value(const struct omen_aml_value *v) {
+    switch (v->type) {
+    case OMEN_AML_VALUE_INTEGER:
+        printf("0x%llx\n", (unsigned long long)v->integer);
+        break;
+    case OMEN_AML_VALUE_STRING:
+        printf("\"%.*s\"\n", (int)v->length, (const char *)v->data);
+        break;
+    case OMEN_AML_VALUE_BUFFER:
+        printf("buffer[%u]", v->length);
+        for (uint32_t i = 0; i < v->length && i < RESULT_BYTES; i++) {
+            printf(" %02x", v->data[i]);
+        }
+        printf("%s\n", v->length > RESULT_BYTES ? " ..." : "");
+        break;
+    case OMEN_AML_VALUE_PACKAGE:
+        printf("package[%u]\n", v->length);
+        break;
+    default:
+        printf("none\n");
+        break;
+    }
+}
+
+static void print_trace(const struct omen_aml_sandbox *sb) {
+    const struct omen_aml_event *events;
+    char path[OMEN_AML_PATH_MAX];
+    int count;
+    
+    events = omen_aml_sandbox_events(sb, &count);
+    for (int i = 0; i < count; i++) {
+        const struct omen_aml_event *e = &events[i];
+        int indent = 2 * e->depth;
+        
+        if (e->type == OMEN_AML_EVENT_RETURN) {
+            continue;
+        }
+        printf("  %10.3f ms  ", (double)e->time_ns / 1e6);
+        switch (e->type) {
+        case OMEN_AML_EVENT_CALL:
+            printf("%*s%s(%llu args)\n", indent, "", short_path(e->path, path, sizeof(path)),
+                   (unsigned long long)e->value);
+            break;
+        case OMEN_AML_EVENT_EC_READ:
+        case OMEN_AML_EVENT_EC_WRITE:
+            printf("%*s  EC %s 0x%02llx = 0x%02llx  %s\n", indent, "",
+                   e->type == OMEN_AML_EVENT_EC_READ ? "read " : "write",
+                   (unsigned long long)e->address, (unsigned long long)e->value,
+                   short_path(e->path, path, sizeof(path)));
+            break;
+        case OMEN_AML_EVENT_IO_WRITE:
+            printf("%*s  space %u write 0x%llx = 0x%02llx  %s\n", indent, "", e->space,
+                   (unsigned long long)e->address, (unsigned long long)e->value,
+                   short_path(e->path, path, sizeof(path)));
+            break;
+        case OMEN_AML_EVENT_SLEEP:
+        case OMEN_AML_EVENT_STALL:
+            printf("%*s  %s(%llu)\n", indent, "", e->type == OMEN_AML_EVENT_SLEEP ? "Sleep" :
+                   "Stall", (unsigned long long)e->value);
+            break;
+        case OMEN_AML_EVENT_NOTIFY:
+            printf("%*s  Notify(%s, 0x%llx)\n", indent, "", short_path(e->path, path, sizeof(path)),
+                   (unsigned long long)e->value);
+            break;
+        case OMEN_AML_EVENT_LOOP_CUT:
+            printf("%*s  While loop cut after %d iterations\n", indent, "", OMEN_AML_LOOP_LIMIT);
+            break;
+        }
+    }
+}
+
+// Methods in first-call order with call counts: the path the command took
+static void print_methods(const struct omen_aml_sandbox *sb) {
+    const struct omen_aml_event *events;
+    const char *paths[MAX_METHODS];
+    int counts[MAX_METHODS], depths[MAX_METHODS], used = 0, count;
+    char path[OMEN_AML_PATH_MAX];
+    
+    events = omen_aml_sandbox_events(sb, &count);
+    for (int i = 0; i < count; i++) {
+        int m;
+        
+        if (events[i].type != OMEN_AML_EVENT_CALL) {
+            continue;
+        }
+        for (m = 0; m < used && paths[m] != events[i].path; m++) {
+        }
+        if (m == used) {
+            if (used == MAX_METHODS) {
+                continue;
+            }
+            paths[m] = events[i].path;
+            depths[m] = events[i].depth;
+            counts[m] = 0;
+            used++;
+        }
+        counts[m]++;
+    }
+    
+    printf("Methods:\n");
+    for (int m = 0; m < used; m++) {
+        printf("  %*s%-*s x%d\n", 2 * depths[m], "", 40 - 2 * depths[m],
+               short_path(paths[m], path, sizeof(path)), counts[m]);
+    }
+}
+
+static void print_ec_writes(const struct omen_aml_sandbox *sb) {
+    const struct omen_aml_event *events;
+    char path[OMEN_AML_PATH_MAX];
+    int count, writes = 0;
+    
+    events = omen_aml_sandbox_events(sb, &count);
+    printf("EC writes:\n");
+    for (int i = 0; i < count; i++) {
+        const struct omen_aml_event *e = &events[i];
+        const char *field;
+        
+        if (e->type != OMEN_AML_EVENT_EC_WRITE) {
+            continue;
+        }
+        field = e->path ? e->path : omen_aml_sandbox_ec_field(sb, (uint8_t)e->address);
+        printf("  0x%02llx  %02x -> %02llx  %-32s %8.3f ms\n", (unsigned long long)e->address,
+               e->old_value, (unsigned long long)e->value, short_path(field, path, sizeof(path)),
+               (double)e->time_ns / 1e6);
+        writes++;
+    }
+    if (!writes) {
+        printf("  none\n");
+    }
+}
+
+// SystemMemory, SystemIO, CMOS... - where commands that bypass the EC land
+static void print_region_writes(const struct omen_aml_sandbox *sb) {
+    const struct omen_aml_event *events;
+    char path[OMEN_AML_PATH_MAX];
+    int count, writes = 0;
+    
+    events = omen_aml_sandbox_events(sb, &count);
+    for (int i = 0; i < count; i++) {
+        const struct omen_aml_event *e = &events[i];
+        
+        if (e->type != OMEN_AML_EVENT_IO_WRITE) {
+            continue;
+        }
+        if (!writes++) {
+            printf("Other region writes:\n");
+        }
+        printf("  space %u 0x%08llx  %02x -> %02llx  %-32s %8.3f ms\n", e->space,
+               (unsigned long long)e->address, e->old_value, (unsigned long long)e->value,
+               short_path(e->path, path, sizeof(path)), (double)e->time_ns / 1e6);
+    }
+}
+
+static void print_stats(const struct omen_aml_stats *st, uint64_t ec_latency_ns,
+                        uint64_t host_min, uint64_t host_total, int repeat) {
+    printf("Stats:\n");
+    printf("  AML terms:        %llu in %llu method calls\n", (unsigned long long)st->terms,
+           (unsigned long long)st->calls);
+    printf("  EC accesses:      %llu reads, %llu writes (%.0f us each)\n",
+           (unsigned long long)st->ec_reads, (unsigned long long)st->ec_writes,
+           (double)ec_latency_ns / 1e3);
+    printf("  Other regions:    %llu reads, %llu writes\n", (unsigned long long)st->io_reads,
+           (unsigned long long)st->io_writes);
+    printf("  Firmware time:    %.3f ms (EC %.3f, Sleep %.3f, Stall %.3f)\n",
+           (double)st->firmware_ns / 1e6, (double)st->ec_ns / 1e6, (double)st->sleep_ns / 1e6,
+           (double)st->stall_ns / 1e6);
+    printf("  Interpreter time: %.3f ms", (double)host_min / 1e6);
+    if (repeat > 1) {
+        printf(" best, %.3f ms mean of %d", (double)host_total / repeat / 1e6, repeat);
+    }
+    printf("\n");
+    if (st->loops_cut) {
+        printf("  [WARNING] %d While loop(s) cut after %d iterations\n", st->loops_cut,
+               OMEN_AML_LOOP_LIMIT);
+    }
+    if (st->events_dropped) {
+        printf("  [WARNING] %llu events past the first %d not recorded\n",
+               (unsigned long long)st->events_dropped, OMEN_AML_MAX_EVENTS);
+    }
+}
+
+static int run(struct omen_aml_ns *ns, const struct run_options *opt, const char *method,
+               int argc, char *argv[]) {
+    static uint8_t buffers[OMEN_AML_MAX_ARGS][MAX_BUFFER];
+    struct omen_aml_value args[OMEN_AML_MAX_ARGS], result;
+    struct omen_aml_sandbox *sb;
+    uint8_t ec[OMEN_AML_EC_SIZE];
+    uint64_t start, window, host_min = UINT64_MAX, host_total = 0;
+    int ret;
+    
+    if (argc > OMEN_AML_MAX_ARGS) {
+        printf("[ERROR] At most %d arguments\n", OMEN_AML_MAX_ARGS);
+        return 1;
+    }
+    for (int i = 0; i < argc; i++) {
+        if (parse_arg(argv[i], signature_size(ns, method), buffers[i], &args[i])) {
+            printf("[ERROR] Bad argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (opt->ec_image && read_ec_image(opt->ec_image, ec)) {
+        return 1;
+    }
+    
+    start = now_ns();
+    ret = omen_aml_sandbox_create(&sb, ns, opt->ec_image ? ec : NULL);
+    if (ret) {
+        printf("[ERROR] Cannot create sandbox: %s\n", strerror(-ret));
+        return 1;
+    }
+    printf("[INFO] %d tables loaded in %.2f ms%s%s\n", ns->table_count,
+           (double)(now_ns() - start) / 1e6, *omen_aml_sandbox_error(sb) ? ", " : "",
+           omen_aml_sandbox_error(sb));
+    omen_aml_sandbox_set_ec_latency(sb, opt->ec_latency_ns);
+    window = opt->ec_window;
+    if (window == EC_WINDOW_AUTO) {
+        window = omen_aml_sandbox_find_ec_window(sb);
+        if (window) {
+            printf("[INFO] EC RAM window 0x%llx from ECMM (--ec-window 0 turns it off)\n",
+                   (unsigned long long)window);
+        }
+    }
+    if (window) {
+        omen_aml_sandbox_map_ec(sb, window);
+    }
+    
+    // EC RAM carries over between repeats, like on the machine
+    for (int r = 0; r < opt->repeat; r++) {
+        ret = omen_aml_sandbox_call(sb, method, args, argc, &result);
+        if (ret) {
+            break;
+        }
+        host_total += omen_aml_sandbox_stats(sb)->host_ns;
+        if (omen_aml_sandbox_stats(sb)->host_ns < host_min) {
+            host_min = omen_aml_sandbox_stats(sb)->host_ns;
+        }
+    }
+    
+    printf("[INFO] %s(", method);
+    for (int i = 0; i < argc; i++) {
+        printf("%s%s", i ? ", " : "", argv[i]);
+    }
+    printf(")\n");
+    if (opt->trace) {
+        printf("Trace:\n");
+        print_trace(sb);
+    }
+    print_methods(sb);
+    print_ec_writes(sb);
+    print_region_writes(sb);
+    
+    if (ret) {
+        printf("[ERROR] Call failed: %s\n", *omen_aml_sandbox_error(sb) ?
+               omen_aml_sandbox_error(sb) : strerror(-ret));
+        omen_aml_sandbox_destroy(sb);
+        return 1;
+    }
+    printf("Result: ");
+    print_value(&result);
+    print_stats(omen_aml_sandbox_stats(sb), opt->ec_latency_ns, host_min, host_total,
+                opt->repeat);
+    if (!window && !omen_aml_sandbox_stats(sb)->ec_reads &&
+        !omen_aml_sandbox_stats(sb)->ec_writes && (omen_aml_sandbox_stats(sb)->io_reads ||
+                                                   omen_aml_sandbox_stats(sb)->io_writes)) {
+        printf("[WARNING] No EC accesses but other regions were used; if the board maps EC\n"
+               "          RAM into SystemMemory, pass its address with --ec-window\n");
+    }
+    
+    if (opt->save_ec && write_ec_image(opt->save_ec, omen_aml_sandbox_ec(sb)) == 0) {
+        printf("[INFO] EC RAM written to %s\n", opt->save_ec);
+    }
+    omen_aml_sandbox_destroy(sb);
+    return 0;
+}
+
+static void print_usage(const char* progname) {
+    printf("OMEN AML Sandbox\n\n");
+    printf("Usage: %s <acpidump.txt|table.dat>... <\\PATH> [args...] [options]\n\n", progname);
+    printf("Options may come anywhere on the command line.\n\n");
+    printf("Options:\n");
+    printf("  --ec-image F    Initial EC RAM, 256 bytes (e.g. ec_before.bin); zeros otherwise\n");
+    printf("  --ec-latency U  Modelled cost of one EC byte access in us (default 50)\n");
+    printf("  --ec-window A   SystemMemory address where the board maps EC RAM; taken from\n");
+    printf("                  an ECMM region by default, 0 for none\n");
+    printf("  --repeat N      Run the call N times, EC RAM carries over\n");
+    printf("  --trace         Print every call, EC access, Sleep and Stall\n");
+    printf("  --save-ec F     Write EC RAM after the call (ec_after.bin format)\n\n");
+    printf("Arguments, as acpi_call takes them:\n");
+    printf("  0x20009, 42     Integer\n");
+    printf("  b534543550900   Buffer\n");
+    printf("  '\"text\"'        String\n");
+    printf("  secu[:laptop|desktop][:RRGGBB][:size]\n");
+    printf("                  SECU command for a solid color, padded to the size in\n");
+    printf("                  omen_acpi_sig.h (or size)\n\n");
+    printf("Examples:\n");
+    printf("  %s acpidump.txt --ec-image ec_before.bin \\\\_SB.WMID.WMAA 0 1 secu:laptop:ff0000\n",
+           progname);
+    printf("  %s acpidump.txt --trace \\\\_SB.WMID.WMAA 0 1 secu:desktop:00ff00\n", progname);
+}
+
+int main(int argc, char *argv[]) {
+    struct run_options opt = { NULL, NULL, OMEN_AML_EC_LATENCY_NS, EC_WINDOW_AUTO, 1, 0 };
+    struct omen_aml_ns ns = { 0 };
+    char *method = NULL, *args[OMEN_AML_MAX_ARGS + 1];
+    int inputs = 0, arg_count = 0, bad = 0, ret;
+    
+    // Tables come before the method path and its arguments after it, options anywhere
+    for (int i = 1; i < argc && !bad; i++) {
+        if (strcmp(argv[i], "--ec-image") == 0 && i + 1 < argc) {
+            opt.ec_image = argv[++i];
+        } else if (strcmp(argv[i], "--ec-latency") == 0 && i + 1 < argc) {
+            opt.ec_latency_ns = strtoull(argv[++i], NULL, 0) * 1000;
+        } else if (strcmp(argv[i], "--ec-window") == 0 && i + 1 < argc) {
+            opt.ec_window = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            opt.repeat = atoi(argv[++i]);
+            if (opt.repeat < 1) {
+                opt.repeat = 1;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            opt.trace = 1;
+        } else if (strcmp(argv[i], "--save-ec") == 0 && i + 1 < argc) {
+            opt.save_ec = argv[++i];
+        } else if (argv[i][0] == '-') {
+            bad = 1;
+        } else if (method) {
+            if (arg_count <= OMEN_AML_MAX_ARGS) {   // One past the limit so run() reports it
+                args[arg_count++] = argv[i];
+            }
+        } else if (argv[i][0] == '\\' && inputs) {
+            method = argv[i];
+        } else {
+            ret = omen_aml_load(&ns, argv[i]);
+            if (ret) {
+                printf("[ERROR] Cannot load %s: %s\n", argv[i], strerror(-ret));
+                omen_aml_free(&ns);
+                return 1;
+            }
+            inputs++;
+        }
+    }
+    if (method && !bad) {
+        ret = run(&ns, &opt, method, arg_count, args);
+        omen_aml_free(&ns);
+        return ret;
+    }
+    omen_aml_free(&ns);
+    print_usage(argv[0]);
+    return argc > 1 && strcmp(argv[1], "--help") != 0;
+}
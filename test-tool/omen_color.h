@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * OMEN RGB Driver - named color palette internals
+ *
+ * Shared by omen_color_gen (build time) and the kernel module so both
+ * sides hash color names identically, with the key map's omen_phash().
+ * The hash folds ASCII case, so lookups need no lowercase copy.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v2 - included by the kernel module
+ */
+
+#ifndef OMEN_COLOR_H
+#define OMEN_COLOR_H
+
+#include "omen_phash.h"
+
+#define OMEN_COLOR_BUCKETS      64      // First level, power of two
+#define OMEN_COLOR_SLOTS        256     // Second level, power of two
+#define OMEN_COLOR_NAME_MAX     24      // Longest name plus NUL
+
+struct omen_color_entry {
+    const char *name;                   // Lowercase name, NULL for a free slot
+    uint8_t r, g, b;
+};
+
+// Names match case-insensitively
+static inline uint32_t omen_color_hash(const char *name, uint32_t seed)
+{
+    return omen_phash(name, seed, 1);
+}
+
+#endif /* OMEN_COLOR_H */
@@ -31,27 +31,89 @@
 #include <linux/capability.h>
 #include <linux/cred.h>
 #include <linux/rcupdate.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/timer.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/math64.h>
+#include <linux/hrtimer.h>
+#include <linux/fixp-arith.h>
+#include <linux/debugfs.h>
+#include <linux/random.h>
+
+#include "omen_rgb_ioctl.h"
+#include "omen_color.h"
+#include "omen_color_table.h"
+#include "omen_acpi_sig.h"
+
+#define CREATE_TRACE_POINTS
+#include "omen_rgb_trace.h"
 
 #define DRIVER_NAME "omen_rgb"
 #define DRIVER_VERSION "1.0.0-mainline"
 #define MAX_ZONES 4
-#define MAX_PROC_WRITE_SIZE 16
+#define MAX_PROC_WRITE_SIZE 128
 #define ACPI_TIMEOUT_MS 2000
 #define ACPI_MAX_RETRIES 3
+#define ACPI_SETTLE_DELAY_MS 20
+#define SHARED_READ_RETRIES 4
+#define SHARED_BUSY_RETRIES 8       // Backed-off dispatcher retries before a busy page is dropped
+#define RATE_TOKEN_SCALE 1000ULL    // Bucket holds milli-tokens
+#define RATE_LIMIT_MAX 100          // Bound for max_command_rate and burst_size
+#define ACPI_RESULT_SIZE 128        // Largest payload SECU hands back
+#define OMEN_HIST_BUCKETS 32        // log2 buckets, the last one open-ended
+#define WMAA_INSTANCE 0             // WMAA Arg0 - WMI instance
+#define WMAA_METHOD_NO_OUTPUT 1     // WMAA Arg1 - HP method id, no result buffer
 
 // Module parameters
 static unsigned int max_command_rate = 3;
 module_param(max_command_rate, uint, 0644);
-MODULE_PARM_DESC(max_command_rate, "Maximum RGB commands per second (default: 3)");
+MODULE_PARM_DESC(max_command_rate, "Maximum RGB commands per second, 1-100 (default: 3)");
+
+static unsigned int burst_size = 3;
+module_param(burst_size, uint, 0644);
+MODULE_PARM_DESC(burst_size, "Commands that may be sent back to back, 1-100 (default: 3)");
 
 static unsigned int debug_level = 0;
 module_param(debug_level, uint, 0644);
 MODULE_PARM_DESC(debug_level, "Debug level: 0=off, 1=info, 2=verbose (default: 0)");
 
+static bool suppress_redundant = true;
+module_param(suppress_redundant, bool, 0644);
+MODULE_PARM_DESC(suppress_redundant, "Skip frames the hardware already shows (default: true)");
+
 static bool strict_permissions = true;
 module_param(strict_permissions, bool, 0644);
 MODULE_PARM_DESC(strict_permissions, "Require CAP_SYS_ADMIN for write access (default: true)");
 
+static char *backend = "acpi";
+module_param(backend, charp, 0444);
+MODULE_PARM_DESC(backend, "Hardware backend: acpi or mock (default: acpi)");
+
+static unsigned int mock_latency_us = 20000;
+module_param(mock_latency_us, uint, 0644);
+MODULE_PARM_DESC(mock_latency_us, "Mock backend: base call latency in us (default: 20000)");
+
+static unsigned int mock_jitter_us = 0;
+module_param(mock_jitter_us, uint, 0644);
+MODULE_PARM_DESC(mock_jitter_us, "Mock backend: random extra latency up to this many us (default: 0)");
+
+static unsigned int mock_fail_pct = 0;
+module_param(mock_fail_pct, uint, 0644);
+MODULE_PARM_DESC(mock_fail_pct, "Mock backend: percentage of calls that fail (default: 0)");
+
+static unsigned int mock_zones = MAX_ZONES;
+module_param(mock_zones, uint, 0444);
+MODULE_PARM_DESC(mock_zones, "Mock backend: 1 for a laptop, 4 for a desktop (default: 4)");
+
+static unsigned int segments = 0;
+module_param(segments, uint, 0444);
+MODULE_PARM_DESC(segments, "Addressable RGB segments, up to 40 (default: 0 = model default)");
+
 // Debug macros with proper formatting
 #define omen_dbg(level, fmt, ...) \
     do { \
@@ -86,6 +148,30 @@ static const struct rgb_color colors[COLOR_MAX] = {
     [COLOR_BLACK] = {0x00, 0x00, 0x00, "black"},
 };
 
+// One lighting frame - a color per zone, or per segment when segment_count
+// is set. Zone frames reach segments through the device's segment map.
+struct omen_frame {
+    struct omen_rgb_zone zones[MAX_ZONES];
+    struct omen_rgb_zone segments[OMEN_RGB_MAX_SEGMENTS];
+    u8 segment_count;                    // 0 for a zone frame
+};
+
+// Lighting layout per chassis, matched on the DMI product name
+struct omen_model {
+    const char *match;                   // NULL matches any other product
+    u8 zone_count;
+    u8 segment_count;                    // RGB triplets the firmware reads
+};
+
+static const struct omen_model omen_models[] = {
+    { "Desktop", MAX_ZONES, MAX_ZONES },
+    { "GT",      MAX_ZONES, MAX_ZONES },
+    { "25L",     MAX_ZONES, MAX_ZONES },
+    { "30L",     MAX_ZONES, MAX_ZONES },
+    { "45L",     MAX_ZONES, MAX_ZONES },
+    { NULL,      1,         1 },          // Laptops
+};
+
 // ACPI command structure
 struct omen_acpi_command {
     char magic[4];           // "SECU"
@@ -97,11 +183,52 @@ struct omen_acpi_command {
     u8 rgb_data[120];        // RGB data
 } __packed;
 
-// Thread-safe rate limiter
+// Token bucket rate limiter - refills continuously at max_command_rate
 struct rate_limiter {
-    atomic_t count;
-    atomic64_t last_reset_jiffies;
-    struct mutex lock;
+    spinlock_t lock;                     // Protects tokens and last_refill_ns
+    u64 tokens;                          // Milli-tokens, capped at burst_size
+    u64 last_refill_ns;
+    struct timer_list refill_timer;      // Wakes writers when a token is due
+    atomic64_t deferred;                 // Dispatcher runs that had to wait
+    atomic64_t rejected;                 // O_NONBLOCK writers turned away
+};
+
+struct omen_device;
+
+// Hardware access - everything above the backend runs unchanged on the mock
+struct omen_backend {
+    const char *name;
+    // Identify the device and fill name, zone count and handle
+    int (*detect)(struct omen_device *dev);
+    // Run the prepared SECU command, result in output
+    acpi_status (*evaluate)(struct omen_device *dev, struct acpi_buffer *output);
+};
+
+// log2 histogram - bucket 0 holds zero, bucket n holds [2^(n-1), 2^n)
+struct omen_hist {
+    atomic64_t buckets[OMEN_HIST_BUCKETS];
+    atomic64_t count;
+    atomic64_t sum;
+};
+
+enum omen_hist_id {
+    OMEN_HIST_ACPI_EVAL = 0,             // ns per acpi_evaluate_object attempt
+    OMEN_HIST_MUTEX_WAIT,                // ns waiting for acpi_lock
+    OMEN_HIST_QUEUE_WAIT,                // ns from submit to dispatch
+    OMEN_HIST_RETRIES,                   // Retries per firmware command
+    OMEN_HIST_RATE_DEFERRALS,            // Rate limit deferrals per command
+    OMEN_HIST_MAX
+};
+
+static const struct {
+    const char *name;
+    const char *unit;
+} omen_hist_info[OMEN_HIST_MAX] = {
+    [OMEN_HIST_ACPI_EVAL]      = { "acpi_eval",      "ns" },
+    [OMEN_HIST_MUTEX_WAIT]     = { "mutex_wait",     "ns" },
+    [OMEN_HIST_QUEUE_WAIT]     = { "queue_wait",     "ns" },
+    [OMEN_HIST_RETRIES]        = { "retries",        "count" },
+    [OMEN_HIST_RATE_DEFERRALS] = { "rate_deferrals", "count" },
 };
 
 // Device state enum for clear state management
@@ -120,34 +247,93 @@ struct omen_device {
     struct rcu_head rcu;                 // RCU cleanup
     
     // Device identification
+    const struct omen_backend *backend;
     acpi_handle acpi_handle;
     char acpi_path[32];
     char device_name[48];
     bool is_desktop;
     int zone_count;
+    int segment_count;                   // Triplets packed per call, >= zone_count
+    u8 segment_zone[OMEN_RGB_MAX_SEGMENTS]; // Zone each segment shows in zone frames
     
     // State management - atomic for lockless access
     atomic_t state;                      // enum device_state
     
     // Synchronization primitives
-    struct mutex acpi_lock;             // Protects ACPI operations
+    struct mutex acpi_lock;             // Protects ACPI operations and buffers
+    
+    // Reusable ACPI call buffers - header built once, zones patched per call
+    struct omen_acpi_command *cmd;       // cmd_inline, or zero padded to the board's signature
+    struct omen_acpi_command cmd_inline;
+    const struct omen_acpi_sig *sig;     // SECU signature of this board, NULL if unlisted
+    bool wmaa;                           // Board has no SECU - buffer goes to WMAA as Arg2
+    union acpi_object params[3];         // SECU: buffer; WMAA: instance, method id, buffer
+    struct acpi_object_list args;
+    u8 result[sizeof(union acpi_object) + ACPI_RESULT_SIZE] __aligned(8);
     
     // Rate limiting
     struct rate_limiter limiter;
     
+    // Asynchronous command dispatch - the worker owns the ACPI handle
+    struct workqueue_struct *cmd_wq;
+    struct delayed_work cmd_work;
+    spinlock_t pending_lock;             // Protects pending - BH-safe for the effect timer
+    struct omen_frame pending;           // Latest request
+    bool pending_valid;                  // False when the dispatcher is idle
+    bool pending_shared;                 // Read the frame from the shared page
+    u64 pending_since_ns;                // Submit time of the oldest request
+    u32 dispatch_deferrals;              // Dispatcher only - reset per command
+    u32 shared_busy_retries;             // Dispatcher only - shared page found mid-update
+    struct omen_frame last_frame;        // Last frame handed over or read from the shared page - base for zone= writes
+    
+    // Synchronous commits - every request gets a ticket, the dispatcher
+    // publishes the ticket and result of each request it finishes
+    u64 next_ticket;                     // Under pending_lock
+    u64 pending_ticket;                  // Under pending_lock
+    u64 done_ticket;                     // Under pending_lock
+    int done_ret;                        // Under pending_lock
+    wait_queue_head_t commit_wait;
+    
     // Proc interface
     struct proc_dir_entry *proc_entry;
     
+    // Debugfs latency histograms
+    struct dentry *debugfs_dir;
+    struct omen_hist hist[OMEN_HIST_MAX];
+    
+    // Character device interface
+    struct miscdevice misc;
+    bool misc_registered;
+    struct omen_rgb_shared *shared;      // mmap'd frame page
+    
+    // Effect engine - effect is only rewritten while the timer is stopped
+    struct hrtimer effect_timer;
+    struct mutex effect_lock;            // Serializes effect start/stop
+    struct omen_rgb_effect effect;
+    u64 effect_start_ns;
+    bool effect_running;
+    
+    // Last frame the firmware accepted - only touched by the dispatcher
+    struct omen_frame committed;
+    bool committed_valid;
+    
     // Debug counters
     atomic_t ref_count_debug;
     atomic64_t command_count;
     atomic64_t error_count;
+    atomic64_t coalesced_count;
+    atomic64_t cache_hits;
+    atomic64_t cache_misses;
 } __aligned(8);
 
 // Global device pointer with RCU protection
 static struct omen_device __rcu *global_omen_dev = NULL;
 static DEFINE_SPINLOCK(global_dev_lock);
 
+// Writers and pollers waiting for a free slot - global so it outlives the
+// device for anyone still sleeping on it during removal
+static DECLARE_WAIT_QUEUE_HEAD(omen_slot_wait);
+
 /* forward declaration used by kref_put in get_device_safe() */
 static void device_release(struct kref *kref);
 
@@ -200,12 +386,22 @@ static struct omen_device *get_device_safe(void)
     return dev;
 }
 
+// Padded SECU buffer, when the board's signature needed one
+static void free_acpi_command(struct omen_device *dev)
+{
+    if (dev->cmd != &dev->cmd_inline)
+        kfree(dev->cmd);
+}
+
 // RCU callback for safe device cleanup
 static void device_rcu_cleanup(struct rcu_head *rcu)
 {
     struct omen_device *dev = container_of(rcu, struct omen_device, rcu);
     
     omen_info("Device RCU cleanup completed\n");
+    // Drops the driver's reference - still mapped pages go at the last unmap
+    free_page((unsigned long)dev->shared);
+    free_acpi_command(dev);
     kfree(dev);
 }
 
@@ -234,42 +430,131 @@ static void put_device_safe(struct omen_device *dev)
     }
 }
 
-// Enhanced rate limiting with atomic operations
-static bool check_rate_limit(struct omen_device *dev)
+// Lockless - concurrent readers may see a sample half recorded
+static void omen_hist_record(struct omen_device *dev, enum omen_hist_id id,
+                             u64 value)
 {
-    u64 now_jiffies = get_jiffies_64();
-    u64 last_reset;
-    int current_count;
-    
-    if (!dev || !is_device_ready(dev))
-        return false;
+    struct omen_hist *hist = &dev->hist[id];
     
-    // Lockless rate limiting using atomic operations
-    last_reset = atomic64_read(&dev->limiter.last_reset_jiffies);
+    atomic64_inc(&hist->buckets[min_t(int, fls64(value), OMEN_HIST_BUCKETS - 1)]);
+    atomic64_inc(&hist->count);
+    atomic64_add(value, &hist->sum);
+}
+
+static void omen_hist_reset(struct omen_device *dev)
+{
+    int i, b;
     
-    // Reset counter if more than 1 second has passed
-    if (now_jiffies - last_reset > HZ) {
-        // Try to update the reset time atomically
-        if (atomic64_cmpxchg(&dev->limiter.last_reset_jiffies, 
-                            last_reset, now_jiffies) == last_reset) {
-            atomic_set(&dev->limiter.count, 0);
-            omen_dbg(2, "Rate limiter reset\n");
-        }
+    for (i = 0; i < OMEN_HIST_MAX; i++) {
+        for (b = 0; b < OMEN_HIST_BUCKETS; b++)
+            atomic64_set(&dev->hist[i].buckets[b], 0);
+        atomic64_set(&dev->hist[i].count, 0);
+        atomic64_set(&dev->hist[i].sum, 0);
+    }
+}
+
+// Both parameters are writable at run time - clamp on every use, the
+// refill arithmetic relies on the bounds
+static u64 rate_limit_rate(void)
+{
+    return clamp_t(unsigned int, READ_ONCE(max_command_rate), 1, RATE_LIMIT_MAX);
+}
+
+static u64 rate_limit_cap(void)
+{
+    return (u64)clamp_t(unsigned int, READ_ONCE(burst_size), 1, RATE_LIMIT_MAX) *
+           RATE_TOKEN_SCALE;
+}
+
+// Add the milli-tokens earned since the last refill - limiter.lock held.
+// last_refill_ns only advances by the time the granted tokens account for,
+// so frequent callers (poll, /proc reads) do not lose the remainder.
+static void rate_limit_refill(struct rate_limiter *limiter)
+{
+    u64 now_ns = ktime_get_ns();
+    u64 cap = rate_limit_cap();
+    u64 rate = rate_limit_rate();
+    u64 elapsed = now_ns - limiter->last_refill_ns;
+    u64 added;
+    
+    // Anything past the time to fill from empty is irrelevant - avoids overflow
+    elapsed = min_t(u64, elapsed, (cap / RATE_TOKEN_SCALE) * NSEC_PER_SEC);
+    added = div64_u64(elapsed * rate * RATE_TOKEN_SCALE, NSEC_PER_SEC);
+    
+    // A full bucket banks no time
+    if (limiter->tokens + added >= cap) {
+        limiter->tokens = cap;
+        limiter->last_refill_ns = now_ns;
+        return;
     }
     
-    // Atomically increment and check
-    current_count = atomic_inc_return(&dev->limiter.count);
-    if (current_count <= max_command_rate) {
-        omen_dbg(2, "Rate limit check passed (%d/%u)\n", 
-                current_count, max_command_rate);
-        return true;
-    } else {
-        // Rollback the increment
-        atomic_dec(&dev->limiter.count);
-        atomic64_inc(&dev->error_count);
-        omen_warn("Rate limit exceeded (%d/%u)\n", current_count - 1, max_command_rate);
+    limiter->tokens += added;
+    limiter->last_refill_ns += div64_u64(added * NSEC_PER_SEC, rate * RATE_TOKEN_SCALE);
+}
+
+// Jiffies until a whole token is available - limiter.lock held
+static unsigned long rate_limit_wait_locked(struct rate_limiter *limiter)
+{
+    u64 rate = rate_limit_rate();
+    u64 missing;
+    
+    if (limiter->tokens >= RATE_TOKEN_SCALE)
+        return 0;
+    
+    missing = RATE_TOKEN_SCALE - limiter->tokens;
+    return nsecs_to_jiffies(div64_u64(missing * NSEC_PER_SEC,
+                                      rate * RATE_TOKEN_SCALE)) + 1;
+}
+
+// Take one token for the firmware call carrying frame
+static bool check_rate_limit(struct omen_device *dev, const struct omen_frame *frame)
+{
+    struct rate_limiter *limiter;
+    unsigned long wait;
+    bool allowed;
+    
+    if (!dev || !is_device_ready(dev))
         return false;
+    
+    limiter = &dev->limiter;
+    spin_lock(&limiter->lock);
+    rate_limit_refill(limiter);
+    allowed = limiter->tokens >= RATE_TOKEN_SCALE;
+    if (allowed)
+        limiter->tokens -= RATE_TOKEN_SCALE;
+    trace_omen_rgb_rate_limit(frame->zones, dev->zone_count, allowed, 0,
+                              limiter->tokens);
+    
+    // Bucket is empty - make sure sleepers hear about the next token
+    wait = rate_limit_wait_locked(limiter);
+    if (wait)
+        mod_timer(&limiter->refill_timer, jiffies + wait);
+    spin_unlock(&limiter->lock);
+    
+    if (!allowed) {
+        atomic64_inc(&limiter->deferred);
+        omen_dbg(2, "Rate limit reached, dispatch deferred\n");
     }
+    
+    return allowed;
+}
+
+// Jiffies until the rate limiter grants the next token
+static unsigned long rate_limit_wait_jiffies(struct omen_device *dev)
+{
+    unsigned long wait;
+    
+    spin_lock(&dev->limiter.lock);
+    rate_limit_refill(&dev->limiter);
+    wait = rate_limit_wait_locked(&dev->limiter);
+    spin_unlock(&dev->limiter.lock);
+    
+    return max(wait, 1UL);
+}
+
+static void rate_limit_refill_timer(struct timer_list *t)
+{
+    wake_up_interruptible(&omen_slot_wait);
 }
 
 // Permission check
@@ -289,20 +574,40 @@ static bool check_write_permission(void)
     return false;
 }
 
-// Safe ACPI command preparation
-static int prepare_acpi_command(struct omen_device *dev,
-                               const struct rgb_color *color,
-                               struct omen_acpi_command *cmd)
+// Spread the segments evenly over the zones, in order, so zone frames
+// light a multi-LED strip the same way the firmware's own zones do
+static void omen_init_segment_map(struct omen_device *dev)
 {
     int i;
     
-    if (!dev || !is_device_ready(dev) || !color || !cmd) {
-        omen_err("Invalid parameters for ACPI command preparation\n");
-        return -EINVAL;
-    }
+    if (segments)
+        dev->segment_count = max_t(int, segments, dev->zone_count);
     
-    // Clear command structure
-    memset(cmd, 0, sizeof(*cmd));
+    for (i = 0; i < dev->segment_count; i++)
+        dev->segment_zone[i] = i * dev->zone_count / dev->segment_count;
+    
+    omen_dbg(1, "Segment map: %d segments over %d zones\n",
+            dev->segment_count, dev->zone_count);
+}
+
+// Safe ACPI command preparation
+// Build the fixed part of the device's ACPI call once, at probe
+static int init_acpi_command(struct omen_device *dev)
+{
+    u32 length = sizeof(struct omen_acpi_command);
+    struct omen_acpi_command *cmd;
+    
+    // Only a signature that indexes past the command needs a padded buffer
+    if (dev->sig && dev->sig->buffer_size > length) {
+        length = dev->sig->buffer_size;
+        dev->cmd = kzalloc(length, GFP_KERNEL);
+        if (!dev->cmd)
+            return -ENOMEM;
+    } else {
+        dev->cmd = &dev->cmd_inline;
+        memset(dev->cmd, 0, sizeof(*dev->cmd));
+    }
+    cmd = dev->cmd;
     
     // Set ACPI command fields
     memcpy(cmd->magic, "SECU", 4);
@@ -313,81 +618,102 @@ static int prepare_acpi_command(struct omen_device *dev,
         cmd->sub_command = 0x0B;
         cmd->extended_flags = 0x40000000;
         cmd->additional_flags = 0x40000;
-        
-        // Set color for all zones with strict bounds checking
-        for (i = 0; i < MAX_ZONES; i++) {
-            size_t offset = i * 3;
-            if (offset + 2 >= sizeof(cmd->rgb_data)) {
-                omen_err("RGB data buffer overflow prevented\n");
-                return -EOVERFLOW;
-            }
-            cmd->rgb_data[offset + 0] = color->r;
-            cmd->rgb_data[offset + 1] = color->g;
-            cmd->rgb_data[offset + 2] = color->b;
-        }
-        omen_dbg(1, "Desktop ACPI command prepared for %d zones\n", MAX_ZONES);
     } else {
         cmd->sub_command = 0x07;
         cmd->extended_flags = 0x1000000;
         cmd->additional_flags = 0x00;
+    }
+    
+    // The buffer is always the last argument
+    if (dev->wmaa) {
+        dev->params[0].type = ACPI_TYPE_INTEGER;
+        dev->params[0].integer.value = WMAA_INSTANCE;
+        dev->params[1].type = ACPI_TYPE_INTEGER;
+        dev->params[1].integer.value = WMAA_METHOD_NO_OUTPUT;
+        dev->args.count = 3;
+    } else {
+        dev->args.count = 1;
+    }
+    dev->params[dev->args.count - 1].type = ACPI_TYPE_BUFFER;
+    dev->params[dev->args.count - 1].buffer.length = length;
+    dev->params[dev->args.count - 1].buffer.pointer = (u8 *)cmd;
+    dev->args.pointer = dev->params;
+    return 0;
+}
+
+
+// Patch the segment triplets that differ from the previous call in one pass
+// over the segment map - acpi_lock held
+static int prepare_acpi_command(struct omen_device *dev,
+                               const struct omen_frame *frame,
+                               struct omen_acpi_command *cmd)
+{
+    const struct omen_rgb_zone *color;
+    int i, dirty = 0;
+    
+    if (!dev || !is_device_ready(dev) || !frame || !cmd) {
+        omen_err("Invalid parameters for ACPI command preparation\n");
+        return -EINVAL;
+    }
+    
+    if (dev->segment_count * 3 > sizeof(cmd->rgb_data)) {
+        omen_err("RGB data buffer overflow prevented\n");
+        return -EOVERFLOW;
+    }
+    
+    for (i = 0; i < dev->segment_count; i++) {
+        u8 *rgb = &cmd->rgb_data[i * 3];
         
-        // Single zone with bounds checking
-        if (sizeof(cmd->rgb_data) < 3) {
-            omen_err("RGB data buffer too small\n");
-            return -EOVERFLOW;
-        }
-        cmd->rgb_data[0] = color->r;
-        cmd->rgb_data[1] = color->g;
-        cmd->rgb_data[2] = color->b;
-        omen_dbg(1, "Laptop ACPI command prepared\n");
+        color = frame->segment_count ? &frame->segments[i] :
+                                       &frame->zones[dev->segment_zone[i]];
+        if (rgb[0] == color->r && rgb[1] == color->g && rgb[2] == color->b)
+            continue;
+        
+        rgb[0] = color->r;
+        rgb[1] = color->g;
+        rgb[2] = color->b;
+        dirty++;
     }
     
-    omen_dbg(2, "ACPI command prepared: R=%u G=%u B=%u\n", 
-            color->r, color->g, color->b);
+    omen_dbg(2, "ACPI command prepared: %d/%d segments changed, zone0 R=%u G=%u B=%u\n",
+            dirty, dev->segment_count, frame->zones[0].r, frame->zones[0].g,
+            frame->zones[0].b);
     
     return 0;
 }
 
+// Errors decided by the call's shape, not by firmware timing - retrying cannot help
+static bool omen_acpi_error_is_final(acpi_status status)
+{
+    return status == AE_NOT_FOUND || status == AE_AML_BUFFER_LIMIT ||
+           status == AE_AML_UNINITIALIZED_ARG || status == AE_AML_OPERAND_TYPE;
+}
+
 // Enhanced ACPI command execution
 static int send_acpi_command_with_retry(struct omen_device *dev, 
-                                       const struct rgb_color *color)
+                                       const struct omen_frame *frame)
 {
-    struct omen_acpi_command cmd;
-    struct acpi_object_list args;
-    union acpi_object params[1];
-    struct acpi_buffer output = {ACPI_ALLOCATE_BUFFER, NULL};
+    struct acpi_buffer output;
     acpi_status status;
-    int ret, retry;
+    int ret, retry, attempts = 0;
     ktime_t start_time, end_time;
+    u64 attempt_ns, wait_ns;
     
-    if (!dev || !is_device_ready(dev) || !color) {
+    if (!dev || !is_device_ready(dev) || !frame) {
         omen_err("Invalid parameters for ACPI command\n");
         return -EINVAL;
     }
     
-    if (!check_write_permission()) {
-        atomic64_inc(&dev->error_count);
-        return -EPERM;
-    }
-    
-    if (!check_rate_limit(dev)) {
-        return -EAGAIN;
-    }
-    
-    // Prepare command
-    ret = prepare_acpi_command(dev, color, &cmd);
-    if (ret) {
-        omen_err("Failed to prepare ACPI command: %d\n", ret);
-        atomic64_inc(&dev->error_count);
-        return ret;
-    }
-    
     // Lock ACPI access
+    start_time = ktime_get();
     if (mutex_lock_interruptible(&dev->acpi_lock)) {
         omen_warn("ACPI mutex lock interrupted\n");
         atomic64_inc(&dev->error_count);
         return -EINTR;
     }
+    wait_ns = ktime_to_ns(ktime_sub(ktime_get(), start_time));
+    omen_hist_record(dev, OMEN_HIST_MUTEX_WAIT, wait_ns);
+    trace_omen_rgb_acpi_lock(frame->zones, dev->zone_count, 0, 0, wait_ns);
     
     // Double-check device state after acquiring mutex
     if (!is_device_ready(dev)) {
@@ -396,15 +722,16 @@ static int send_acpi_command_with_retry(struct omen_device *dev,
         return -ENODEV;
     }
     
-    start_time = ktime_get();
-    
-    // Set up ACPI call
-    params[0].type = ACPI_TYPE_BUFFER;
-    params[0].buffer.length = sizeof(cmd);
-    params[0].buffer.pointer = (u8 *)&cmd;
+    // Prepare command in the device's reusable buffer
+    ret = prepare_acpi_command(dev, frame, dev->cmd);
+    if (ret) {
+        mutex_unlock(&dev->acpi_lock);
+        omen_err("Failed to prepare ACPI command: %d\n", ret);
+        atomic64_inc(&dev->error_count);
+        return ret;
+    }
     
-    args.count = 1;
-    args.pointer = params;
+    start_time = ktime_get();
     
     // Retry mechanism
     for (retry = 0; retry < ACPI_MAX_RETRIES; retry++) {
@@ -420,8 +747,23 @@ static int send_acpi_command_with_retry(struct omen_device *dev,
             }
         }
         
-        // Execute ACPI method
-        status = acpi_evaluate_object(dev->acpi_handle, "SECU", &args, &output);
+        // Execute ACPI method - the result lands in the preallocated buffer
+        output.length = sizeof(dev->result);
+        output.pointer = dev->result;
+        attempt_ns = ktime_get_ns();
+        status = dev->backend->evaluate(dev, &output);
+        attempt_ns = ktime_get_ns() - attempt_ns;
+        attempts++;
+        omen_hist_record(dev, OMEN_HIST_ACPI_EVAL, attempt_ns);
+        trace_omen_rgb_acpi_eval(frame->zones, dev->zone_count, retry,
+                                 status, attempt_ns);
+        
+        // The method already ran; only copying an oversized result failed
+        if (status == AE_BUFFER_OVERFLOW) {
+            omen_dbg(1, "SECU result larger than %zu bytes, ignored\n",
+                    sizeof(dev->result));
+            status = AE_OK;
+        }
         
         if (ACPI_SUCCESS(status)) {
             break;
@@ -430,308 +772,1404 @@ static int send_acpi_command_with_retry(struct omen_device *dev,
         omen_warn("ACPI command failed (attempt %d): %s\n", 
                  retry + 1, acpi_format_exception(status));
         
-        // Clean up failed attempt
-        if (output.pointer) {
-            kfree(output.pointer);
-            output.pointer = NULL;
-            output.length = ACPI_ALLOCATE_BUFFER;
+        if (omen_acpi_error_is_final(status)) {
+            omen_dbg(1, "%s fails the same way on every attempt, not retried\n",
+                    acpi_format_exception(status));
+            break;
         }
     }
     
     end_time = ktime_get();
     mutex_unlock(&dev->acpi_lock);
-    
-    // Clear sensitive data
-    memset(&cmd, 0, sizeof(cmd));
+    omen_hist_record(dev, OMEN_HIST_RETRIES, min(retry, ACPI_MAX_RETRIES - 1));
     
     if (ACPI_FAILURE(status)) {
-        omen_err("ACPI command failed after %d retries: %s\n", 
-                ACPI_MAX_RETRIES, acpi_format_exception(status));
+        omen_err("ACPI command failed after %d attempt%s: %s\n",
+                attempts, attempts == 1 ? "" : "s", acpi_format_exception(status));
         atomic64_inc(&dev->error_count);
         ret = -EIO;
     } else {
         u32 duration_ms = ktime_to_ms(ktime_sub(end_time, start_time));
         atomic64_inc(&dev->command_count);
-        omen_info("Color %s set successfully (%u ms, %d retries)\n", 
-                 color->name, duration_ms, retry);
+        omen_dbg(1, "Frame set successfully (%u ms, %d retries)\n",
+                 duration_ms, retry);
         ret = 0;
         
-        // Non-blocking delay for hardware
-        schedule_timeout_uninterruptible(msecs_to_jiffies(20));
-    }
-    
-    // Clean up output buffer
-    if (output.pointer) {
-        kfree(output.pointer);
+        // Give the firmware time to settle - only the dispatcher waits here
+        schedule_timeout_uninterruptible(msecs_to_jiffies(ACPI_SETTLE_DELAY_MS));
     }
     
+    trace_omen_rgb_complete(frame->zones, dev->zone_count, retry, ret,
+                            ktime_to_ns(ktime_sub(end_time, start_time)));
     return ret;
 }
 
-// Device detection
-static bool detect_omen_device(struct omen_device *dev)
+// Consistent copy of the shared page - false if userspace is mid-update
+static bool omen_shared_snapshot(struct omen_device *dev,
+                                 struct omen_frame *frame, u32 *seq)
 {
-    const char *vendor, *product;
-    int ret;
-    
-    if (!dev) {
-        omen_err("Device pointer is NULL\n");
-        return false;
-    }
-    
-    vendor = dmi_get_system_info(DMI_SYS_VENDOR);
-    product = dmi_get_system_info(DMI_PRODUCT_NAME);
-    
-    if (!vendor || !product) {
-        omen_err("DMI information not available\n");
-        return false;
-    }
-    
-    omen_dbg(1, "DMI Info - Vendor: %s, Product: %s\n", vendor, product);
-    
-    // Check for HP/OMEN devices
-    if (strstr(vendor, "HP") || strstr(vendor, "Hewlett-Packard")) {
-        if (strstr(product, "OMEN") || strstr(product, "Victus") || 
-            strstr(product, "Pavilion Gaming")) {
-            
-            // Determine device type
-            if (strstr(product, "Desktop") || strstr(product, "GT") ||
-                strstr(product, "25L") || strstr(product, "30L") ||
-                strstr(product, "45L")) {
-                dev->is_desktop = true;
-                dev->zone_count = MAX_ZONES;
-            } else {
-                dev->is_desktop = false;
-                dev->zone_count = 1;
-            }
-            
-            // Safe string copy
-            ret = strscpy(dev->device_name, product, sizeof(dev->device_name));
-            if (ret < 0) {
-                omen_warn("Device name truncated\n");
-                strscpy(dev->device_name, "OMEN Device", sizeof(dev->device_name));
-            }
-            
-            omen_info("Detected %s (%s, %d zones)\n", 
-                     dev->device_name, dev->is_desktop ? "Desktop" : "Laptop", 
-                     dev->zone_count);
+    struct omen_rgb_shared *shared = dev->shared;
+    u32 begin;
+    int retry;
+    
+    for (retry = 0; retry < SHARED_READ_RETRIES; retry++) {
+        begin = smp_load_acquire(&shared->seq);
+        if (begin & 1) {
+            cpu_relax();
+            continue;
+        }
+        
+        memset(frame, 0, sizeof(*frame));
+        memcpy(frame->zones, shared->zones,
+               dev->zone_count * sizeof(frame->zones[0]));
+        smp_rmb();
+        
+        if (READ_ONCE(shared->seq) == begin) {
+            *seq = begin;
             return true;
         }
     }
     
-    omen_err("No compatible OMEN device found (Vendor: %s, Product: %s)\n", 
-            vendor, product);
     return false;
 }
 
-// ACPI handle discovery
-static const char *acpi_paths[] = {
-    "\\_SB.WMID",
-    "\\_SB.WMI1", 
-    "\\_SB.AMW0",
-    "\\_SB.WMAA",
-    NULL
-};
-
-static acpi_status find_acpi_handle(struct omen_device *dev)
+// Put a taken request back unless a newer one arrived, then run again later
+static void omen_requeue_request(struct omen_device *dev,
+                                 const struct omen_frame *frame,
+                                 bool from_shared, u64 since_ns, u64 ticket,
+                                 unsigned long delay)
 {
-    acpi_status status;
-    int i, ret;
-    
-    if (!dev) {
-        omen_err("Device pointer is NULL\n");
-        return AE_BAD_PARAMETER;
-    }
-    
-    for (i = 0; acpi_paths[i] && i < ARRAY_SIZE(acpi_paths) - 1; i++) {
-        omen_dbg(2, "Trying ACPI path: %s\n", acpi_paths[i]);
-        
-        status = acpi_get_handle(ACPI_ROOT_OBJECT, acpi_paths[i], &dev->acpi_handle);
-        if (ACPI_SUCCESS(status)) {
-            ret = strscpy(dev->acpi_path, acpi_paths[i], sizeof(dev->acpi_path));
-            if (ret < 0) {
-                omen_warn("ACPI path truncated\n");
-            }
-            omen_info("ACPI handle found: %s\n", acpi_paths[i]);
-            return status;
-        }
-        
-        omen_dbg(2, "ACPI path %s failed: %s\n", 
-                acpi_paths[i], acpi_format_exception(status));
+    spin_lock_bh(&dev->pending_lock);
+    if (is_device_ready(dev) && !dev->pending_valid) {
+        dev->pending = *frame;
+        dev->pending_shared = from_shared;
+        dev->pending_since_ns = since_ns;
+        dev->pending_ticket = ticket;
+        dev->pending_valid = true;
     }
+    spin_unlock_bh(&dev->pending_lock);
     
-    omen_err("No ACPI WMI handle found\n");
-    return AE_NOT_FOUND;
+    queue_delayed_work(dev->cmd_wq, &dev->cmd_work, delay);
 }
 
-// Enhanced color lookup
-static const struct rgb_color *find_color_by_name(const char *name)
+// True if the hardware already shows this frame
+static bool omen_frame_committed(struct omen_device *dev,
+                                 const struct omen_frame *frame)
 {
-    int i;
-    char normalized_name[16];
-    int ret;
+    if (!suppress_redundant || !dev->committed_valid)
+        return false;
     
-    if (!name) {
-        omen_err("Color name is NULL\n");
-        return NULL;
-    }
+    if (dev->committed.segment_count != frame->segment_count)
+        return false;
+    if (frame->segment_count)
+        return memcmp(dev->committed.segments, frame->segments,
+                      frame->segment_count * sizeof(frame->segments[0])) == 0;
     
-    // Normalize input
-    ret = strscpy(normalized_name, name, sizeof(normalized_name));
-    if (ret < 0) {
-        omen_warn("Color name too long: %s\n", name);
-        return NULL;
-    }
+    return memcmp(dev->committed.zones, frame->zones,
+                  dev->zone_count * sizeof(frame->zones[0])) == 0;
+}
+
+// Publish the outcome of a finished request to synchronous committers
+static void omen_request_done(struct omen_device *dev, u64 ticket, int ret)
+{
+    spin_lock_bh(&dev->pending_lock);
+    dev->done_ticket = ticket;
+    dev->done_ret = ret;
+    spin_unlock_bh(&dev->pending_lock);
     
-    // Convert to lowercase and trim
-    for (i = 0; normalized_name[i]; i++) {
-        if (normalized_name[i] >= 'A' && normalized_name[i] <= 'Z') {
-            normalized_name[i] += 32;
+    wake_up_all(&dev->commit_wait);
+}
+
+// Command dispatcher - runs on the per-device ordered workqueue
+static void omen_cmd_work(struct work_struct *work)
+{
+    struct omen_device *dev = container_of(to_delayed_work(work),
+                                           struct omen_device, cmd_work);
+    struct omen_frame frame;
+    bool valid, from_shared;
+    u64 since_ns, ticket;
+    u32 seq = 0;
+    int ret = 0;
+    
+    if (!is_device_ready(dev) || !READ_ONCE(dev->pending_valid))
+        return;
+    
+    // Take the latest request - anything older has already been dropped
+    spin_lock_bh(&dev->pending_lock);
+    valid = dev->pending_valid;
+    from_shared = dev->pending_shared;
+    frame = dev->pending;
+    since_ns = dev->pending_since_ns;
+    ticket = dev->pending_ticket;
+    dev->pending_valid = false;
+    spin_unlock_bh(&dev->pending_lock);
+    
+    if (!valid)
+        return;
+    
+    // The slot is free again for blocked writers
+    wake_up_interruptible(&omen_slot_wait);
+    
+    // Doorbell requests pick up whatever the page holds right now. A writer
+    // that died mid-update leaves seq odd for good - back off, then drop the
+    // request and wait for the next doorbell instead of waking every tick.
+    if (from_shared && !omen_shared_snapshot(dev, &frame, &seq)) {
+        if (dev->shared_busy_retries >= SHARED_BUSY_RETRIES) {
+            dev->shared_busy_retries = 0;
+            omen_dbg(1, "Shared frame stayed busy, request dropped\n");
+            ret = -EBUSY;
+            goto done;
         }
+        omen_dbg(2, "Shared frame busy, retrying in %u ticks\n",
+                 1U << dev->shared_busy_retries);
+        omen_requeue_request(dev, &frame, true, since_ns, ticket,
+                             1UL << dev->shared_busy_retries++);
+        return;
+    }
+    dev->shared_busy_retries = 0;
+    
+    // zone= writes build on the doorbell frame, unless a newer frame
+    // queued meanwhile already replaced their base
+    if (from_shared) {
+        spin_lock_bh(&dev->pending_lock);
+        if (!dev->pending_valid || dev->pending_shared)
+            dev->last_frame = frame;
+        spin_unlock_bh(&dev->pending_lock);
     }
     
-    // Remove trailing whitespace
-    while (i > 0 && (normalized_name[i-1] == ' ' || normalized_name[i-1] == '\n' || 
-                     normalized_name[i-1] == '\t')) {
-        normalized_name[--i] = '\0';
+    // Redundant frames cost no firmware call, rate limit token or settle delay
+    if (omen_frame_committed(dev, &frame)) {
+        atomic64_inc(&dev->cache_hits);
+        omen_dbg(2, "Frame already committed, skipped\n");
+        goto committed;
     }
     
-    // Find color
-    for (i = 0; i < COLOR_MAX; i++) {
-        if (strcmp(normalized_name, colors[i].name) == 0) {
-            omen_dbg(2, "Color found: %s -> R=%u G=%u B=%u\n", 
-                    colors[i].name, colors[i].r, colors[i].g, colors[i].b);
-            return &colors[i];
-        }
+    // Leave the request pending and come back when the window reopens
+    if (!check_rate_limit(dev, &frame)) {
+        dev->dispatch_deferrals++;
+        omen_requeue_request(dev, &frame, from_shared, since_ns, ticket,
+                             rate_limit_wait_jiffies(dev));
+        return;
     }
     
-    omen_warn("Unknown color: %s (normalized: %s)\n", name, normalized_name);
-    return NULL;
+    omen_hist_record(dev, OMEN_HIST_QUEUE_WAIT, ktime_get_ns() - since_ns);
+    omen_hist_record(dev, OMEN_HIST_RATE_DEFERRALS, dev->dispatch_deferrals);
+    dev->dispatch_deferrals = 0;
+    
+    atomic64_inc(&dev->cache_misses);
+    ret = send_acpi_command_with_retry(dev, &frame);
+    if (ret) {
+        // Hardware state is unknown after a failed call
+        dev->committed_valid = false;
+        omen_err("Failed to set frame\n");
+        goto done;
+    }
+    dev->committed = frame;
+    dev->committed_valid = true;
+
+committed:
+    if (from_shared)
+        smp_store_release(&dev->shared->committed_seq, seq);
+done:
+    omen_request_done(dev, ticket, ret);
 }
 
-// Proc interface
-static int omen_proc_show(struct seq_file *m, void *v)
+// Queue a request for the dispatcher, replacing any request not yet sent.
+// A NULL frame means the dispatcher reads the shared page when it runs.
+// The request's ticket is stored in *ticket when ticket is not NULL.
+static int omen_queue_request(struct omen_device *dev,
+                              const struct omen_frame *frame, u64 *ticket)
 {
-    struct omen_device *dev = get_device_safe();
-    int i;
+    spin_lock_bh(&dev->pending_lock);
     
-    if (!dev) {
-        seq_printf(m, "ERROR: Device not available\n");
-        return 0;
+    // Checked under the lock so omen_remove() can fence out late submitters
+    if (!is_device_ready(dev)) {
+        spin_unlock_bh(&dev->pending_lock);
+        return -ENODEV;
+    }
+    
+    if (dev->pending_valid) {
+        atomic64_inc(&dev->coalesced_count);
+        omen_dbg(2, "Dropping stale frame\n");
+    } else {
+        dev->pending_since_ns = ktime_get_ns();
+    }
+    if (frame) {
+        dev->pending = *frame;
+        dev->last_frame = *frame;
+    }
+    dev->pending_shared = !frame;
+    dev->pending_ticket = ++dev->next_ticket;
+    if (ticket)
+        *ticket = dev->pending_ticket;
+    trace_omen_rgb_submit(frame ? frame->zones : NULL, dev->zone_count);
+    dev->pending_valid = true;
+    
+    // No-op if the dispatcher is already queued or waiting on the rate limit
+    queue_delayed_work(dev->cmd_wq, &dev->cmd_work, 0);
+    spin_unlock_bh(&dev->pending_lock);
+    
+    return 0;
+}
+
+static int omen_submit_frame(struct omen_device *dev,
+                             const struct omen_frame *frame)
+{
+    if (!dev || !frame)
+        return -EINVAL;
+    
+    return omen_queue_request(dev, frame, NULL);
+}
+
+static int omen_submit_shared(struct omen_device *dev)
+{
+    if (!dev || !dev->shared)
+        return -EINVAL;
+    
+    return omen_queue_request(dev, NULL, NULL);
+}
+
+// True once the dispatcher finished ticket or a newer request
+static bool omen_ticket_done(struct omen_device *dev, u64 ticket, int *ret)
+{
+    bool done;
+    
+    spin_lock_bh(&dev->pending_lock);
+    done = dev->done_ticket >= ticket;
+    if (done)
+        *ret = dev->done_ticket == ticket ? dev->done_ret : -ECANCELED;
+    spin_unlock_bh(&dev->pending_lock);
+    
+    return done;
+}
+
+// Queue a frame and wait for the firmware call that carries it. Every zone
+// goes out in one SECU evaluation, so the frame is applied whole or not at
+// all; -ECANCELED means a newer request replaced it before it was sent.
+static int omen_commit_frame(struct omen_device *dev,
+                             const struct omen_frame *frame)
+{
+    u64 ticket;
+    int ret, result;
+    
+    if (!dev || !frame)
+        return -EINVAL;
+    
+    ret = omen_queue_request(dev, frame, &ticket);
+    if (ret)
+        return ret;
+    
+    ret = wait_event_interruptible(dev->commit_wait,
+                                   omen_ticket_done(dev, ticket, &result) ||
+                                   !is_device_ready(dev));
+    if (ret)
+        return ret;
+    
+    return omen_ticket_done(dev, ticket, &result) ? result : -ENODEV;
+}
+
+// Fill every zone with a single color
+static void omen_frame_fill(struct omen_frame *frame,
+                            const struct rgb_color *color)
+{
+    int i;
+    
+    for (i = 0; i < MAX_ZONES; i++) {
+        frame->zones[i].r = color->r;
+        frame->zones[i].g = color->g;
+        frame->zones[i].b = color->b;
+    }
+    frame->segment_count = 0;
+}
+
+static int omen_submit_color(struct omen_device *dev,
+                             const struct rgb_color *color)
+{
+    struct omen_frame frame;
+    
+    if (!color)
+        return -EINVAL;
+    
+    omen_frame_fill(&frame, color);
+    return omen_submit_frame(dev, &frame);
+}
+
+// Effect engine - frames rendered on a per-device hrtimer with Q16 phases
+
+// Tick no faster than the firmware can take commands
+static u64 omen_effect_tick_ns(void)
+{
+    return div_u64(NSEC_PER_SEC, rate_limit_rate());
+}
+
+// Linear blend of two colors, frac in 1/65536
+static struct omen_rgb_zone omen_color_lerp(struct omen_rgb_zone a,
+                                            struct omen_rgb_zone b, u32 frac)
+{
+    struct omen_rgb_zone out;
+    
+    out.r = a.r + (((int)b.r - a.r) * (int)frac >> 16);
+    out.g = a.g + (((int)b.g - a.g) * (int)frac >> 16);
+    out.b = a.b + (((int)b.b - a.b) * (int)frac >> 16);
+    return out;
+}
+
+static struct omen_rgb_zone omen_color_scale(struct omen_rgb_zone c, u32 level)
+{
+    struct omen_rgb_zone out;
+    
+    // level is Q15
+    out.r = (c.r * level) >> 15;
+    out.g = (c.g * level) >> 15;
+    out.b = (c.b * level) >> 15;
+    return out;
+}
+
+static void omen_effect_render(struct omen_device *dev, u64 elapsed_ns,
+                               struct omen_frame *frame)
+{
+    const struct omen_rgb_effect *e = &dev->effect;
+    u64 period_ns = (u64)e->period_ms * NSEC_PER_MSEC;
+    u64 rem;
+    u32 cycle, base, phase, pos, level;
+    int i, idx;
+    
+    cycle = div64_u64_rem(elapsed_ns, period_ns, &rem);
+    base = div64_u64(rem << 16, period_ns);
+    
+    memset(frame, 0, sizeof(*frame));
+    for (i = 0; i < dev->zone_count; i++) {
+        phase = (base + e->phase[i]) & 0xFFFF;
+        
+        switch (e->type) {
+        case OMEN_RGB_EFFECT_BREATHING:
+            // (1 - cos) / 2 over one period, next color every cycle
+            level = (0x7FFF - fixp_cos16((phase * 360) >> 16)) / 2;
+            idx = cycle % e->color_count;
+            frame->zones[i] = omen_color_scale(e->colors[idx], level);
+            break;
+        case OMEN_RGB_EFFECT_WAVE:
+            // Spread zones evenly over one period on top of their offsets
+            phase = (phase + (i << 16) / dev->zone_count) & 0xFFFF;
+            fallthrough;
+        case OMEN_RGB_EFFECT_CYCLE:
+            pos = phase * e->color_count;
+            idx = pos >> 16;
+            frame->zones[i] = omen_color_lerp(e->colors[idx],
+                                              e->colors[(idx + 1) % e->color_count],
+                                              pos & 0xFFFF);
+            break;
+        }
+    }
+}
+
+static enum hrtimer_restart omen_effect_tick(struct hrtimer *timer)
+{
+    struct omen_device *dev = container_of(timer, struct omen_device,
+                                           effect_timer);
+    struct omen_frame frame;
+    
+    if (!is_device_ready(dev))
+        return HRTIMER_NORESTART;
+    
+    omen_effect_render(dev, ktime_get_ns() - dev->effect_start_ns, &frame);
+    
+    // Same path as userspace frames, so coalescing and the state cache apply
+    omen_queue_request(dev, &frame, NULL);
+    
+    hrtimer_forward_now(timer, ns_to_ktime(omen_effect_tick_ns()));
+    return HRTIMER_RESTART;
+}
+
+// True if an effect was running
+static bool omen_effect_stop(struct omen_device *dev)
+{
+    bool stopped;
+    
+    mutex_lock(&dev->effect_lock);
+    stopped = dev->effect_running;
+    if (stopped) {
+        hrtimer_cancel(&dev->effect_timer);
+        dev->effect_running = false;
+        omen_dbg(1, "Effect stopped\n");
+    }
+    mutex_unlock(&dev->effect_lock);
+    
+    return stopped;
+}
+
+static int omen_effect_validate(const struct omen_rgb_effect *e)
+{
+    if (e->version != OMEN_RGB_ABI_VERSION)
+        return -EINVAL;
+    
+    if (e->type == OMEN_RGB_EFFECT_NONE)
+        return 0;
+    
+    if (e->type > OMEN_RGB_EFFECT_WAVE)
+        return -EINVAL;
+    
+    if (e->period_ms < OMEN_RGB_EFFECT_MIN_PERIOD_MS ||
+        e->period_ms > OMEN_RGB_EFFECT_MAX_PERIOD_MS)
+        return -EINVAL;
+    
+    if (e->color_count == 0 || e->color_count > OMEN_RGB_MAX_EFFECT_COLORS)
+        return -EINVAL;
+    
+    return 0;
+}
+
+// Replace the running effect - OMEN_RGB_EFFECT_NONE just stops it
+static int omen_effect_start(struct omen_device *dev,
+                             const struct omen_rgb_effect *e)
+{
+    int ret;
+    
+    ret = omen_effect_validate(e);
+    if (ret)
+        return ret;
+    
+    mutex_lock(&dev->effect_lock);
+    if (dev->effect_running) {
+        hrtimer_cancel(&dev->effect_timer);
+        dev->effect_running = false;
+    }
+    
+    if (e->type != OMEN_RGB_EFFECT_NONE && is_device_ready(dev)) {
+        dev->effect = *e;
+        dev->effect_start_ns = ktime_get_ns();
+        dev->effect_running = true;
+        hrtimer_start(&dev->effect_timer, 0, HRTIMER_MODE_REL_SOFT);
+        omen_dbg(1, "Effect %u started (%u ms period)\n", e->type, e->period_ms);
+    }
+    mutex_unlock(&dev->effect_lock);
+    
+    return 0;
+}
+
+// First model whose match string appears in the product name
+static const struct omen_model *omen_find_model(const char *product)
+{
+    int i;
+    
+    for (i = 0; omen_models[i].match; i++) {
+        if (strstr(product, omen_models[i].match))
+            return &omen_models[i];
+    }
+    
+    return &omen_models[i];
+}
+
+// Device detection
+static bool detect_omen_device(struct omen_device *dev)
+{
+    const struct omen_model *model;
+    const char *vendor, *product;
+    int ret;
+    
+    if (!dev) {
+        omen_err("Device pointer is NULL\n");
+        return false;
+    }
+    
+    vendor = dmi_get_system_info(DMI_SYS_VENDOR);
+    product = dmi_get_system_info(DMI_PRODUCT_NAME);
+    
+    if (!vendor || !product) {
+        omen_err("DMI information not available\n");
+        return false;
+    }
+    
+    omen_dbg(1, "DMI Info - Vendor: %s, Product: %s\n", vendor, product);
+    
+    // Check for HP/OMEN devices
+    if (strstr(vendor, "HP") || strstr(vendor, "Hewlett-Packard")) {
+        if (strstr(product, "OMEN") || strstr(product, "Victus") || 
+            strstr(product, "Pavilion Gaming")) {
+            
+            // Determine device type
+            model = omen_find_model(product);
+            dev->zone_count = model->zone_count;
+            dev->segment_count = model->segment_count;
+            dev->is_desktop = dev->zone_count > 1;
+            
+            // Safe string copy
+            ret = strscpy(dev->device_name, product, sizeof(dev->device_name));
+            if (ret < 0) {
+                omen_warn("Device name truncated\n");
+                strscpy(dev->device_name, "OMEN Device", sizeof(dev->device_name));
+            }
+            
+            omen_info("Detected %s (%s, %d zones)\n", 
+                     dev->device_name, dev->is_desktop ? "Desktop" : "Laptop", 
+                     dev->zone_count);
+            return true;
+        }
+    }
+    
+    omen_err("No compatible OMEN device found (Vendor: %s, Product: %s)\n", 
+            vendor, product);
+    return false;
+}
+
+// ACPI handle discovery
+static const char *acpi_paths[] = {
+    "\\_SB.WMID",
+    "\\_SB.WMI1", 
+    "\\_SB.AMW0",
+    "\\_SB.WMAA",
+    NULL
+};
+
+static acpi_status find_acpi_handle(struct omen_device *dev)
+{
+    acpi_status status;
+    int i, ret;
+    
+    if (!dev) {
+        omen_err("Device pointer is NULL\n");
+        return AE_BAD_PARAMETER;
+    }
+    
+    for (i = 0; acpi_paths[i] && i < ARRAY_SIZE(acpi_paths) - 1; i++) {
+        omen_dbg(2, "Trying ACPI path: %s\n", acpi_paths[i]);
+        
+        status = acpi_get_handle(ACPI_ROOT_OBJECT, acpi_paths[i], &dev->acpi_handle);
+        if (ACPI_SUCCESS(status)) {
+            ret = strscpy(dev->acpi_path, acpi_paths[i], sizeof(dev->acpi_path));
+            if (ret < 0) {
+                omen_warn("ACPI path truncated\n");
+            }
+            omen_info("ACPI handle found: %s\n", acpi_paths[i]);
+            return status;
+        }
+        
+        omen_dbg(2, "ACPI path %s failed: %s\n", 
+                acpi_paths[i], acpi_format_exception(status));
+    }
+    
+    omen_err("No ACPI WMI handle found\n");
+    return AE_NOT_FOUND;
+}
+
+// Pick and size the firmware call from the board's signature table: SECU
+// where the board has it, else WMAA with the SECU buffer as Arg2. A board
+// missing from the table, or whose entries do not fit, keeps the SECU call.
+static int omen_check_acpi_sig(struct omen_device *dev)
+{
+    const char *board = dmi_get_system_info(DMI_BOARD_NAME);
+    char method[sizeof(dev->acpi_path) + 8];
+    const struct omen_acpi_sig *sig;
+    bool wmaa = false;
+    
+    snprintf(method, sizeof(method), "%s.SECU", dev->acpi_path);
+    sig = omen_acpi_sig_find(board, method);
+    if (!sig) {
+        snprintf(method, sizeof(method), "%s.WMAA", dev->acpi_path);
+        sig = omen_acpi_sig_find(board, method);
+        wmaa = sig != NULL;
+    }
+    
+    if (!sig) {
+        if (omen_acpi_sig_board_known(board))
+            omen_warn("Board %s lists neither SECU nor WMAA under %s, trying SECU\n",
+                     board, dev->acpi_path);
+        else
+            omen_dbg(1, "Board %s not in the signature table\n", board ? board : "(unknown)");
+        return 0;
+    }
+    
+    if (wmaa ? sig->args != 3 || sig->buffer_arg != 2 :
+               sig->args != 1 || (sig->buffer_arg != 0 &&
+                                  sig->buffer_arg != OMEN_ACPI_SIG_NO_BUFFER)) {
+        omen_warn("%s takes %u arguments on board %s, not the SECU buffer - trying SECU\n",
+                 method, sig->args, board);
+        return 0;
+    }
+    if (sig->buffer_size > OMEN_ACPI_SIG_MAX_BUFFER) {
+        omen_warn("%s indexes %u bytes, more than the %d byte call buffer limit - trying SECU\n",
+                 method, sig->buffer_size, OMEN_ACPI_SIG_MAX_BUFFER);
+        return 0;
+    }
+    
+    dev->sig = sig;
+    dev->wmaa = wmaa;
+    omen_info("Board %s: %s takes a %u byte buffer\n", board, method,
+             max_t(u32, sig->buffer_size, sizeof(struct omen_acpi_command)));
+    return 0;
+}
+
+// Backends
+
+static int omen_acpi_detect(struct omen_device *dev)
+{
+    if (!detect_omen_device(dev))
+        return -ENODEV;
+    
+    if (ACPI_FAILURE(find_acpi_handle(dev)))
+        return -ENODEV;
+    
+    return omen_check_acpi_sig(dev);
+}
+
+static acpi_status omen_acpi_evaluate(struct omen_device *dev,
+                                      struct acpi_buffer *output)
+{
+    return acpi_evaluate_object(dev->acpi_handle, dev->wmaa ? "WMAA" : "SECU",
+                                &dev->args, output);
+}
+
+static const struct omen_backend omen_acpi_backend = {
+    .name = "acpi",
+    .detect = omen_acpi_detect,
+    .evaluate = omen_acpi_evaluate,
+};
+
+// Mock - no firmware, so the driver can be exercised on any machine
+static int omen_mock_detect(struct omen_device *dev)
+{
+    dev->is_desktop = mock_zones == MAX_ZONES;
+    dev->zone_count = mock_zones;
+    dev->segment_count = mock_zones;
+    strscpy(dev->device_name, "OMEN Mock", sizeof(dev->device_name));
+    strscpy(dev->acpi_path, "mock", sizeof(dev->acpi_path));
+    
+    omen_info("Mock backend: %d zones, %u us latency, %u%% failures\n",
+             dev->zone_count, mock_latency_us, mock_fail_pct);
+    return 0;
+}
+
+static acpi_status omen_mock_evaluate(struct omen_device *dev,
+                                      struct acpi_buffer *output)
+{
+    unsigned int latency_us = READ_ONCE(mock_latency_us);
+    unsigned int jitter_us = READ_ONCE(mock_jitter_us);
+    
+    if (jitter_us)
+        latency_us += get_random_u32_below(jitter_us + 1);
+    if (latency_us)
+        fsleep(latency_us);
+    
+    if (get_random_u32_below(100) < READ_ONCE(mock_fail_pct))
+        return AE_ERROR;
+    
+    return AE_OK;
+}
+
+static const struct omen_backend omen_mock_backend = {
+    .name = "mock",
+    .detect = omen_mock_detect,
+    .evaluate = omen_mock_evaluate,
+};
+
+static const struct omen_backend *omen_backends[] = {
+    &omen_acpi_backend,
+    &omen_mock_backend,
+    NULL
+};
+
+static const struct omen_backend *omen_find_backend(const char *name)
+{
+    int i;
+    
+    for (i = 0; omen_backends[i]; i++) {
+        if (sysfs_streq(name, omen_backends[i]->name))
+            return omen_backends[i];
+    }
+    
+    return NULL;
+}
+
+// Named colors - two hashes and one compare, tables from omen_color_gen
+static const struct omen_color_entry *omen_find_named_color(const char *name)
+{
+    const struct omen_color_entry *entry;
+    u32 d;
+    
+    d = omen_color_displace[omen_color_hash(name, 0) & (OMEN_COLOR_BUCKETS - 1)];
+    entry = &omen_color_slots[omen_color_hash(name, d) & (OMEN_COLOR_SLOTS - 1)];
+    
+    // Unknown names still land somewhere - the one compare rejects them
+    if (!d || !entry->name || strcasecmp(entry->name, name) != 0)
+        return NULL;
+    
+    return entry;
+}
+
+// One color term: #RRGGBB, decimal r,g,b or a CSS color name
+static int omen_parse_color(const char *str, struct omen_rgb_zone *color)
+{
+    const struct omen_color_entry *entry;
+    char triplet[12], *cur, *part;
+    u8 rgb[3];
+    int i;
+    
+    if (str[0] == '#') {
+        if (strlen(str) != 7 || hex2bin(rgb, str + 1, 3))
+            return -EINVAL;
+    } else if (strchr(str, ',')) {
+        // Split a copy so the caller can still log the term
+        if (strscpy(triplet, str, sizeof(triplet)) < 0)
+            return -EINVAL;
+        cur = triplet;
+        for (i = 0; i < 3; i++) {
+            part = strsep(&cur, ",");
+            if (!part || kstrtou8(part, 10, &rgb[i]))
+                return -EINVAL;
+        }
+        if (cur)
+            return -EINVAL;
+    } else {
+        entry = omen_find_named_color(str);
+        if (!entry)
+            return -EINVAL;
+        rgb[0] = entry->r;
+        rgb[1] = entry->g;
+        rgb[2] = entry->b;
+    }
+    
+    color->r = rgb[0];
+    color->g = rgb[1];
+    color->b = rgb[2];
+    return 0;
+}
+
+// Whitespace separated terms applied left to right on top of frame:
+// a bare color sets every zone, zone=N:color sets zone N only
+static int omen_parse_command(struct omen_device *dev, char *cmd,
+                              struct omen_frame *frame)
+{
+    struct omen_rgb_zone color;
+    unsigned int zone;
+    char *term, *sep;
+    int terms = 0;
+    int i;
+    
+    // Zone terms apply on top of the last zones, even after a segment frame
+    frame->segment_count = 0;
+    
+    while ((term = strsep(&cmd, " \t\n")) != NULL) {
+        if (!*term)
+            continue;
+        
+        if (strncasecmp(term, "zone=", 5) == 0) {
+            sep = strchr(term + 5, ':');
+            if (!sep) {
+                omen_warn("Missing ':' in '%s'\n", term);
+                return -EINVAL;
+            }
+            *sep = '\0';
+            if (kstrtouint(term + 5, 10, &zone) || zone >= dev->zone_count) {
+                omen_warn("Invalid zone '%s' (device has %d)\n", term + 5,
+                         dev->zone_count);
+                return -EINVAL;
+            }
+            if (omen_parse_color(sep + 1, &color)) {
+                omen_warn("Unknown color: %s\n", sep + 1);
+                return -EINVAL;
+            }
+            frame->zones[zone] = color;
+        } else {
+            if (omen_parse_color(term, &color)) {
+                omen_warn("Unknown color: %s\n", term);
+                return -EINVAL;
+            }
+            for (i = 0; i < MAX_ZONES; i++)
+                frame->zones[i] = color;
+        }
+        terms++;
+    }
+    
+    return terms ? 0 : -EINVAL;
+}
+
+// Proc interface
+static int omen_proc_show(struct seq_file *m, void *v)
+{
+    struct omen_device *dev = get_device_safe();
+    u64 tokens;
+    
+    if (!dev) {
+        seq_printf(m, "ERROR: Device not available\n");
+        return 0;
     }
     
     seq_printf(m, "OMEN RGB Driver v%s\n", DRIVER_VERSION);
     seq_printf(m, "===================\n");
     seq_printf(m, "Device: %s\n", dev->device_name);
-    seq_printf(m, "ACPI Path: %s\n", dev->acpi_path);
+    seq_printf(m, "Backend: %s\n", dev->backend->name);
+    seq_printf(m, "ACPI Path: %s.%s\n", dev->acpi_path, dev->wmaa ? "WMAA" : "SECU");
+    seq_printf(m, "ACPI Payload: %u bytes%s\n",
+              dev->params[dev->args.count - 1].buffer.length,
+              dev->sig ? " (board signature)" : "");
     seq_printf(m, "Type: %s\n", dev->is_desktop ? "Desktop" : "Laptop");
     seq_printf(m, "Zones: %d\n", dev->zone_count);
+    seq_printf(m, "Segments: %d\n", dev->segment_count);
     seq_printf(m, "State: %d\n", get_device_state(dev));
-    seq_printf(m, "Rate Limit: %d/%u\n", 
-              atomic_read(&dev->limiter.count), max_command_rate);
+    spin_lock(&dev->limiter.lock);
+    rate_limit_refill(&dev->limiter);
+    tokens = dev->limiter.tokens;
+    spin_unlock(&dev->limiter.lock);
+    seq_printf(m, "Rate Limit: %llu.%03llu/%u tokens, refill %u/s\n",
+              tokens / RATE_TOKEN_SCALE, tokens % RATE_TOKEN_SCALE,
+              (unsigned int)(rate_limit_cap() / RATE_TOKEN_SCALE),
+              (unsigned int)rate_limit_rate());
+    seq_printf(m, "Rate Limited: %llu deferred, %llu rejected\n",
+              atomic64_read(&dev->limiter.deferred),
+              atomic64_read(&dev->limiter.rejected));
     seq_printf(m, "Commands Sent: %llu\n", atomic64_read(&dev->command_count));
     seq_printf(m, "Errors: %llu\n", atomic64_read(&dev->error_count));
+    seq_printf(m, "Coalesced: %llu\n", atomic64_read(&dev->coalesced_count));
+    seq_printf(m, "State Cache: %llu hits, %llu misses\n",
+              atomic64_read(&dev->cache_hits), atomic64_read(&dev->cache_misses));
+    seq_printf(m, "Effect: %s\n", dev->effect_running ? "running" : "none");
     seq_printf(m, "Debug Level: %u\n", debug_level);
     seq_printf(m, "Strict Permissions: %s\n", strict_permissions ? "Yes" : "No");
     seq_printf(m, "Reference Count: %d\n", atomic_read(&dev->ref_count_debug));
     
-    seq_printf(m, "\nAvailable Colors:\n");
-    for (i = 0; i < COLOR_MAX; i++) {
-        seq_printf(m, "  %s (R:%u G:%u B:%u)\n", 
-                  colors[i].name, colors[i].r, colors[i].g, colors[i].b);
+    seq_printf(m, "\nColors: %d CSS names (e.g. green, orange, teal), #RRGGBB or r,g,b\n",
+              OMEN_COLOR_COUNT);
+    
+    seq_printf(m, "\nUsage:\n");
+    seq_printf(m, "  echo 'green' > /proc/omen_rgb\n");
+    seq_printf(m, "  echo '#FF8000' > /proc/omen_rgb\n");
+    seq_printf(m, "  echo '255,0,128' > /proc/omen_rgb\n");
+    seq_printf(m, "  echo 'zone=0:red zone=1:#00FF00' > /proc/omen_rgb   # Other zones unchanged\n");
+    seq_printf(m, "  /dev/%s: struct omen_rgb_frame (ABI v%d, see omen_rgb_ioctl.h)\n",
+              DRIVER_NAME, OMEN_RGB_ABI_VERSION);
+    
+    put_device_safe(dev);
+    return 0;
+}
+
+// Proc write with all vulnerabilities fixed
+static ssize_t omen_proc_write(struct file *file, const char __user *buffer,
+                              size_t count, loff_t *pos)
+{
+    struct omen_device *dev;
+    char cmd[MAX_PROC_WRITE_SIZE];
+    struct omen_frame frame;
+    size_t len = count;
+    int ret;
+    
+    // Input validation
+    if (count == 0) {
+        omen_warn("Empty write request\n");
+        return -EINVAL;
+    }
+    
+    if (count >= sizeof(cmd)) {
+        omen_warn("Write request too large: %zu >= %zu\n", count, sizeof(cmd));
+        return -EINVAL;
+    }
+    
+    dev = get_device_safe();
+    if (!dev) {
+        omen_err("Device not available for write\n");
+        return -ENODEV;
+    }
+    
+    // Safe copy from user
+    if (copy_from_user(cmd, buffer, count)) {
+        omen_err("Failed to copy data from user\n");
+        put_device_safe(dev);
+        return -EFAULT;
+    }
+    
+    // Null terminate safely
+    cmd[count] = '\0';
+    
+    // Remove trailing whitespace
+    while (len > 0 && (cmd[len - 1] == '\n' || cmd[len - 1] == ' ' || 
+                       cmd[len - 1] == '\t')) {
+        cmd[--len] = '\0';
+    }
+    
+    if (len == 0) {
+        omen_warn("Empty command after trimming\n");
+        put_device_safe(dev);
+        return -EINVAL;
+    }
+    
+    omen_dbg(1, "Processing command: '%s'\n", cmd);
+    
+    // Zones the command does not mention keep their last color
+    spin_lock_bh(&dev->pending_lock);
+    frame = dev->last_frame;
+    spin_unlock_bh(&dev->pending_lock);
+    
+    ret = omen_parse_command(dev, cmd, &frame);
+    if (ret) {
+        put_device_safe(dev);
+        return ret;
+    }
+    
+    if (!check_write_permission()) {
+        atomic64_inc(&dev->error_count);
+        put_device_safe(dev);
+        return -EPERM;
+    }
+    
+    // Hand off to the dispatcher - the writer never waits on the firmware
+    omen_effect_stop(dev);
+    ret = omen_submit_frame(dev, &frame);
+    put_device_safe(dev);
+    
+    if (ret) {
+        omen_err("Failed to queue frame: %d\n", ret);
+        return ret;
+    }
+    
+    return count;
+}
+
+static int omen_proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, omen_proc_show, NULL);
+}
+
+// Debugfs - per-bucket counts, bucket n covering [2^(n-1), 2^n)
+static int omen_hist_show(struct seq_file *m, void *v)
+{
+    struct omen_device *dev = m->private;
+    const struct omen_hist *hist;
+    u64 count, lo;
+    int i, b;
+    
+    for (i = 0; i < OMEN_HIST_MAX; i++) {
+        hist = &dev->hist[i];
+        count = atomic64_read(&hist->count);
+        seq_printf(m, "%s (%s): count %llu, mean %llu\n",
+                  omen_hist_info[i].name, omen_hist_info[i].unit, count,
+                  count ? div64_u64(atomic64_read(&hist->sum), count) : 0);
+        
+        for (b = 0; b < OMEN_HIST_BUCKETS; b++) {
+            count = atomic64_read(&hist->buckets[b]);
+            if (!count)
+                continue;
+            lo = b ? 1ULL << (b - 1) : 0;
+            if (b == OMEN_HIST_BUCKETS - 1)
+                seq_printf(m, "  [%llu, inf) %llu\n", lo, count);
+            else
+                seq_printf(m, "  [%llu, %llu) %llu\n", lo, 1ULL << b, count);
+        }
+    }
+    
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(omen_hist);
+
+// One line per histogram: name unit count sum bucket0 .. bucket31
+static int omen_hist_raw_show(struct seq_file *m, void *v)
+{
+    struct omen_device *dev = m->private;
+    const struct omen_hist *hist;
+    int i, b;
+    
+    for (i = 0; i < OMEN_HIST_MAX; i++) {
+        hist = &dev->hist[i];
+        seq_printf(m, "%s %s %llu %llu", omen_hist_info[i].name,
+                  omen_hist_info[i].unit, atomic64_read(&hist->count),
+                  atomic64_read(&hist->sum));
+        for (b = 0; b < OMEN_HIST_BUCKETS; b++)
+            seq_printf(m, " %llu", atomic64_read(&hist->buckets[b]));
+        seq_putc(m, '\n');
     }
     
-    seq_printf(m, "\nUsage:\n");
-    seq_printf(m, "  echo 'green' > /proc/omen_rgb\n");
-    seq_printf(m, "  echo 'red' > /proc/omen_rgb\n");
-    seq_printf(m, "  echo 'blue' > /proc/omen_rgb\n");
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(omen_hist_raw);
+
+static int omen_hist_reset_set(void *data, u64 val)
+{
+    if (val != 1)
+        return -EINVAL;
     
-    put_device_safe(dev);
+    omen_hist_reset(data);
     return 0;
 }
+DEFINE_DEBUGFS_ATTRIBUTE(omen_hist_reset_fops, NULL, omen_hist_reset_set, "%llu\n");
 
-// Proc write with all vulnerabilities fixed
-static ssize_t omen_proc_write(struct file *file, const char __user *buffer,
-                              size_t count, loff_t *pos)
+// Debugfs is best effort - the driver works without it
+static void omen_debugfs_init(struct omen_device *dev)
 {
-    struct omen_device *dev;
-    char cmd[MAX_PROC_WRITE_SIZE];
-    const struct rgb_color *color;
-    int ret;
+    dev->debugfs_dir = debugfs_create_dir(DRIVER_NAME, NULL);
+    debugfs_create_file("histograms", 0444, dev->debugfs_dir, dev,
+                        &omen_hist_fops);
+    debugfs_create_file("histograms_raw", 0444, dev->debugfs_dir, dev,
+                        &omen_hist_raw_fops);
+    debugfs_create_file_unsafe("reset", 0200, dev->debugfs_dir, dev,
+                               &omen_hist_reset_fops);
+}
+
+static const struct proc_ops omen_proc_ops = {
+    .proc_open = omen_proc_open,
+    .proc_read = seq_read,
+    .proc_write = omen_proc_write,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+// Character device - binary frames, no string parsing
+static int omen_frame_from_user(struct omen_device *dev,
+                                const struct omen_rgb_frame *uframe,
+                                struct omen_frame *frame)
+{
+    int i;
     
-    // Input validation
-    if (count == 0) {
-        omen_warn("Empty write request\n");
+    if (uframe->version != OMEN_RGB_ABI_VERSION) {
+        omen_dbg(1, "Unsupported frame version %u\n", uframe->version);
         return -EINVAL;
     }
     
-    if (count >= sizeof(cmd)) {
-        omen_warn("Write request too large: %zu >= %zu\n", count, sizeof(cmd));
+    if (uframe->zone_count != dev->zone_count) {
+        omen_dbg(1, "Frame has %u zones, device has %d\n",
+                uframe->zone_count, dev->zone_count);
+        return -EINVAL;
+    }
+    
+    memset(frame, 0, sizeof(*frame));
+    for (i = 0; i < dev->zone_count; i++) {
+        frame->zones[i] = uframe->zones[i];
+    }
+    
+    return 0;
+}
+
+static int omen_segments_from_user(struct omen_device *dev,
+                                   const struct omen_rgb_segments *usegs,
+                                   struct omen_frame *frame)
+{
+    int i;
+    
+    if (usegs->version != OMEN_RGB_ABI_VERSION) {
+        omen_dbg(1, "Unsupported segment frame version %u\n", usegs->version);
+        return -EINVAL;
+    }
+    
+    if (usegs->segment_count != dev->segment_count) {
+        omen_dbg(1, "Frame has %u segments, device has %d\n",
+                usegs->segment_count, dev->segment_count);
         return -EINVAL;
     }
     
+    memset(frame, 0, sizeof(*frame));
+    frame->segment_count = dev->segment_count;
+    memcpy(frame->segments, usegs->segments,
+           dev->segment_count * sizeof(frame->segments[0]));
+    
+    // Each zone reports its first segment - traces and /proc zone= writes
+    for (i = dev->segment_count - 1; i >= 0; i--)
+        frame->zones[dev->segment_zone[i]] = frame->segments[i];
+    
+    return 0;
+}
+
+// A new frame would go straight out: nothing queued and a token in the bucket
+static bool omen_slot_available(struct omen_device *dev)
+{
+    bool available;
+    
+    if (READ_ONCE(dev->pending_valid))
+        return false;
+    
+    spin_lock(&dev->limiter.lock);
+    rate_limit_refill(&dev->limiter);
+    available = dev->limiter.tokens >= RATE_TOKEN_SCALE;
+    spin_unlock(&dev->limiter.lock);
+    
+    return available;
+}
+
+// Backpressure for /dev/omen_rgb writers - sleep or -EAGAIN until a slot frees
+static int omen_wait_for_slot(struct omen_device *dev, bool nonblock)
+{
+    long ret;
+    
+    while (!omen_slot_available(dev)) {
+        if (nonblock) {
+            atomic64_inc(&dev->limiter.rejected);
+            return -EAGAIN;
+        }
+        
+        // Timed wait covers a token coming due while the bucket timer is idle
+        ret = wait_event_interruptible_timeout(omen_slot_wait,
+                                               omen_slot_available(dev) ||
+                                               !is_device_ready(dev),
+                                               rate_limit_wait_jiffies(dev));
+        if (ret < 0) {
+            return ret;
+        }
+        if (!is_device_ready(dev)) {
+            return -ENODEV;
+        }
+    }
+    
+    return 0;
+}
+
+// Zone frame from uframe, or segment frame from usegs when uframe is NULL
+static int omen_cdev_set_frame(const struct omen_rgb_frame *uframe,
+                               const struct omen_rgb_segments *usegs,
+                               bool nonblock, bool commit)
+{
+    struct omen_device *dev;
+    struct omen_frame frame;
+    int ret;
+    
     dev = get_device_safe();
     if (!dev) {
-        omen_err("Device not available for write\n");
         return -ENODEV;
     }
     
-    // Safe copy from user
-    if (copy_from_user(cmd, buffer, count)) {
-        omen_err("Failed to copy data from user\n");
+    if (!check_write_permission()) {
+        atomic64_inc(&dev->error_count);
         put_device_safe(dev);
+        return -EPERM;
+    }
+    
+    ret = uframe ? omen_frame_from_user(dev, uframe, &frame) :
+                   omen_segments_from_user(dev, usegs, &frame);
+    // A running effect holds the slot and the rate budget, so the frame
+    // takes its place at once. Otherwise the frame waits for a slot, and a
+    // writer turned away with -EAGAIN has stopped nothing.
+    if (!ret && !omen_effect_stop(dev)) {
+        ret = omen_wait_for_slot(dev, nonblock);
+    }
+    if (!ret) {
+        ret = commit ? omen_commit_frame(dev, &frame) :
+                       omen_submit_frame(dev, &frame);
+    }
+    
+    put_device_safe(dev);
+    return ret;
+}
+
+static int omen_cdev_get_info(struct omen_rgb_info __user *uinfo)
+{
+    struct omen_device *dev;
+    struct omen_rgb_info info;
+    
+    dev = get_device_safe();
+    if (!dev) {
+        return -ENODEV;
+    }
+    
+    memset(&info, 0, sizeof(info));
+    info.version = OMEN_RGB_ABI_VERSION;
+    info.zone_count = dev->zone_count;
+    info.flags = dev->is_desktop ? OMEN_RGB_INFO_DESKTOP : 0;
+    info.segment_count = dev->segment_count;
+    put_device_safe(dev);
+    
+    if (copy_to_user(uinfo, &info, sizeof(info))) {
         return -EFAULT;
     }
     
-    // Null terminate safely
-    cmd[count] = '\0';
+    return 0;
+}
+
+static int omen_cdev_doorbell(void)
+{
+    struct omen_device *dev;
+    int ret;
     
-    // Remove trailing whitespace
-    while (count > 0 && (cmd[count - 1] == '\n' || cmd[count - 1] == ' ' || 
-                         cmd[count - 1] == '\t')) {
-        cmd[--count] = '\0';
+    dev = get_device_safe();
+    if (!dev) {
+        return -ENODEV;
     }
     
-    if (count == 0) {
-        omen_warn("Empty command after trimming\n");
+    if (!check_write_permission()) {
+        atomic64_inc(&dev->error_count);
         put_device_safe(dev);
-        return -EINVAL;
+        return -EPERM;
     }
     
-    omen_dbg(1, "Processing command: '%s'\n", cmd);
+    omen_effect_stop(dev);
+    ret = omen_submit_shared(dev);
+    put_device_safe(dev);
+    return ret;
+}
+
+static int omen_cdev_set_effect(const struct omen_rgb_effect *effect)
+{
+    struct omen_device *dev;
+    int ret;
+    
+    dev = get_device_safe();
+    if (!dev) {
+        return -ENODEV;
+    }
     
-    // Find color
-    color = find_color_by_name(cmd);
-    if (!color) {
+    if (!check_write_permission()) {
+        atomic64_inc(&dev->error_count);
         put_device_safe(dev);
-        return -EINVAL;
+        return -EPERM;
     }
     
-    // Send command
-    ret = send_acpi_command_with_retry(dev, color);
+    ret = omen_effect_start(dev, effect);
     put_device_safe(dev);
+    return ret;
+}
+
+static ssize_t omen_cdev_write(struct file *file, const char __user *buffer,
+                               size_t count, loff_t *pos)
+{
+    struct omen_rgb_frame uframe;
+    int ret;
     
-    if (ret) {
-        omen_err("Failed to set color %s: %d\n", color->name, ret);
-        return ret;
+    // One frame per write - no partial or batched frames
+    if (count != sizeof(uframe)) {
+        return -EINVAL;
     }
     
-    return count;
+    if (copy_from_user(&uframe, buffer, count)) {
+        return -EFAULT;
+    }
+    
+    ret = omen_cdev_set_frame(&uframe, NULL, file->f_flags & O_NONBLOCK, false);
+    return ret ? ret : count;
 }
 
-static int omen_proc_open(struct inode *inode, struct file *file)
+static long omen_cdev_ioctl(struct file *file, unsigned int cmd,
+                            unsigned long arg)
 {
-    return single_open(file, omen_proc_show, NULL);
+    void __user *argp = (void __user *)arg;
+    struct omen_rgb_frame uframe;
+    struct omen_rgb_segments usegs;
+    struct omen_rgb_effect effect;
+    
+    switch (cmd) {
+    case OMEN_RGB_IOC_SET_FRAME:
+    case OMEN_RGB_IOC_COMMIT_FRAME:
+        // ioctl works on read-only descriptors, so check the open mode
+        if (!(file->f_mode & FMODE_WRITE)) {
+            return -EBADF;
+        }
+        if (copy_from_user(&uframe, argp, sizeof(uframe))) {
+            return -EFAULT;
+        }
+        return omen_cdev_set_frame(&uframe, NULL, file->f_flags & O_NONBLOCK,
+                                   cmd == OMEN_RGB_IOC_COMMIT_FRAME);
+    case OMEN_RGB_IOC_SET_SEGMENTS:
+        if (!(file->f_mode & FMODE_WRITE)) {
+            return -EBADF;
+        }
+        if (copy_from_user(&usegs, argp, sizeof(usegs))) {
+            return -EFAULT;
+        }
+        return omen_cdev_set_frame(NULL, &usegs, file->f_flags & O_NONBLOCK, false);
+    case OMEN_RGB_IOC_GET_INFO:
+        return omen_cdev_get_info(argp);
+    case OMEN_RGB_IOC_DOORBELL:
+        if (!(file->f_mode & FMODE_WRITE)) {
+            return -EBADF;
+        }
+        return omen_cdev_doorbell();
+    case OMEN_RGB_IOC_SET_EFFECT:
+        if (!(file->f_mode & FMODE_WRITE)) {
+            return -EBADF;
+        }
+        if (copy_from_user(&effect, argp, sizeof(effect))) {
+            return -EFAULT;
+        }
+        return omen_cdev_set_effect(&effect);
+    default:
+        return -ENOTTY;
+    }
 }
 
-static const struct proc_ops omen_proc_ops = {
-    .proc_open = omen_proc_open,
-    .proc_read = seq_read,
-    .proc_write = omen_proc_write,
-    .proc_lseek = seq_lseek,
-    .proc_release = single_release,
+// Writable when a frame written now would be sent without waiting
+static __poll_t omen_cdev_poll(struct file *file, poll_table *wait)
+{
+    struct omen_device *dev;
+    __poll_t mask = 0;
+    
+    poll_wait(file, &omen_slot_wait, wait);
+    
+    dev = get_device_safe();
+    if (!dev) {
+        return EPOLLERR | EPOLLHUP;
+    }
+    
+    if (omen_slot_available(dev)) {
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    }
+    
+    put_device_safe(dev);
+    return mask;
+}
+
+// Map the shared frame page - one page at offset 0, MAP_SHARED only
+static int omen_cdev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct omen_device *dev;
+    int ret;
+    
+    if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE) {
+        return -EINVAL;
+    }
+    
+    // A private mapping would only give the caller a copy-on-write page
+    if (!(vma->vm_flags & VM_SHARED)) {
+        return -EINVAL;
+    }
+    
+    dev = get_device_safe();
+    if (!dev) {
+        return -ENODEV;
+    }
+    
+    if ((vma->vm_flags & VM_WRITE) && !check_write_permission()) {
+        put_device_safe(dev);
+        return -EPERM;
+    }
+    
+    // The mapping holds its own page reference, dropped at the last unmap,
+    // so the page survives the device being unbound under a mapping
+    vm_flags_set(vma, VM_DONTEXPAND | VM_DONTDUMP);
+    ret = vm_insert_page(vma, vma->vm_start, virt_to_page(dev->shared));
+    
+    put_device_safe(dev);
+    return ret;
+}
+
+static const struct file_operations omen_cdev_fops = {
+    .owner = THIS_MODULE,
+    .open = nonseekable_open,
+    .write = omen_cdev_write,
+    .unlocked_ioctl = omen_cdev_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+    .poll = omen_cdev_poll,
+    .mmap = omen_cdev_mmap,
 };
 
+// Locks, counters, rate limiter and dispatcher of a zeroed device
+static void omen_device_init(struct omen_device *dev)
+{
+    kref_init(&dev->kref);
+    mutex_init(&dev->acpi_lock);
+    spin_lock_init(&dev->limiter.lock);
+    dev->limiter.tokens = rate_limit_cap();
+    dev->limiter.last_refill_ns = ktime_get_ns();
+    timer_setup(&dev->limiter.refill_timer, rate_limit_refill_timer, 0);
+    atomic64_set(&dev->limiter.deferred, 0);
+    atomic64_set(&dev->limiter.rejected, 0);
+    atomic_set(&dev->state, DEVICE_STATE_INITIALIZING);
+    atomic_set(&dev->ref_count_debug, 1); // Initial reference
+    atomic64_set(&dev->command_count, 0);
+    atomic64_set(&dev->error_count, 0);
+    atomic64_set(&dev->coalesced_count, 0);
+    atomic64_set(&dev->cache_hits, 0);
+    atomic64_set(&dev->cache_misses, 0);
+    spin_lock_init(&dev->pending_lock);
+    init_waitqueue_head(&dev->commit_wait);
+    INIT_DELAYED_WORK(&dev->cmd_work, omen_cmd_work);
+    mutex_init(&dev->effect_lock);
+    hrtimer_setup(&dev->effect_timer, omen_effect_tick, CLOCK_MONOTONIC,
+                  HRTIMER_MODE_REL_SOFT);
+}
+
 // Platform driver probe
 static int omen_probe(struct platform_device *pdev)
 {
@@ -739,8 +2177,9 @@ static int omen_probe(struct platform_device *pdev)
     int ret;
     
     omen_info("OMEN RGB driver loading v%s\n", DRIVER_VERSION);
-    omen_info("Module parameters: max_rate=%u, debug=%u, strict=%s\n",
-             max_command_rate, debug_level, strict_permissions ? "true" : "false");
+    omen_info("Module parameters: max_rate=%u, burst=%u, debug=%u, strict=%s, backend=%s\n",
+             max_command_rate, burst_size, debug_level,
+             strict_permissions ? "true" : "false", backend);
     
     // Allocate device context
     dev = kzalloc(sizeof(*dev), GFP_KERNEL);
@@ -751,27 +2190,27 @@ static int omen_probe(struct platform_device *pdev)
     
     // Initialize device
     dev->pdev = pdev;
-    kref_init(&dev->kref);
-    mutex_init(&dev->acpi_lock);
-    mutex_init(&dev->limiter.lock);
-    atomic_set(&dev->limiter.count, 0);
-    atomic64_set(&dev->limiter.last_reset_jiffies, get_jiffies_64());
-    atomic_set(&dev->state, DEVICE_STATE_INITIALIZING);
-    atomic_set(&dev->ref_count_debug, 1); // Initial reference
-    atomic64_set(&dev->command_count, 0);
-    atomic64_set(&dev->error_count, 0);
-    
+    omen_device_init(dev);
     platform_set_drvdata(pdev, dev);
     
-    // Detect device
-    if (!detect_omen_device(dev)) {
-        ret = -ENODEV;
+    // Detect device and find its handle
+    dev->backend = omen_find_backend(backend);
+    ret = dev->backend->detect(dev);
+    if (ret) {
+        goto err_free;
+    }
+    
+    omen_init_segment_map(dev);
+    ret = init_acpi_command(dev);
+    if (ret) {
         goto err_free;
     }
     
-    // Find ACPI handle
-    if (ACPI_FAILURE(find_acpi_handle(dev))) {
-        ret = -ENODEV;
+    // Ordered queue - one firmware call in flight per device
+    dev->cmd_wq = alloc_ordered_workqueue("omen_rgb_cmd", 0);
+    if (!dev->cmd_wq) {
+        omen_err("Failed to allocate command workqueue\n");
+        ret = -ENOMEM;
         goto err_free;
     }
     
@@ -783,6 +2222,30 @@ static int omen_probe(struct platform_device *pdev)
         goto err_free;
     }
     
+    omen_debugfs_init(dev);
+    
+    // Shared frame page - mappings keep it alive past the device
+    dev->shared = (struct omen_rgb_shared *)get_zeroed_page(GFP_KERNEL);
+    if (!dev->shared) {
+        omen_err("Failed to allocate shared frame page\n");
+        ret = -ENOMEM;
+        goto err_free;
+    }
+    dev->shared->version = OMEN_RGB_ABI_VERSION;
+    dev->shared->zone_count = dev->zone_count;
+    
+    // Create character device
+    dev->misc.minor = MISC_DYNAMIC_MINOR;
+    dev->misc.name = DRIVER_NAME;
+    dev->misc.fops = &omen_cdev_fops;
+    dev->misc.mode = 0644;
+    ret = misc_register(&dev->misc);
+    if (ret) {
+        omen_err("Failed to register /dev/%s: %d\n", DRIVER_NAME, ret);
+        goto err_free;
+    }
+    dev->misc_registered = true;
+    
     // Atomically set global device pointer with proper barriers
     spin_lock(&global_dev_lock);
     rcu_assign_pointer(global_omen_dev, dev);
@@ -795,21 +2258,31 @@ static int omen_probe(struct platform_device *pdev)
     smp_wmb();
     
     // Test with safe green color
-    ret = send_acpi_command_with_retry(dev, &colors[COLOR_GREEN]);
+    ret = omen_submit_color(dev, &colors[COLOR_GREEN]);
     if (ret) {
         omen_warn("Initial test failed (%d), but driver loaded\n", ret);
         // Don't fail - device might still work
     }
     
     omen_info("Driver loaded successfully for %s\n", dev->device_name);
-    omen_info("Interface: /proc/omen_rgb (permissions: 0644)\n");
+    omen_info("Interface: /proc/omen_rgb, /dev/%s (permissions: 0644)\n",
+             DRIVER_NAME);
     
     return 0;
-    
+
 err_free:
+    if (dev->misc_registered) {
+        misc_deregister(&dev->misc);
+    }
     if (dev->proc_entry) {
         proc_remove(dev->proc_entry);
     }
+    debugfs_remove_recursive(dev->debugfs_dir);
+    if (dev->cmd_wq) {
+        destroy_workqueue(dev->cmd_wq);
+    }
+    free_page((unsigned long)dev->shared);
+    free_acpi_command(dev);
     kfree(dev);
     return ret;
 }
@@ -818,6 +2291,7 @@ err_free:
  static void omen_remove(struct platform_device *pdev)
 {
     struct omen_device *dev;
+    struct omen_frame black;
     
     omen_info("Driver unloading\n");
     
@@ -847,9 +2321,38 @@ err_free:
             dev->proc_entry = NULL;
         }
         
+        // Remove debugfs - waits for readers still inside the files
+        debugfs_remove_recursive(dev->debugfs_dir);
+        dev->debugfs_dir = NULL;
+        
+        // Remove character device - open descriptors now get -ENODEV
+        if (dev->misc_registered) {
+            misc_deregister(&dev->misc);
+            dev->misc_registered = false;
+        }
+        
+        // Stop the effect engine before it can queue more frames
+        omen_effect_stop(dev);
+        
+        // Fence out submitters that saw the device ready before shutdown
+        spin_lock_bh(&dev->pending_lock);
+        dev->pending_valid = false;
+        spin_unlock_bh(&dev->pending_lock);
+        
+        // Stop the dispatcher - queued requests are dropped
+        cancel_delayed_work_sync(&dev->cmd_work);
+        destroy_workqueue(dev->cmd_wq);
+        dev->cmd_wq = NULL;
+        timer_delete_sync(&dev->limiter.refill_timer);
+        
+        // Blocked writers and committers see the device gone and bail out
+        wake_up_interruptible_all(&omen_slot_wait);
+        wake_up_all(&dev->commit_wait);
+        
         // Set to black before unloading (ignore errors)
         if (is_device_ready(dev) || get_device_state(dev) == DEVICE_STATE_SHUTTING_DOWN) {
-            send_acpi_command_with_retry(dev, &colors[COLOR_BLACK]);
+            omen_frame_fill(&black, &colors[COLOR_BLACK]);
+            send_acpi_command_with_retry(dev, &black);
         }
         
         // Wait for any pending operations
@@ -886,17 +2389,47 @@ static int __init omen_init(void)
     
     omen_info("OMEN RGB Driver v%s initializing\n", DRIVER_VERSION);
     
+    BUILD_BUG_ON(MAX_ZONES != OMEN_RGB_MAX_ZONES);
+    BUILD_BUG_ON(OMEN_RGB_MAX_SEGMENTS * 3 != sizeof(((struct omen_acpi_command *)0)->rgb_data));
+    BUILD_BUG_ON(sizeof(struct omen_rgb_shared) > PAGE_SIZE);
+    
     // Validate module parameters
-    if (max_command_rate == 0 || max_command_rate > 100) {
+    if (max_command_rate == 0 || max_command_rate > RATE_LIMIT_MAX) {
         omen_warn("Invalid max_command_rate %u, using default 3\n", max_command_rate);
         max_command_rate = 3;
     }
     
+    if (burst_size == 0 || burst_size > RATE_LIMIT_MAX) {
+        omen_warn("Invalid burst_size %u, using default 3\n", burst_size);
+        burst_size = 3;
+    }
+    
     if (debug_level > 2) {
         omen_warn("Invalid debug_level %u, using maximum 2\n", debug_level);
         debug_level = 2;
     }
     
+    if (!backend || !omen_find_backend(backend)) {
+        omen_warn("Invalid backend %s, using acpi\n", backend ? backend : "(null)");
+        backend = "acpi";
+    }
+    
+    if (mock_fail_pct > 100) {
+        omen_warn("Invalid mock_fail_pct %u, using maximum 100\n", mock_fail_pct);
+        mock_fail_pct = 100;
+    }
+    
+    if (mock_zones != 1 && mock_zones != MAX_ZONES) {
+        omen_warn("Invalid mock_zones %u, using %d\n", mock_zones, MAX_ZONES);
+        mock_zones = MAX_ZONES;
+    }
+    
+    if (segments > OMEN_RGB_MAX_SEGMENTS) {
+        omen_warn("Invalid segments %u, using maximum %d\n", segments,
+                 OMEN_RGB_MAX_SEGMENTS);
+        segments = OMEN_RGB_MAX_SEGMENTS;
+    }
+    
     // Register platform driver
     ret = platform_driver_register(&omen_driver);
     if (ret) {
@@ -933,6 +2466,8 @@ static void __exit omen_exit(void)
     omen_info("Module cleanup completed\n");
 }
 
+// omen_rgb_kunit.c builds this file into its own module, without the driver
+#ifndef OMEN_RGB_KUNIT
 module_init(omen_init);
 module_exit(omen_exit);
 
@@ -941,3 +2476,4 @@ MODULE_DESCRIPTION("OMEN RGB Kernel Mainline Ready Driver - All Race Conditions
 MODULE_VERSION(DRIVER_VERSION);
 MODULE_LICENSE("GPL v2");
 MODULE_ALIAS("platform:" DRIVER_NAME);
+#endif
@@ -0,0 +1,51 @@
+/*
+ * OMEN RGB Userspace Library - key lookups
+ *
+ * Name lookups cost two hashes and one compare; scan code lookups are a
+ * single table load. The tables come from omen_keymap_gen at build time.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include "omen_rgb_lib.h"
+#include "omen_keymap.h"
+#include "omen_keymap_table.h"
+
+static int key_offset(enum omen_kb_layout layout, int key) {
+    if (key < 0 || !omen_keymap_present[layout][key]) {
+        return -ENOENT;
+    }
+    return key * OMEN_HID_KEY_BYTES;
+}
+
+int omen_key_offset_by_name(enum omen_kb_layout layout, const char *name) {
+    const struct omen_keymap_entry *entry;
+    uint32_t d;
+    
+    if (!name || (unsigned int)layout >= OMEN_KB_LAYOUTS) {
+        return -EINVAL;
+    }
+    
+    d = omen_keymap_displace[omen_keymap_hash(name, 0) & (OMEN_KEYMAP_BUCKETS - 1)];
+    entry = &omen_keymap_slots[omen_keymap_hash(name, d) & (OMEN_KEYMAP_SLOTS - 1)];
+    
+    // Unknown names still land somewhere - the one compare rejects them
+    if (!d || !entry->name || strcmp(entry->name, name) != 0) {
+        return -ENOENT;
+    }
+    return key_offset(layout, entry->key);
+}
+
+int omen_key_offset_by_scancode(enum omen_kb_layout layout, unsigned int code) {
+    if ((unsigned int)layout >= OMEN_KB_LAYOUTS) {
+        return -EINVAL;
+    }
+    if (code >= OMEN_KEYMAP_SCANCODES) {
+        return -ENOENT;
+    }
+    return key_offset(layout, omen_keymap_scancodes[layout][code]);
+}
@@ -0,0 +1,32 @@
+/*
+ * OMEN RGB Userspace Library - key map internals
+ *
+ * Shared by omen_keymap_gen (build time) and omen_keymap.c (run time) so
+ * both sides hash key names identically, with omen_phash() (omen_phash.h).
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#ifndef OMEN_KEYMAP_H
+#define OMEN_KEYMAP_H
+
+#include <stdint.h>
+
+#include "omen_phash.h"
+
+#define OMEN_KEYMAP_BUCKETS     64      // First level, power of two
+#define OMEN_KEYMAP_SLOTS       256     // Second level, power of two
+#define OMEN_KEYMAP_SCANCODES   256     // Linux KEY_* codes covered
+
+struct omen_keymap_entry {
+    const char *name;                   // DeviceKeys name, NULL for a free slot
+    uint8_t key;                        // Index into the per-key buffer
+};
+
+// Key names are case-sensitive
+static inline uint32_t omen_keymap_hash(const char *name, uint32_t seed) {
+    return omen_phash(name, seed, 0);
+}
+
+#endif /* OMEN_KEYMAP_H */
@@ -0,0 +1,312 @@
+/*
+ * OMEN RGB Key Map Generator
+ *
+ * Reads the Aurora DeviceKeys enumeration from "Device Keys.cs" and writes
+ * omen_keymap_table.h: a perfect hash from key names to per-key buffer
+ * positions and, per keyboard layout, a direct table from Linux KEY_*
+ * scan codes. Run by the Makefile; the output is not checked in.
+ *
+ * Only keys whose enum value fits the per-key buffer (1..OMEN_HID_KEYS-1)
+ * are addressable - the JIS conversion keys and the extra lights sit
+ * above it and are left out.
+ *
+ * Usage: omen_keymap_gen "Device Keys.cs" > omen_keymap_table.h
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <linux/input-event-codes.h>
+
+#include "omen_rgb_lib.h"
+#include "omen_keymap.h"
+#include "omen_phash_gen.h"
+
+#define MAX_NAME 64
+
+struct key {
+    char name[MAX_NAME];
+    int value;
+};
+
+struct scancode {
+    int code;
+    const char *name;
+};
+
+// Keys every layout shares
+static const struct scancode common_scancodes[] = {
+    { KEY_ESC, "ESC" },
+    { KEY_F1, "F1" }, { KEY_F2, "F2" }, { KEY_F3, "F3" }, { KEY_F4, "F4" },
+    { KEY_F5, "F5" }, { KEY_F6, "F6" }, { KEY_F7, "F7" }, { KEY_F8, "F8" },
+    { KEY_F9, "F9" }, { KEY_F10, "F10" }, { KEY_F11, "F11" }, { KEY_F12, "F12" },
+    { KEY_SYSRQ, "PRINT_SCREEN" }, { KEY_SCROLLLOCK, "SCROLL_LOCK" },
+    { KEY_PAUSE, "PAUSE_BREAK" },
+    { KEY_GRAVE, "TILDE" },
+    { KEY_1, "ONE" }, { KEY_2, "TWO" }, { KEY_3, "THREE" }, { KEY_4, "FOUR" },
+    { KEY_5, "FIVE" }, { KEY_6, "SIX" }, { KEY_7, "SEVEN" }, { KEY_8, "EIGHT" },
+    { KEY_9, "NINE" }, { KEY_0, "ZERO" },
+    { KEY_MINUS, "MINUS" }, { KEY_EQUAL, "EQUALS" }, { KEY_BACKSPACE, "BACKSPACE" },
+    { KEY_INSERT, "INSERT" }, { KEY_HOME, "HOME" }, { KEY_PAGEUP, "PAGE_UP" },
+    { KEY_NUMLOCK, "NUM_LOCK" }, { KEY_KPSLASH, "NUM_SLASH" },
+    { KEY_KPASTERISK, "NUM_ASTERISK" }, { KEY_KPMINUS, "NUM_MINUS" },
+    { KEY_TAB, "TAB" },
+    { KEY_Q, "Q" }, { KEY_W, "W" }, { KEY_E, "E" }, { KEY_R, "R" }, { KEY_T, "T" },
+    { KEY_Y, "Y" }, { KEY_U, "U" }, { KEY_I, "I" }, { KEY_O, "O" }, { KEY_P, "P" },
+    { KEY_LEFTBRACE, "OPEN_BRACKET" }, { KEY_RIGHTBRACE, "CLOSE_BRACKET" },
+    { KEY_DELETE, "DELETE" }, { KEY_END, "END" }, { KEY_PAGEDOWN, "PAGE_DOWN" },
+    { KEY_KP7, "NUM_SEVEN" }, { KEY_KP8, "NUM_EIGHT" }, { KEY_KP9, "NUM_NINE" },
+    { KEY_KPPLUS, "NUM_PLUS" },
+    { KEY_CAPSLOCK, "CAPS_LOCK" },
+    { KEY_A, "A" }, { KEY_S, "S" }, { KEY_D, "D" }, { KEY_F, "F" }, { KEY_G, "G" },
+    { KEY_H, "H" }, { KEY_J, "J" }, { KEY_K, "K" }, { KEY_L, "L" },
+    { KEY_SEMICOLON, "SEMICOLON" }, { KEY_APOSTROPHE, "APOSTROPHE" },
+    { KEY_ENTER, "ENTER" },
+    { KEY_KP4, "NUM_FOUR" }, { KEY_KP5, "NUM_FIVE" }, { KEY_KP6, "NUM_SIX" },
+    { KEY_LEFTSHIFT, "LEFT_SHIFT" },
+    { KEY_Z, "Z" }, { KEY_X, "X" }, { KEY_C, "C" }, { KEY_V, "V" }, { KEY_B, "B" },
+    { KEY_N, "N" }, { KEY_M, "M" },
+    { KEY_COMMA, "COMMA" }, { KEY_DOT, "PERIOD" }, { KEY_SLASH, "FORWARD_SLASH" },
+    { KEY_RIGHTSHIFT, "RIGHT_SHIFT" }, { KEY_UP, "ARROW_UP" },
+    { KEY_KP1, "NUM_ONE" }, { KEY_KP2, "NUM_TWO" }, { KEY_KP3, "NUM_THREE" },
+    { KEY_KPENTER, "NUM_ENTER" },
+    { KEY_LEFTCTRL, "LEFT_CONTROL" }, { KEY_LEFTMETA, "LEFT_WINDOWS" },
+    { KEY_LEFTALT, "LEFT_ALT" }, { KEY_SPACE, "SPACE" }, { KEY_RIGHTALT, "RIGHT_ALT" },
+    { KEY_RIGHTMETA, "RIGHT_WINDOWS" }, { KEY_COMPOSE, "APPLICATION_SELECT" },
+    { KEY_RIGHTCTRL, "RIGHT_CONTROL" },
+    { KEY_LEFT, "ARROW_LEFT" }, { KEY_DOWN, "ARROW_DOWN" }, { KEY_RIGHT, "ARROW_RIGHT" },
+    { KEY_KP0, "NUM_ZERO" }, { KEY_KPDOT, "NUM_PERIOD" },
+    { KEY_PLAYPAUSE, "MEDIA_PLAY_PAUSE" }, { KEY_PLAYCD, "MEDIA_PLAY" },
+    { KEY_PAUSECD, "MEDIA_PAUSE" }, { KEY_STOPCD, "MEDIA_STOP" },
+    { KEY_PREVIOUSSONG, "MEDIA_PREVIOUS" }, { KEY_NEXTSONG, "MEDIA_NEXT" },
+    { KEY_MUTE, "VOLUME_MUTE" }, { KEY_VOLUMEDOWN, "VOLUME_DOWN" },
+    { KEY_VOLUMEUP, "VOLUME_UP" },
+    { 0, NULL }
+};
+
+// KEY_BACKSLASH is the key above Enter on ANSI and left of it on ISO
+static const struct scancode ansi_scancodes[] = {
+    { KEY_BACKSLASH, "BACKSLASH" },
+    { 0, NULL }
+};
+
+static const struct scancode iso_scancodes[] = {
+    { KEY_BACKSLASH, "HASHTAG" },
+    { KEY_102ND, "BACKSLASH_UK" },
+    { 0, NULL }
+};
+
+// Keys a layout does not have
+static const char *ansi_absent[] = { "HASHTAG", "BACKSLASH_UK", NULL };
+static const char *iso_absent[] = { "BACKSLASH", NULL };
+
+static const struct {
+    const char *name;
+    const struct scancode *scancodes;
+    const char **absent;
+} layouts[OMEN_KB_LAYOUTS] = {
+    [OMEN_KB_ANSI] = { "ANSI", ansi_scancodes, ansi_absent },
+    [OMEN_KB_ISO]  = { "ISO", iso_scancodes, iso_absent },
+};
+
+static struct key keys[OMEN_HID_KEYS];
+static int key_count;
+
+static struct omen_keymap_entry slots[OMEN_KEYMAP_SLOTS];
+static uint32_t displace[OMEN_KEYMAP_BUCKETS];
+
+/*
+ * Parse the enumeration - explicit values reset the counter, implicit ones
+ * continue from the previous entry, just like C#
+ */
+static int parse_device_keys(const char *path) {
+    FILE *fp;
+    char line[512];
+    int value = -1;
+    int in_enum = 0;
+    
+    fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        char name[MAX_NAME];
+        int len = 0;
+        
+        while (isspace((unsigned char)*p)) p++;
+        
+        if (strncmp(p, "public enum DeviceKeys", 22) == 0) {
+            in_enum = 1;
+            continue;
+        }
+        if (!in_enum || *p == '[' || *p == '{' || strncmp(p, "//", 2) == 0) {
+            continue;
+        }
+        if (*p == '}') {
+            break;
+        }
+        if (!isalpha((unsigned char)*p) && *p != '_') {
+            continue;
+        }
+        
+        while ((isalnum((unsigned char)p[len]) || p[len] == '_') && len < MAX_NAME - 1) {
+            name[len] = p[len];
+            len++;
+        }
+        name[len] = 0;
+        p += len;
+        while (isspace((unsigned char)*p)) p++;
+        
+        value = *p == '=' ? atoi(p + 1) : value + 1;
+        
+        if (value < 1 || value >= OMEN_HID_KEYS) {
+            continue;
+        }
+        if (key_count == OMEN_HID_KEYS) {
+            fprintf(stderr, "Too many keys\n");
+            fclose(fp);
+            return -1;
+        }
+        snprintf(keys[key_count].name, MAX_NAME, "%s", name);
+        keys[key_count].value = value;
+        key_count++;
+    }
+    
+    fclose(fp);
+    return key_count ? 0 : -1;
+}
+
+static const struct key *find_key(const char *name) {
+    for (int i = 0; i < key_count; i++) {
+        if (strcmp(keys[i].name, name) == 0) {
+            return &keys[i];
+        }
+    }
+    return NULL;
+}
+
+static int build_perfect_hash(void) {
+    const char *names[OMEN_HID_KEYS];
+    int slot_of[OMEN_HID_KEYS];
+    
+    for (int i = 0; i < key_count; i++) {
+        names[i] = keys[i].name;
+    }
+    
+    if (omen_phash_build(names, key_count, 0, displace, OMEN_KEYMAP_BUCKETS,
+                         slot_of, OMEN_KEYMAP_SLOTS) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < key_count; i++) {
+        slots[slot_of[i]].name = keys[i].name;
+        slots[slot_of[i]].key = (uint8_t)keys[i].value;
+    }
+    return 0;
+}
+
+static int layout_has(int layout, const char *name) {
+    for (int i = 0; layouts[layout].absent[i]; i++) {
+        if (strcmp(layouts[layout].absent[i], name) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int emit_scancodes(const struct scancode *table, int16_t *out) {
+    for (int i = 0; table[i].name; i++) {
+        const struct key *key = find_key(table[i].name);
+        
+        if (!key || table[i].code >= OMEN_KEYMAP_SCANCODES) {
+            fprintf(stderr, "Scan code %d: unknown key %s\n", table[i].code, table[i].name);
+            return -1;
+        }
+        out[table[i].code] = (int16_t)key->value;
+    }
+    return 0;
+}
+
+static int emit_header(const char *source) {
+    printf("/* Generated by omen_keymap_gen from %s - do not edit */\n\n", source);
+    printf("static const uint32_t omen_keymap_displace[OMEN_KEYMAP_BUCKETS] = {");
+    for (int b = 0; b < OMEN_KEYMAP_BUCKETS; b++) {
+        printf("%s%u,", b % 8 ? " " : "\n    ", displace[b]);
+    }
+    printf("\n};\n\n");
+    
+    printf("static const struct omen_keymap_entry omen_keymap_slots[OMEN_KEYMAP_SLOTS] = {\n");
+    for (int s = 0; s < OMEN_KEYMAP_SLOTS; s++) {
+        if (slots[s].name) {
+            printf("    [%d] = { \"%s\", %u },\n", s, slots[s].name, slots[s].key);
+        }
+    }
+    printf("};\n\n");
+    
+    printf("// Keys present per layout, indexed by buffer position\n");
+    printf("static const uint8_t omen_keymap_present[OMEN_KB_LAYOUTS][OMEN_HID_KEYS] = {\n");
+    for (int l = 0; l < OMEN_KB_LAYOUTS; l++) {
+        uint8_t present[OMEN_HID_KEYS] = { 0 };
+        
+        for (int i = 0; i < key_count; i++) {
+            present[keys[i].value] = (uint8_t)layout_has(l, keys[i].name);
+        }
+        printf("    // %s\n    {", layouts[l].name);
+        for (int k = 0; k < OMEN_HID_KEYS; k++) {
+            printf("%s%u,", k % 24 ? " " : "\n        ", present[k]);
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n\n");
+    
+    printf("// Buffer position per Linux KEY_* code, -1 if unmapped\n");
+    printf("static const int16_t omen_keymap_scancodes[OMEN_KB_LAYOUTS][OMEN_KEYMAP_SCANCODES] = {\n");
+    for (int l = 0; l < OMEN_KB_LAYOUTS; l++) {
+        int16_t codes[OMEN_KEYMAP_SCANCODES];
+        
+        for (int c = 0; c < OMEN_KEYMAP_SCANCODES; c++) {
+            codes[c] = -1;
+        }
+        if (emit_scancodes(common_scancodes, codes) ||
+            emit_scancodes(layouts[l].scancodes, codes)) {
+            return -1;
+        }
+        printf("    // %s\n    {", layouts[l].name);
+        for (int c = 0; c < OMEN_KEYMAP_SCANCODES; c++) {
+            printf("%s%d,", c % 16 ? " " : "\n        ", codes[c]);
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n");
+    
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *source;
+    
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s \"Device Keys.cs\" > omen_keymap_table.h\n", argv[0]);
+        return 1;
+    }
+    
+    source = strrchr(argv[1], '/') ? strrchr(argv[1], '/') + 1 : argv[1];
+    
+    if (parse_device_keys(argv[1]) != 0) {
+        fprintf(stderr, "No DeviceKeys entries found in %s\n", argv[1]);
+        return 1;
+    }
+    if (build_perfect_hash() != 0 || emit_header(source) != 0) {
+        return 1;
+    }
+    
+    fprintf(stderr, "%d keys, %d slots\n", key_count, OMEN_KEYMAP_SLOTS);
+    return 0;
+}
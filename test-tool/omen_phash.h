@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * OMEN RGB Driver - name hash for the generated lookup tables
+ *
+ * Key names and color names are looked up the same way: the first hash
+ * picks a bucket, the bucket's displacement seeds the second hash, which
+ * lands every known name in its own slot. omen_phash_gen.h builds the
+ * displacements at build time; the kernel module and the library only hash.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v2 - included by the kernel module
+ */
+
+#ifndef OMEN_PHASH_H
+#define OMEN_PHASH_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+// FNV-1a with a seed, optionally case-insensitive for ASCII
+static inline uint32_t omen_phash(const char *name, uint32_t seed, int fold_case)
+{
+    uint32_t h = 2166136261u ^ (seed * 16777619u);
+    
+    while (*name) {
+        uint8_t c = (uint8_t)*name++;
+        
+        if (fold_case && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+#endif /* OMEN_PHASH_H */
@@ -0,0 +1,113 @@
+/*
+ * OMEN RGB - perfect hash builder, build time only
+ *
+ * Shared by omen_keymap_gen and omen_color_gen so both tables are built by
+ * the same code that omen_phash() later looks them up with.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#ifndef OMEN_PHASH_GEN_H
+#define OMEN_PHASH_GEN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "omen_phash.h"
+
+#define OMEN_PHASH_MAX_DISPLACE 1000000
+
+/*
+ * Hash and displace - place the largest buckets first, then give each
+ * bucket the first displacement that puts all its names in free slots.
+ * buckets and slots are powers of two; displace[] gets one seed per bucket
+ * (unused buckets are left alone) and slot_of[i] the slot of names[i].
+ */
+static int omen_phash_build(const char *const *names, int count, int fold_case,
+                            uint32_t *displace, int buckets,
+                            int *slot_of, int slots) {
+    int *bucket = calloc((size_t)count, sizeof(*bucket));
+    int *members = calloc((size_t)count, sizeof(*members));
+    uint32_t *placed = calloc((size_t)count, sizeof(*placed));
+    int *sizes = calloc((size_t)buckets, sizeof(*sizes));
+    int *order = calloc((size_t)buckets, sizeof(*order));
+    uint8_t *used = calloc((size_t)slots, sizeof(*used));
+    int ret = -1;
+    
+    if (!bucket || !members || !placed || !sizes || !order || !used) {
+        fprintf(stderr, "Out of memory\n");
+        goto out;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        bucket[i] = (int)(omen_phash(names[i], 0, fold_case) & (uint32_t)(buckets - 1));
+        sizes[bucket[i]]++;
+    }
+    
+    for (int b = 0; b < buckets; b++) {
+        order[b] = b;
+    }
+    for (int i = 1; i < buckets; i++) {
+        for (int j = i; j > 0 && sizes[order[j]] > sizes[order[j - 1]]; j--) {
+            int tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+    
+    for (int o = 0; o < buckets && sizes[order[o]]; o++) {
+        int b = order[o];
+        int n = 0;
+        uint32_t d;
+        
+        for (int i = 0; i < count; i++) {
+            if (bucket[i] == b) {
+                members[n++] = i;
+            }
+        }
+        
+        for (d = 1; d < OMEN_PHASH_MAX_DISPLACE; d++) {
+            int ok = 1;
+            
+            for (int m = 0; m < n && ok; m++) {
+                uint32_t s = omen_phash(names[members[m]], d, fold_case) &
+                             (uint32_t)(slots - 1);
+                if (used[s]) {
+                    ok = 0;
+                }
+                for (int k = 0; k < m && ok; k++) {
+                    if (placed[k] == s) ok = 0;
+                }
+                placed[m] = s;
+            }
+            if (!ok) {
+                continue;
+            }
+            
+            for (int m = 0; m < n; m++) {
+                used[placed[m]] = 1;
+                slot_of[members[m]] = (int)placed[m];
+            }
+            displace[b] = d;
+            break;
+        }
+        if (d == OMEN_PHASH_MAX_DISPLACE) {
+            fprintf(stderr, "No displacement found for bucket %d\n", b);
+            goto out;
+        }
+    }
+    ret = 0;
+
+out:
+    free(bucket);
+    free(members);
+    free(placed);
+    free(sizes);
+    free(order);
+    free(used);
+    return ret;
+}
+
+#endif /* OMEN_PHASH_GEN_H */
@@ -0,0 +1,281 @@
+/*
+ * OMEN RGB Library Micro-Benchmark
+ *
+ * Reports encode and submit cost per frame for any transport. The mock
+ * transport is the default, so it runs on any machine.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _POSIX_C_SOURCE 199309L  // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "omen_rgb_lib.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Every frame differs from the previous one, so no triplet is skipped
+static void make_frame(struct omen_rgb_zone *zones, int zone_count, unsigned long n) {
+    for (int i = 0; i < zone_count; i++) {
+        zones[i].r = (uint8_t)(n + i);
+        zones[i].g = (uint8_t)(n * 3 + i);
+        zones[i].b = (uint8_t)(n * 7 + i);
+    }
+}
+
+static void make_key_frame(struct omen_rgb_zone *keys, unsigned long n) {
+    for (int i = 0; i < OMEN_HID_KEYS; i++) {
+        keys[i].r = (uint8_t)(n + i);
+        keys[i].g = (uint8_t)(n * 3 + i * 5);
+        keys[i].b = (uint8_t)(n * 7 + i * 11);
+    }
+}
+
+// Frames are built before the clock starts - filling 144 keys costs more
+// than encoding them
+#define KEY_FRAME_RING 16
+
+static double encode_keys_ns(void (*encode)(struct omen_hid_reports *,
+                                            const struct omen_rgb_zone *),
+                             unsigned long frames) {
+    static struct omen_rgb_zone keys[KEY_FRAME_RING][OMEN_HID_KEYS];
+    static struct omen_hid_reports reports;
+    uint64_t start;
+    
+    for (int n = 0; n < KEY_FRAME_RING; n++) {
+        make_key_frame(keys[n], (unsigned long)n);
+    }
+    
+    start = now_ns();
+    for (unsigned long n = 0; n < frames; n++) {
+        encode(&reports, keys[n % KEY_FRAME_RING]);
+        __asm__ __volatile__("" : : "r"(&reports) : "memory");
+    }
+    return frames ? (double)(now_ns() - start) / frames : 0.0;
+}
+
+/*
+ * Differential check - the dispatching encoder must match the scalar
+ * reference on random frames
+ */
+static int verify_keys(unsigned long frames) {
+    struct omen_rgb_zone keys[OMEN_HID_KEYS];
+    struct omen_hid_reports ref, fast;
+    
+    srand(1);
+    for (unsigned long n = 0; n < frames; n++) {
+        for (int i = 0; i < OMEN_HID_KEYS; i++) {
+            keys[i].r = (uint8_t)rand();
+            keys[i].g = (uint8_t)rand();
+            keys[i].b = (uint8_t)rand();
+        }
+        memset(&ref, 0xA5, sizeof(ref));
+        memset(&fast, 0x5A, sizeof(fast));
+        omen_hid_encode_keys_scalar(&ref, keys);
+        omen_hid_encode_keys(&fast, keys);
+        if (memcmp(&ref, &fast, sizeof(ref)) != 0) {
+            printf("[ERROR] Encoders differ on frame %lu\n", n);
+            return 1;
+        }
+    }
+    printf("verify  per-key   %lu frames  identical\n", frames);
+    return 0;
+}
+
+// Change only `sparse` keys per frame, like a typing ripple
+static void make_sparse_frame(struct omen_rgb_zone *keys, unsigned long n, int sparse) {
+    for (int i = 0; i < sparse; i++) {
+        int key = (int)((n * 37 + (unsigned long)i * 11) % OMEN_HID_KEYS);
+        keys[key].r = (uint8_t)(n + i);
+        keys[key].g ^= 0xFF;
+    }
+}
+
+static int bench_keys(const char *kind, const char *target, enum omen_layout layout,
+                      unsigned long frames, unsigned long submits, int sparse) {
+    static struct omen_rgb_zone keys[OMEN_HID_KEYS];
+    struct omen_transport t;
+    uint64_t start, elapsed;
+    unsigned long failed = 0;
+    int ret;
+    
+    printf("encode  per-key   %lu frames  %.1f ns/frame scalar  %.1f ns/frame simd\n",
+           frames, encode_keys_ns(omen_hid_encode_keys_scalar, frames),
+           encode_keys_ns(omen_hid_encode_keys, frames));
+    
+    ret = omen_transport_open(&t, kind, target, layout);
+    if (ret) {
+        printf("[ERROR] Cannot open %s transport: %s\n", kind, strerror(-ret));
+        return 1;
+    }
+    
+    start = now_ns();
+    for (unsigned long n = 0; n < submits; n++) {
+        if (sparse) {
+            make_sparse_frame(keys, n, sparse);
+        } else {
+            make_key_frame(keys, n);
+        }
+        if (omen_transport_submit_keys(&t, keys)) {
+            failed++;
+        }
+    }
+    elapsed = now_ns() - start;
+    omen_transport_close(&t);
+    
+    printf("submit  %-9s %lu frames  %.1f us/frame  %.2f reports/frame  %lu failed\n",
+           kind, submits, submits ? (double)elapsed / submits / 1000.0 : 0.0,
+           submits ? (double)t.reports_sent / submits : 0.0, failed);
+    
+    return failed ? 1 : 0;
+}
+
+// Key lookups run once per input event in reactive effects
+static int bench_lookup(unsigned long frames) {
+    static const char *names[] = { "ESC", "W", "A", "S", "D", "SPACE", "ENTER", "F12" };
+    const int name_count = (int)(sizeof(names) / sizeof(names[0]));
+    volatile int sink = 0;
+    uint64_t start;
+    double name_ns, code_ns;
+    
+    start = now_ns();
+    for (unsigned long n = 0; n < frames; n++) {
+        sink += omen_key_offset_by_name(OMEN_KB_ANSI, names[n % name_count]);
+    }
+    name_ns = frames ? (double)(now_ns() - start) / frames : 0.0;
+    
+    start = now_ns();
+    for (unsigned long n = 0; n < frames; n++) {
+        sink += omen_key_offset_by_scancode(OMEN_KB_ANSI, (unsigned int)(n & 0x7F));
+    }
+    code_ns = frames ? (double)(now_ns() - start) / frames : 0.0;
+    
+    (void)sink;
+    printf("lookup  per-key   %lu lookups  %.1f ns/name  %.1f ns/scancode\n",
+           frames, name_ns, code_ns);
+    return 0;
+}
+
+static void print_usage(const char* progname) {
+    printf("OMEN RGB Library Micro-Benchmark\n\n");
+    printf("Usage: %s [options]\n\n", progname);
+    printf("Options:\n");
+    printf("  --help               Show this help message\n");
+    printf("  --transport <kind>   acpi_call, ec, hidraw or mock (default: mock)\n");
+    printf("  --target <target>    Transport target (see omen_rgb_lib.h)\n");
+    printf("  --desktop            Use the four-zone desktop layout\n");
+    printf("  --frames <n>         Frames to encode (default: 1000000)\n");
+    printf("  --submits <n>        Frames to submit (default: 1000)\n");
+    printf("  --keys               Per-key frames (%d keys, HID reports)\n", OMEN_HID_KEYS);
+    printf("  --verify             Check the SIMD per-key encoder against the scalar one\n");
+    printf("  --sparse <n>         With --keys, change only n keys per frame\n");
+    printf("  --lookup             Key map lookups by name and scan code\n");
+    printf("\n");
+    printf("Examples:\n");
+    printf("  %s                                   # Encoder and mock only\n", progname);
+    printf("  sudo %s --transport acpi_call --submits 10\n", progname);
+    printf("  %s --keys --verify\n", progname);
+    printf("  %s --keys --sparse 2 --target 500      # Delta updates, 500 us per report\n", progname);
+}
+
+int main(int argc, char *argv[]) {
+    const char *kind = "mock";
+    const char *target = NULL;
+    enum omen_layout layout = OMEN_LAYOUT_LAPTOP;
+    unsigned long frames = 1000000;
+    unsigned long submits = 1000;
+    struct omen_rgb_zone zones[OMEN_RGB_MAX_ZONES];
+    struct omen_secu_command cmd;
+    struct omen_transport t;
+    uint64_t start, elapsed;
+    unsigned long failed = 0;
+    int per_key = 0, verify = 0, sparse = 0, lookup = 0;
+    int zone_count, ret;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+            kind = argv[++i];
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            target = argv[++i];
+        } else if (strcmp(argv[i], "--desktop") == 0) {
+            layout = OMEN_LAYOUT_DESKTOP;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--submits") == 0 && i + 1 < argc) {
+            submits = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--keys") == 0) {
+            per_key = 1;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (strcmp(argv[i], "--lookup") == 0) {
+            lookup = 1;
+        } else if (strcmp(argv[i], "--sparse") == 0 && i + 1 < argc) {
+            sparse = atoi(argv[++i]);
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (verify && verify_keys(frames < 100000 ? frames : 100000)) {
+        return 1;
+    }
+    
+    if (lookup) {
+        return bench_lookup(frames);
+    }
+    
+    if (per_key) {
+        return bench_keys(kind, target, layout, frames, submits, sparse);
+    }
+    
+    zone_count = omen_layout_zones(layout);
+    
+    // Encode only
+    omen_encode_init(&cmd, layout);
+    start = now_ns();
+    for (unsigned long n = 0; n < frames; n++) {
+        make_frame(zones, zone_count, n);
+        omen_encode_frame(&cmd, layout, zones, zone_count);
+    }
+    elapsed = now_ns() - start;
+    printf("encode  %-9s %lu frames  %.1f ns/frame\n",
+           layout == OMEN_LAYOUT_DESKTOP ? "desktop" : "laptop", frames,
+           frames ? (double)elapsed / frames : 0.0);
+    
+    // Encode and submit through the transport
+    ret = omen_transport_open(&t, kind, target, layout);
+    if (ret) {
+        printf("[ERROR] Cannot open %s transport: %s\n", kind, strerror(-ret));
+        return 1;
+    }
+    
+    start = now_ns();
+    for (unsigned long n = 0; n < submits; n++) {
+        make_frame(zones, zone_count, n);
+        if (omen_transport_submit(&t, zones, zone_count)) {
+            failed++;
+        }
+    }
+    elapsed = now_ns() - start;
+    omen_transport_close(&t);
+    
+    printf("submit  %-9s %lu frames  %.1f us/frame  %lu failed\n",
+           kind, submits, submits ? (double)elapsed / submits / 1000.0 : 0.0,
+           failed);
+    
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * OMEN RGB Userspace Library - per-key HID report encoder
+ *
+ * Packs one RGB triplet per key into the 576-byte per-key buffer (4 bytes
+ * per key, see OMEN_HID_KEY_BYTE0 in omen_rgb_lib.h) and splits it into
+ * 65-byte feature reports: Report ID 0x02, Command 0x01 (SetStatic), then
+ * the next 63 buffer bytes, the last report zero padded. Keys may straddle
+ * two reports. The report count and the key byte layout are unverified,
+ * see omen_rgb_lib.h.
+ *
+ * On SSSE3 the buffer is built four keys at a time with one 12-to-16 byte
+ * shuffle, about three times faster than the scalar path in omen_rgb_bench
+ * --keys (~70 vs ~200 ns per frame). The scalar path is the reference the
+ * SIMD path must match byte for byte; omen_rgb_bench --verify checks it.
+ * Both share the layout constants, so the check says nothing about them.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define OMEN_HAVE_SSSE3 1
+#endif
+
+#include "omen_rgb_lib.h"
+
+#define OMEN_HID_LAST_CHUNK (OMEN_HID_BUFFER_SIZE - \
+                             (OMEN_HID_REPORTS - 1) * OMEN_HID_PAYLOAD_SIZE)
+
+static void omen_hid_header(uint8_t *report) {
+    report[0] = OMEN_HID_REPORT_ID;
+    report[1] = OMEN_HID_CMD_SET_STATIC;
+}
+
+// Header on every report, payload chunks of the per-key buffer after it.
+// Constant copy sizes let the compiler inline the copies - a per-report
+// length turned each into a libc call and made the split cost ~20x more
+// than building the buffer.
+static void omen_hid_split(struct omen_hid_reports *out, const uint8_t *buffer) {
+    uint8_t *last = out->report[OMEN_HID_REPORTS - 1];
+    
+    for (int r = 0; r < OMEN_HID_REPORTS - 1; r++) {
+        omen_hid_header(out->report[r]);
+        memcpy(&out->report[r][OMEN_HID_HEADER_SIZE],
+               buffer + (size_t)r * OMEN_HID_PAYLOAD_SIZE, OMEN_HID_PAYLOAD_SIZE);
+    }
+    
+    omen_hid_header(last);
+    memcpy(&last[OMEN_HID_HEADER_SIZE],
+           buffer + (size_t)(OMEN_HID_REPORTS - 1) * OMEN_HID_PAYLOAD_SIZE,
+           OMEN_HID_LAST_CHUNK);
+    memset(&last[OMEN_HID_HEADER_SIZE + OMEN_HID_LAST_CHUNK], 0,
+           OMEN_HID_PAYLOAD_SIZE - OMEN_HID_LAST_CHUNK);
+}
+
+void omen_hid_encode_keys_scalar(struct omen_hid_reports *out,
+                                 const struct omen_rgb_zone *keys) {
+    uint8_t buffer[OMEN_HID_BUFFER_SIZE];
+    
+    for (int k = 0; k < OMEN_HID_KEYS; k++) {
+        uint8_t *entry = &buffer[k * OMEN_HID_KEY_BYTES];
+        
+        entry[0] = OMEN_HID_KEY_BYTE0;
+        entry[1] = keys[k].r;
+        entry[2] = keys[k].g;
+        entry[3] = keys[k].b;
+    }
+    omen_hid_split(out, buffer);
+}
+
+#ifdef OMEN_HAVE_SSSE3
+__attribute__((target("ssse3")))
+static void omen_hid_encode_keys_ssse3(struct omen_hid_reports *out,
+                                       const struct omen_rgb_zone *keys) {
+    // RGB RGB RGB RGB -> _RGB _RGB _RGB _RGB, byte 0 ORed into the holes
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+                                          -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128i byte0 = _mm_setr_epi8((char)OMEN_HID_KEY_BYTE0, 0, 0, 0,
+                                        (char)OMEN_HID_KEY_BYTE0, 0, 0, 0,
+                                        (char)OMEN_HID_KEY_BYTE0, 0, 0, 0,
+                                        (char)OMEN_HID_KEY_BYTE0, 0, 0, 0);
+    const uint8_t *in = (const uint8_t *)keys;
+    const size_t in_size = OMEN_HID_KEYS * sizeof(*keys);
+    uint8_t buffer[OMEN_HID_BUFFER_SIZE];
+    
+    for (int g = 0; g < OMEN_HID_KEYS / 4; g++) {
+        size_t offset = (size_t)g * 4 * 3;
+        __m128i v;
+        
+        // 16-byte loads overrun the last 4 bytes of the frame - copy those
+        if (offset + 16 <= in_size) {
+            v = _mm_loadu_si128((const __m128i *)(in + offset));
+        } else {
+            uint8_t tail[16] = { 0 };
+            memcpy(tail, in + offset, in_size - offset);
+            v = _mm_loadu_si128((const __m128i *)tail);
+        }
+        
+        v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), byte0);
+        _mm_storeu_si128((__m128i *)&buffer[g * 16], v);
+    }
+    omen_hid_split(out, buffer);
+}
+#endif
+
+void omen_hid_encode_keys(struct omen_hid_reports *out,
+                          const struct omen_rgb_zone *keys) {
+#ifdef OMEN_HAVE_SSSE3
+    static int have_ssse3 = -1;
+    
+    if (have_ssse3 < 0) {
+        have_ssse3 = __builtin_cpu_supports("ssse3");
+    }
+    if (have_ssse3) {
+        omen_hid_encode_keys_ssse3(out, keys);
+        return;
+    }
+#endif
+    omen_hid_encode_keys_scalar(out, keys);
+}
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * OMEN RGB Driver - Userspace ABI for /dev/omen_rgb
+ *
+ * Shared by the kernel module and userspace clients. A frame carries one
+ * RGB triplet per zone and is accepted either as a plain write() of exactly
+ * sizeof(struct omen_rgb_frame) bytes or through OMEN_RGB_IOC_SET_FRAME.
+ *
+ * Query OMEN_RGB_IOC_GET_INFO first: zone_count in a frame must match the
+ * zone count reported for the device.
+ *
+ * For animation, mmap() one page at offset 0 (MAP_SHARED, read/write) to
+ * get a struct omen_rgb_shared. Update it seqcount-style - increment seq to
+ * an odd value, write zones[], increment seq to an even value - then ring
+ * OMEN_RGB_IOC_DOORBELL. The dispatcher reads the page when it next talks
+ * to the firmware, so several updates between doorbells cost one call.
+ * A page left mid-update (seq odd) is retried with backoff for 255
+ * scheduler ticks, then the doorbell is dropped until the next one rings.
+ *
+ * OMEN_RGB_IOC_SET_EFFECT hands an animation to the driver, which renders
+ * it on a kernel timer no faster than the firmware's command rate. Any
+ * frame, doorbell or /proc write stops a running effect; so does an effect
+ * of type OMEN_RGB_EFFECT_NONE.
+ *
+ * OMEN_RGB_IOC_COMMIT_FRAME takes the same frame as SET_FRAME but returns
+ * only after the firmware call carrying it: 0 once every zone is applied
+ * in that single evaluation, a negative error if the call failed and
+ * -ECANCELED if a newer frame replaced it before it was sent.
+ *
+ * Chassis with lightbars or LED strips expose more segments than zones
+ * (info.segment_count, 0 on drivers without segment support). A zone frame
+ * lights each segment with the color of the zone it belongs to;
+ * OMEN_RGB_IOC_SET_SEGMENTS sets every segment on its own, still in one
+ * firmware call.
+ */
+
+#ifndef OMEN_RGB_IOCTL_H
+#define OMEN_RGB_IOCTL_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define OMEN_RGB_ABI_VERSION 1
+#define OMEN_RGB_MAX_ZONES 4
+#define OMEN_RGB_MAX_SEGMENTS 40                    // RGB triplets in one SECU payload
+
+// Device info flags
+#define OMEN_RGB_INFO_DESKTOP 0x01
+
+struct omen_rgb_zone {
+    __u8 r, g, b;
+};
+
+struct omen_rgb_frame {
+    __u32 version;                                  // OMEN_RGB_ABI_VERSION
+    __u32 zone_count;                               // Must equal info.zone_count
+    struct omen_rgb_zone zones[OMEN_RGB_MAX_ZONES]; // Unused entries ignored
+};
+
+struct omen_rgb_info {
+    __u32 version;                                  // ABI version of the driver
+    __u32 zone_count;                               // Zones on this device
+    __u32 flags;                                    // OMEN_RGB_INFO_*
+    __u32 segment_count;                            // Addressable segments
+};
+
+struct omen_rgb_segments {
+    __u32 version;                                  // OMEN_RGB_ABI_VERSION
+    __u32 segment_count;                            // Must equal info.segment_count
+    struct omen_rgb_zone segments[OMEN_RGB_MAX_SEGMENTS]; // Unused entries ignored
+};
+
+// Shared frame page - kernel fills version/zone_count/committed_seq
+struct omen_rgb_shared {
+    __u32 version;                                  // OMEN_RGB_ABI_VERSION
+    __u32 zone_count;                               // Zones on this device
+    __u32 seq;                                      // Odd while userspace writes
+    __u32 committed_seq;                            // Last seq sent to firmware
+    struct omen_rgb_zone zones[OMEN_RGB_MAX_ZONES];
+};
+
+// Effect types
+#define OMEN_RGB_EFFECT_NONE      0
+#define OMEN_RGB_EFFECT_BREATHING 1     // Fade colors[] in and out, one per period
+#define OMEN_RGB_EFFECT_CYCLE     2     // Blend through colors[] once per period
+#define OMEN_RGB_EFFECT_WAVE      3     // Cycle, spread across zones
+
+#define OMEN_RGB_MAX_EFFECT_COLORS 4
+#define OMEN_RGB_EFFECT_MIN_PERIOD_MS 100
+#define OMEN_RGB_EFFECT_MAX_PERIOD_MS 600000
+
+struct omen_rgb_effect {
+    __u32 version;                                  // OMEN_RGB_ABI_VERSION
+    __u32 type;                                     // OMEN_RGB_EFFECT_*
+    __u32 period_ms;                                // Length of one cycle
+    __u32 color_count;                              // Entries used in colors[]
+    struct omen_rgb_zone colors[OMEN_RGB_MAX_EFFECT_COLORS];
+    __u16 phase[OMEN_RGB_MAX_ZONES];                // Per-zone offset, 1/65536 period
+};
+
+#define OMEN_RGB_IOC_MAGIC 'O'
+#define OMEN_RGB_IOC_SET_FRAME _IOW(OMEN_RGB_IOC_MAGIC, 0x01, struct omen_rgb_frame)
+#define OMEN_RGB_IOC_GET_INFO  _IOR(OMEN_RGB_IOC_MAGIC, 0x02, struct omen_rgb_info)
+#define OMEN_RGB_IOC_DOORBELL  _IO(OMEN_RGB_IOC_MAGIC, 0x03)
+#define OMEN_RGB_IOC_SET_EFFECT _IOW(OMEN_RGB_IOC_MAGIC, 0x04, struct omen_rgb_effect)
+#define OMEN_RGB_IOC_COMMIT_FRAME _IOW(OMEN_RGB_IOC_MAGIC, 0x05, struct omen_rgb_frame)
+#define OMEN_RGB_IOC_SET_SEGMENTS _IOW(OMEN_RGB_IOC_MAGIC, 0x06, struct omen_rgb_segments)
+
+#endif /* OMEN_RGB_IOCTL_H */
@@ -0,0 +1,410 @@
+/*
+ * OMEN RGB Driver - KUnit tests
+ *
+ * Runs the dispatcher on the mock backend with no latency, so the numbers
+ * are the driver's own cost: SECU buffer patching, the token bucket, device
+ * references and the request queue under concurrent writers. Each case also
+ * checks the behavior it times.
+ *
+ * The driver source is built into this module, which keeps its helpers
+ * static; the module has no platform driver and never touches firmware.
+ *
+ *   sudo make kunit
+ *   cat /sys/kernel/debug/kunit/omen_rgb/results
+ */
+
+#define OMEN_RGB_KUNIT
+#define NOTRACE                          // Tracepoints stay with the driver module
+
+#include <kunit/test.h>
+
+#include "omen_kernel_mainline_final.c"
+
+#define OMEN_KUNIT_LOOPS 10000
+#define OMEN_KUNIT_WRITERS 4
+#define OMEN_KUNIT_REQUESTS 1000
+
+// Distinct frame per seed - up to 64k seeds
+static void omen_kunit_frame(struct omen_frame *frame, u32 seed)
+{
+    int i;
+    
+    memset(frame, 0, sizeof(*frame));
+    for (i = 0; i < MAX_ZONES; i++) {
+        frame->zones[i].r = seed & 0xff;
+        frame->zones[i].g = (seed >> 8) & 0xff;
+        frame->zones[i].b = i;
+    }
+}
+
+// Let the dispatcher finish everything queued so far
+static void omen_kunit_drain(struct omen_device *dev)
+{
+    do {
+        flush_delayed_work(&dev->cmd_work);
+    } while (READ_ONCE(dev->pending_valid));
+}
+
+// Wait for the dispatcher to take the pending request
+static bool omen_kunit_wait_taken(struct omen_device *dev)
+{
+    int i;
+    
+    for (i = 0; i < 1000; i++) {
+        if (!READ_ONCE(dev->pending_valid))
+            return true;
+        msleep(1);
+    }
+    
+    return false;
+}
+
+// A mock device set up like omen_probe() does, minus proc, debugfs and /dev
+static int omen_kunit_init(struct kunit *test)
+{
+    struct omen_device *dev;
+    int ret;
+    
+    // Module parameters of this module, not of the loaded driver
+    mock_latency_us = 0;
+    mock_jitter_us = 0;
+    mock_fail_pct = 0;
+    mock_zones = MAX_ZONES;
+    max_command_rate = RATE_LIMIT_MAX;
+    burst_size = RATE_LIMIT_MAX;
+    suppress_redundant = true;
+    
+    dev = kzalloc(sizeof(*dev), GFP_KERNEL);
+    if (!dev)
+        return -ENOMEM;
+    
+    omen_device_init(dev);
+    dev->backend = &omen_mock_backend;
+    ret = dev->backend->detect(dev);
+    if (!ret) {
+        omen_init_segment_map(dev);
+        ret = init_acpi_command(dev);
+    }
+    if (!ret) {
+        dev->cmd_wq = alloc_ordered_workqueue("omen_rgb_kunit", 0);
+        if (!dev->cmd_wq) {
+            free_acpi_command(dev);
+            ret = -ENOMEM;
+        }
+    }
+    if (ret) {
+        kfree(dev);
+        return ret;
+    }
+    
+    atomic_set(&dev->state, DEVICE_STATE_READY);
+    test->priv = dev;
+    return 0;
+}
+
+static void omen_kunit_exit(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    
+    if (!dev)
+        return;
+    
+    spin_lock(&global_dev_lock);
+    RCU_INIT_POINTER(global_omen_dev, NULL);
+    spin_unlock(&global_dev_lock);
+    synchronize_rcu();
+    
+    // Same order as omen_remove()
+    atomic_set(&dev->state, DEVICE_STATE_SHUTTING_DOWN);
+    spin_lock_bh(&dev->pending_lock);
+    dev->pending_valid = false;
+    spin_unlock_bh(&dev->pending_lock);
+    cancel_delayed_work_sync(&dev->cmd_work);
+    destroy_workqueue(dev->cmd_wq);
+    timer_delete_sync(&dev->limiter.refill_timer);
+    
+    free_acpi_command(dev);
+    kfree(dev);
+}
+
+static void omen_kunit_prepare_command(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct omen_frame frames[2];
+    u64 changed_ns, same_ns;
+    int i, ret = 0;
+    
+    omen_kunit_frame(&frames[0], 0x0102);
+    omen_kunit_frame(&frames[1], 0xa0b0);
+    
+    mutex_lock(&dev->acpi_lock);
+    
+    // Every segment differs from the previous call
+    changed_ns = ktime_get_ns();
+    for (i = 0; i < OMEN_KUNIT_LOOPS; i++)
+        ret |= prepare_acpi_command(dev, &frames[i & 1], dev->cmd);
+    changed_ns = ktime_get_ns() - changed_ns;
+    
+    // Nothing to patch
+    same_ns = ktime_get_ns();
+    for (i = 0; i < OMEN_KUNIT_LOOPS; i++)
+        ret |= prepare_acpi_command(dev, &frames[1], dev->cmd);
+    same_ns = ktime_get_ns() - same_ns;
+    
+    mutex_unlock(&dev->acpi_lock);
+    
+    KUNIT_EXPECT_EQ(test, ret, 0);
+    KUNIT_EXPECT_EQ(test, memcmp(dev->cmd->magic, "SECU", 4), 0);
+    for (i = 0; i < dev->segment_count; i++) {
+        const struct omen_rgb_zone *color = &frames[1].zones[dev->segment_zone[i]];
+        
+        KUNIT_EXPECT_EQ(test, dev->cmd->rgb_data[i * 3], color->r);
+        KUNIT_EXPECT_EQ(test, dev->cmd->rgb_data[i * 3 + 1], color->g);
+        KUNIT_EXPECT_EQ(test, dev->cmd->rgb_data[i * 3 + 2], color->b);
+    }
+    
+    kunit_info(test, "prepare_acpi_command: %llu ns/call changed, %llu ns/call unchanged\n",
+               div_u64(changed_ns, OMEN_KUNIT_LOOPS), div_u64(same_ns, OMEN_KUNIT_LOOPS));
+}
+
+// Start the bucket full, as probe does
+static void omen_kunit_fill_bucket(struct rate_limiter *limiter)
+{
+    spin_lock(&limiter->lock);
+    limiter->tokens = rate_limit_cap();
+    limiter->last_refill_ns = ktime_get_ns();
+    spin_unlock(&limiter->lock);
+}
+
+// Pretend ns more time has passed since the last refill
+static void omen_kunit_age_bucket(struct rate_limiter *limiter, u64 ns)
+{
+    spin_lock(&limiter->lock);
+    limiter->last_refill_ns -= ns;
+    spin_unlock(&limiter->lock);
+}
+
+static void omen_kunit_rate_limit(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct rate_limiter *limiter = &dev->limiter;
+    struct omen_frame frame;
+    u64 ns, allowed = 0, most;
+    int i;
+    
+    omen_kunit_frame(&frame, 1);
+    max_command_rate = 3;
+    burst_size = 3;
+    
+    // A full bucket grants burst_size calls back to back, then defers
+    omen_kunit_fill_bucket(limiter);
+    for (i = 0; i < 3; i++)
+        KUNIT_EXPECT_TRUE(test, check_rate_limit(dev, &frame));
+    KUNIT_EXPECT_FALSE(test, check_rate_limit(dev, &frame));
+    KUNIT_EXPECT_EQ(test, atomic64_read(&limiter->deferred), 1);
+    
+    // A third of a second at 3/s earns exactly one call
+    omen_kunit_age_bucket(limiter, NSEC_PER_SEC / 3 + NSEC_PER_MSEC);
+    KUNIT_EXPECT_TRUE(test, check_rate_limit(dev, &frame));
+    KUNIT_EXPECT_FALSE(test, check_rate_limit(dev, &frame));
+    
+    // A long idle period fills the bucket no further than burst_size
+    omen_kunit_age_bucket(limiter, 10 * NSEC_PER_SEC);
+    for (i = 0; i < 3; i++)
+        KUNIT_EXPECT_TRUE(test, check_rate_limit(dev, &frame));
+    KUNIT_EXPECT_FALSE(test, check_rate_limit(dev, &frame));
+    
+    // Hot path - mostly deferrals once the burst is spent
+    max_command_rate = RATE_LIMIT_MAX;
+    burst_size = RATE_LIMIT_MAX;
+    omen_kunit_fill_bucket(limiter);
+    ns = ktime_get_ns();
+    for (i = 0; i < OMEN_KUNIT_LOOPS; i++)
+        allowed += check_rate_limit(dev, &frame);
+    ns = ktime_get_ns() - ns;
+    
+    // The burst, plus whatever the rate earned while the loop ran
+    most = RATE_LIMIT_MAX + div64_u64(ns * RATE_LIMIT_MAX, NSEC_PER_SEC) + 1;
+    KUNIT_EXPECT_GE(test, allowed, (u64)RATE_LIMIT_MAX);
+    KUNIT_EXPECT_LE(test, allowed, most);
+    
+    kunit_info(test, "check_rate_limit: %llu ns/call, %llu of %d allowed\n",
+               div_u64(ns, OMEN_KUNIT_LOOPS), allowed, OMEN_KUNIT_LOOPS);
+}
+
+static void omen_kunit_device_ref(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct omen_device *ref;
+    int i, misses = 0;
+    u64 ns;
+    
+    spin_lock(&global_dev_lock);
+    rcu_assign_pointer(global_omen_dev, dev);
+    spin_unlock(&global_dev_lock);
+    
+    ns = ktime_get_ns();
+    for (i = 0; i < OMEN_KUNIT_LOOPS; i++) {
+        ref = get_device_safe();
+        if (ref != dev)
+            misses++;
+        put_device_safe(ref);
+    }
+    ns = ktime_get_ns() - ns;
+    
+    KUNIT_EXPECT_EQ(test, misses, 0);
+    KUNIT_EXPECT_EQ(test, kref_read(&dev->kref), 1U);
+    
+    // A device on its way out hands out no references
+    atomic_set(&dev->state, DEVICE_STATE_SHUTTING_DOWN);
+    KUNIT_EXPECT_NULL(test, get_device_safe());
+    atomic_set(&dev->state, DEVICE_STATE_READY);
+    KUNIT_EXPECT_EQ(test, kref_read(&dev->kref), 1U);
+    
+    kunit_info(test, "get_device_safe + put_device_safe: %llu ns/pair\n",
+               div_u64(ns, OMEN_KUNIT_LOOPS));
+}
+
+static void omen_kunit_coalesce(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct omen_frame frames[4];
+    u64 tickets[4];
+    int i, ret;
+    
+    for (i = 0; i < 4; i++)
+        omen_kunit_frame(&frames[i], i + 1);
+    
+    // Hold the firmware lock so the dispatcher stalls on the first request
+    mutex_lock(&dev->acpi_lock);
+    KUNIT_EXPECT_EQ(test, omen_queue_request(dev, &frames[0], &tickets[0]), 0);
+    if (!omen_kunit_wait_taken(dev)) {
+        mutex_unlock(&dev->acpi_lock);
+        KUNIT_FAIL(test, "Dispatcher never took the first request");
+        return;
+    }
+    for (i = 1; i < 4; i++)
+        KUNIT_EXPECT_EQ(test, omen_queue_request(dev, &frames[i], &tickets[i]), 0);
+    mutex_unlock(&dev->acpi_lock);
+    omen_kunit_drain(dev);
+    
+    // Only the request in flight and the newest one reach the firmware
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->coalesced_count), 2);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->command_count), 2);
+    KUNIT_EXPECT_EQ(test, memcmp(dev->committed.zones, frames[3].zones,
+                                 sizeof(frames[3].zones)), 0);
+    
+    KUNIT_EXPECT_TRUE(test, omen_ticket_done(dev, tickets[3], &ret));
+    KUNIT_EXPECT_EQ(test, ret, 0);
+    KUNIT_EXPECT_TRUE(test, omen_ticket_done(dev, tickets[1], &ret));
+    KUNIT_EXPECT_EQ(test, ret, -ECANCELED);
+}
+
+static void omen_kunit_cache_hit(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct omen_frame frame;
+    
+    omen_kunit_frame(&frame, 7);
+    KUNIT_EXPECT_EQ(test, omen_queue_request(dev, &frame, NULL), 0);
+    omen_kunit_drain(dev);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->command_count), 1);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->cache_misses), 1);
+    
+    // The hardware already shows it - no firmware call, no token
+    KUNIT_EXPECT_EQ(test, omen_queue_request(dev, &frame, NULL), 0);
+    omen_kunit_drain(dev);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->command_count), 1);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->cache_hits), 1);
+    
+    // suppress_redundant=0 sends it anyway
+    suppress_redundant = false;
+    KUNIT_EXPECT_EQ(test, omen_queue_request(dev, &frame, NULL), 0);
+    omen_kunit_drain(dev);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->command_count), 2);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->cache_hits), 1);
+}
+
+struct omen_kunit_writer {
+    struct work_struct work;
+    struct omen_device *dev;
+    int id;
+    int errors;
+    u64 ns;
+};
+
+static void omen_kunit_writer_work(struct work_struct *work)
+{
+    struct omen_kunit_writer *w = container_of(work, struct omen_kunit_writer, work);
+    struct omen_frame frame;
+    u64 start = ktime_get_ns();
+    int i;
+    
+    for (i = 0; i < OMEN_KUNIT_REQUESTS; i++) {
+        omen_kunit_frame(&frame, w->id * OMEN_KUNIT_REQUESTS + i);
+        if (omen_queue_request(w->dev, &frame, NULL))
+            w->errors++;
+    }
+    w->ns = ktime_get_ns() - start;
+}
+
+static void omen_kunit_concurrent_queue(struct kunit *test)
+{
+    struct omen_device *dev = test->priv;
+    struct omen_kunit_writer *writers;
+    u64 total = OMEN_KUNIT_WRITERS * OMEN_KUNIT_REQUESTS;
+    u64 ns = 0, coalesced, commands, hits;
+    int i;
+    
+    writers = kunit_kcalloc(test, OMEN_KUNIT_WRITERS, sizeof(*writers), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, writers);
+    
+    for (i = 0; i < OMEN_KUNIT_WRITERS; i++) {
+        writers[i].dev = dev;
+        writers[i].id = i;
+        INIT_WORK(&writers[i].work, omen_kunit_writer_work);
+        queue_work(system_unbound_wq, &writers[i].work);
+    }
+    for (i = 0; i < OMEN_KUNIT_WRITERS; i++) {
+        flush_work(&writers[i].work);
+        KUNIT_EXPECT_EQ(test, writers[i].errors, 0);
+        ns += writers[i].ns;
+    }
+    omen_kunit_drain(dev);
+    
+    coalesced = atomic64_read(&dev->coalesced_count);
+    commands = atomic64_read(&dev->command_count);
+    hits = atomic64_read(&dev->cache_hits);
+    
+    // Every request was either replaced by a newer one or dispatched, and
+    // the dispatcher finished on the newest
+    KUNIT_EXPECT_EQ(test, dev->next_ticket, total);
+    KUNIT_EXPECT_EQ(test, coalesced + commands + hits, total);
+    KUNIT_EXPECT_GT(test, coalesced, 0ULL);
+    KUNIT_EXPECT_EQ(test, dev->done_ticket, total);
+    KUNIT_EXPECT_EQ(test, atomic64_read(&dev->error_count), 0);
+    
+    kunit_info(test, "omen_queue_request: %llu ns/call over %d writers, %llu firmware calls, %llu coalesced\n",
+               div64_u64(ns, total), OMEN_KUNIT_WRITERS, commands, coalesced);
+}
+
+static struct kunit_case omen_rgb_kunit_cases[] = {
+    KUNIT_CASE(omen_kunit_prepare_command),
+    KUNIT_CASE(omen_kunit_rate_limit),
+    KUNIT_CASE(omen_kunit_device_ref),
+    KUNIT_CASE(omen_kunit_coalesce),
+    KUNIT_CASE(omen_kunit_cache_hit),
+    KUNIT_CASE(omen_kunit_concurrent_queue),
+    {}
+};
+
+static struct kunit_suite omen_rgb_kunit_suite = {
+    .name = "omen_rgb",
+    .init = omen_kunit_init,
+    .exit = omen_kunit_exit,
+    .test_cases = omen_rgb_kunit_cases,
+};
+kunit_test_suite(omen_rgb_kunit_suite);
+
+MODULE_DESCRIPTION("OMEN RGB driver KUnit tests - mock backend");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,512 @@
+/*
+ * OMEN RGB Userspace Library - encoder and transports
+ *
+ * See omen_rgb_lib.h for the API.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#define _DEFAULT_SOURCE          // usleep
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <sys/io.h>
+#define OMEN_HAVE_PORT_IO 1
+#endif
+
+#include "omen_rgb_lib.h"
+#include "omen_acpi_sig.h"
+
+// EC ports and handshake (ACPI spec, EC write command 0x81)
+#define EC_DATA_PORT    0x62
+#define EC_CMD_PORT     0x66
+#define EC_IBF          0x02
+#define EC_CMD_WRITE    0x81
+#define EC_TIMEOUT_MS   1000
+#define EC_RAM_SIZE     256
+
+/*
+ * Encoder
+ */
+
+int omen_layout_zones(enum omen_layout layout) {
+    return layout == OMEN_LAYOUT_DESKTOP ? OMEN_RGB_MAX_ZONES : 1;
+}
+
+void omen_encode_init(struct omen_secu_command *cmd, enum omen_layout layout) {
+    memset(cmd, 0, sizeof(*cmd));
+    
+    memcpy(cmd->magic, OMEN_SECU_MAGIC, 4);
+    cmd->command_id = OMEN_SECU_COMMAND_ID;
+    cmd->flags = OMEN_SECU_FLAGS;
+    
+    if (layout == OMEN_LAYOUT_DESKTOP) {
+        cmd->sub_command = 0x0B;
+        cmd->extended_flags = 0x40000000;
+        cmd->additional_flags = 0x40000;
+    } else {
+        cmd->sub_command = 0x07;
+        cmd->extended_flags = 0x1000000;
+        cmd->additional_flags = 0x00;
+    }
+}
+
+/*
+ * Write the zone triplets into an initialized command. Returns the number
+ * of triplets that changed, so callers reusing one command can skip the
+ * hardware when nothing did.
+ */
+int omen_encode_frame(struct omen_secu_command *cmd, enum omen_layout layout,
+                      const struct omen_rgb_zone *zones, int zone_count) {
+    int zones_used = omen_layout_zones(layout);
+    int dirty = 0;
+    
+    if (!cmd || !zones || zone_count != zones_used) {
+        return -EINVAL;
+    }
+    
+    for (int i = 0; i < zones_used; i++) {
+        uint8_t *rgb = &cmd->rgb_data[i * 3];
+        
+        if (rgb[0] == zones[i].r && rgb[1] == zones[i].g && rgb[2] == zones[i].b) {
+            continue;
+        }
+        
+        rgb[0] = zones[i].r;
+        rgb[1] = zones[i].g;
+        rgb[2] = zones[i].b;
+        dirty++;
+    }
+    
+    return dirty;
+}
+
+/*
+ * acpi_call transport - "<method> b<hex>" written to /proc/acpi/call
+ *
+ * param is the buffer size: the command, zero padded to what the board's
+ * signature (omen_acpi_sig.h) says the method indexes.
+ *
+ * The file stays open: acpi_call evaluates the method inside write() and
+ * keeps the result until it is read, so a submit is one write() and one
+ * pread() at offset 0.
+ */
+
+static int read_board_name(char *board, size_t size) {
+    FILE *fp = fopen("/sys/class/dmi/id/board_name", "r");
+    
+    if (!fp) {
+        return -errno;
+    }
+    if (!fgets(board, (int)size, fp)) {
+        fclose(fp);
+        return -EIO;
+    }
+    fclose(fp);
+    board[strcspn(board, "\n")] = 0;
+    return 0;
+}
+
+static int acpi_call_open(struct omen_transport *t, const char *target) {
+    const struct omen_acpi_sig *sig;
+    char board[64];
+    
+    snprintf(t->target, sizeof(t->target), "%s",
+             target && *target ? target : "\\_SB.WMID.SECU");
+    t->param = sizeof(t->cmd);
+    
+    // Calls the board's firmware cannot take fail on every attempt - refuse them here
+    if (read_board_name(board, sizeof(board)) == 0) {
+        sig = omen_acpi_sig_find(board, t->target);
+        if (!sig && omen_acpi_sig_board_known(board)) {
+            return -ENOENT;
+        }
+        if (sig && (sig->args != 1 || sig->buffer_size > OMEN_ACPI_SIG_MAX_BUFFER ||
+                    (sig->buffer_arg != 0 && sig->buffer_arg != OMEN_ACPI_SIG_NO_BUFFER))) {
+            return -EINVAL;
+        }
+        if (sig && sig->buffer_size > t->param) {
+            t->param = sig->buffer_size;
+        }
+    }
+    
+    t->fd = open("/proc/acpi/call", O_RDWR | O_CLOEXEC);
+    return t->fd < 0 ? -errno : 0;
+}
+
+static int acpi_call_submit(struct omen_transport *t,
+                            const struct omen_rgb_zone *zones, int zone_count) {
+    static const char hex[] = "0123456789abcdef";
+    const uint8_t *bytes = (const uint8_t *)&t->cmd;
+    char line[sizeof(t->target) + 2 + OMEN_ACPI_SIG_MAX_BUFFER * 2 + 2];
+    char response[256];
+    size_t len;
+    ssize_t n;
+    
+    (void)zones;
+    (void)zone_count;
+    
+    len = (size_t)snprintf(line, sizeof(line), "%s b", t->target);
+    for (size_t i = 0; i < sizeof(t->cmd); i++) {
+        line[len++] = hex[bytes[i] >> 4];
+        line[len++] = hex[bytes[i] & 0x0F];
+    }
+    memset(line + len, '0', (t->param - sizeof(t->cmd)) * 2);
+    len += (t->param - sizeof(t->cmd)) * 2;
+    line[len++] = '\n';
+    
+    n = write(t->fd, line, len);
+    if (n != (ssize_t)len) {
+        return n < 0 ? -errno : -EIO;
+    }
+    
+    // acpi_call reports AML errors in the response, not the write
+    n = pread(t->fd, response, sizeof(response) - 1, 0);
+    if (n < 0) {
+        return -errno;
+    }
+    response[n] = 0;
+    
+    return strncmp(response, "Error", 5) == 0 ? -EIO : 0;
+}
+
+static void acpi_call_close(struct omen_transport *t) {
+    if (t->fd >= 0) {
+        close(t->fd);
+    }
+}
+
+static const struct omen_transport_ops acpi_call_ops = {
+    .name = "acpi_call",
+    .open = acpi_call_open,
+    .submit = acpi_call_submit,
+    .close = acpi_call_close,
+};
+
+/*
+ * EC transport - zone triplets written to EC RAM from the base address on
+ */
+
+#ifdef OMEN_HAVE_PORT_IO
+static int ec_wait_ibf_clear(void) {
+    struct timespec start, now;
+    long elapsed_ms;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (inb(EC_CMD_PORT) & EC_IBF) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+                     (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed_ms > EC_TIMEOUT_MS) {
+            return -ETIMEDOUT;
+        }
+        usleep(1000);
+    }
+    return 0;
+}
+
+static int ec_write_byte(uint8_t addr, uint8_t value) {
+    if (ec_wait_ibf_clear()) return -ETIMEDOUT;
+    outb(EC_CMD_WRITE, EC_CMD_PORT);
+    if (ec_wait_ibf_clear()) return -ETIMEDOUT;
+    outb(addr, EC_DATA_PORT);
+    if (ec_wait_ibf_clear()) return -ETIMEDOUT;
+    outb(value, EC_DATA_PORT);
+    return 0;
+}
+#endif
+
+static int ec_open(struct omen_transport *t, const char *target) {
+#ifdef OMEN_HAVE_PORT_IO
+    char *end;
+    
+    // No default - writing the wrong EC RAM offset can upset the firmware
+    if (!target || !*target) {
+        return -EINVAL;
+    }
+    t->param = strtoul(target, &end, 0);
+    if (*end || t->param + omen_layout_zones(t->layout) * 3 > EC_RAM_SIZE) {
+        return -EINVAL;
+    }
+    
+    if (ioperm(EC_DATA_PORT, 1, 1) != 0) {
+        return -errno;
+    }
+    if (ioperm(EC_CMD_PORT, 1, 1) != 0) {
+        int err = -errno;
+        ioperm(EC_DATA_PORT, 1, 0);
+        return err;
+    }
+    return 0;
+#else
+    (void)t;
+    (void)target;
+    return -EOPNOTSUPP;
+#endif
+}
+
+static int ec_submit(struct omen_transport *t,
+                     const struct omen_rgb_zone *zones, int zone_count) {
+#ifdef OMEN_HAVE_PORT_IO
+    uint8_t addr = (uint8_t)t->param;
+    int ret;
+    
+    for (int i = 0; i < zone_count; i++) {
+        if ((ret = ec_write_byte(addr++, zones[i].r)) ||
+            (ret = ec_write_byte(addr++, zones[i].g)) ||
+            (ret = ec_write_byte(addr++, zones[i].b))) {
+            return ret;
+        }
+    }
+    return 0;
+#else
+    (void)t;
+    (void)zones;
+    (void)zone_count;
+    return -EOPNOTSUPP;
+#endif
+}
+
+static void ec_close(struct omen_transport *t) {
+    (void)t;
+#ifdef OMEN_HAVE_PORT_IO
+    ioperm(EC_DATA_PORT, 1, 0);
+    ioperm(EC_CMD_PORT, 1, 0);
+#endif
+}
+
+static const struct omen_transport_ops ec_ops = {
+    .name = "ec",
+    .open = ec_open,
+    .submit = ec_submit,
+    .close = ec_close,
+};
+
+/*
+ * hidraw transport - OMEN_HID_REPORTS feature reports per per-key frame
+ *
+ * Zone frames are refused with -EOPNOTSUPP: only the report header (ID 0x02,
+ * command 0x01) is in the protocol notes, and no capture shows the zone
+ * report body. A guessed report is not sent to a live keyboard controller.
+ */
+
+static int hidraw_open(struct omen_transport *t, const char *target) {
+    if (!target || !*target) {
+        return -EINVAL;
+    }
+    snprintf(t->target, sizeof(t->target), "%s", target);
+    
+    t->fd = open(target, O_RDWR | O_CLOEXEC);
+    return t->fd < 0 ? -errno : 0;
+}
+
+static int hidraw_submit(struct omen_transport *t,
+                         const struct omen_rgb_zone *zones, int zone_count) {
+    (void)t;
+    (void)zones;
+    (void)zone_count;
+    return -EOPNOTSUPP;
+}
+
+static int hidraw_send_report(struct omen_transport *t, const uint8_t *report) {
+    if (ioctl(t->fd, HIDIOCSFEATURE(OMEN_HID_REPORT_SIZE), report) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+static void hidraw_close(struct omen_transport *t) {
+    close(t->fd);
+}
+
+static const struct omen_transport_ops hidraw_ops = {
+    .name = "hidraw",
+    .open = hidraw_open,
+    .submit = hidraw_submit,
+    .close = hidraw_close,
+    .send_report = hidraw_send_report,
+};
+
+/*
+ * Mock transport - optional fixed latency, no hardware
+ */
+
+static int mock_open(struct omen_transport *t, const char *target) {
+    char *end;
+    
+    t->param = 0;
+    if (target && *target) {
+        t->param = strtoul(target, &end, 0);
+        if (*end) {
+            return -EINVAL;
+        }
+    }
+    return 0;
+}
+
+static int mock_submit(struct omen_transport *t,
+                       const struct omen_rgb_zone *zones, int zone_count) {
+    (void)zones;
+    (void)zone_count;
+    
+    if (t->param) {
+        usleep((useconds_t)t->param);
+    }
+    return 0;
+}
+
+// Latency is per report, like a USB control transfer
+static int mock_send_report(struct omen_transport *t, const uint8_t *report) {
+    (void)report;
+    
+    if (t->param) {
+        usleep((useconds_t)t->param);
+    }
+    return 0;
+}
+
+static const struct omen_transport_ops mock_ops = {
+    .name = "mock",
+    .open = mock_open,
+    .submit = mock_submit,
+    .send_report = mock_send_report,
+};
+
+static const struct omen_transport_ops *transports[] = {
+    &acpi_call_ops,
+    &ec_ops,
+    &hidraw_ops,
+    &mock_ops,
+    NULL
+};
+
+/*
+ * Transport front end
+ */
+
+int omen_transport_open(struct omen_transport *t, const char *kind,
+                        const char *target, enum omen_layout layout) {
+    int ret;
+    
+    if (!t || !kind) {
+        return -EINVAL;
+    }
+    
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+    t->layout = layout;
+    t->resync_interval = OMEN_HID_RESYNC_FRAMES;
+    omen_encode_init(&t->cmd, layout);
+    
+    for (int i = 0; transports[i]; i++) {
+        if (strcmp(kind, transports[i]->name) == 0) {
+            t->ops = transports[i];
+            break;
+        }
+    }
+    if (!t->ops) {
+        return -ENOENT;
+    }
+    
+    ret = t->ops->open(t, target);
+    if (ret) {
+        t->ops = NULL;
+    }
+    return ret;
+}
+
+int omen_transport_submit(struct omen_transport *t,
+                          const struct omen_rgb_zone *zones, int zone_count) {
+    int ret;
+    
+    if (!t || !t->ops) {
+        return -EINVAL;
+    }
+    
+    ret = omen_encode_frame(&t->cmd, t->layout, zones, zone_count);
+    if (ret < 0) {
+        return ret;
+    }
+    
+    ret = t->ops->submit(t, zones, zone_count);
+    if (ret == 0) {
+        t->submitted++;
+    }
+    return ret;
+}
+
+/*
+ * Send a per-key frame. Reports identical to the last accepted frame are
+ * skipped; any error or the periodic resync forces a full refresh, so a
+ * device that dropped state is repainted within resync_interval frames.
+ */
+int omen_transport_submit_keys(struct omen_transport *t,
+                               const struct omen_rgb_zone *keys) {
+    struct omen_hid_reports reports;
+    int full, ret;
+    
+    if (!t || !t->ops || !keys) {
+        return -EINVAL;
+    }
+    if (!t->ops->send_report) {
+        return -EOPNOTSUPP;
+    }
+    
+    omen_hid_encode_keys(&reports, keys);
+    
+    full = !t->keys_valid ||
+           (t->resync_interval && ++t->since_resync >= t->resync_interval);
+    if (full) {
+        t->since_resync = 0;
+    }
+    
+    for (int r = 0; r < OMEN_HID_REPORTS; r++) {
+        if (!full && memcmp(reports.report[r], t->keys_sent.report[r],
+                            OMEN_HID_REPORT_SIZE) == 0) {
+            t->reports_skipped++;
+            continue;
+        }
+        
+        ret = t->ops->send_report(t, reports.report[r]);
+        if (ret) {
+            // Unknown which reports landed - repaint everything next time
+            t->keys_valid = 0;
+            return ret;
+        }
+        memcpy(t->keys_sent.report[r], reports.report[r], OMEN_HID_REPORT_SIZE);
+        t->reports_sent++;
+    }
+    
+    t->keys_valid = 1;
+    t->submitted++;
+    return 0;
+}
+
+void omen_transport_set_resync(struct omen_transport *t, unsigned int frames) {
+    if (!t) {
+        return;
+    }
+    
+    t->resync_interval = frames;
+    t->since_resync = 0;
+}
+
+void omen_transport_close(struct omen_transport *t) {
+    if (!t || !t->ops) {
+        return;
+    }
+    
+    if (t->ops->close) {
+        t->ops->close(t);
+    }
+    t->ops = NULL;
+}
@@ -0,0 +1,153 @@
+/*
+ * OMEN RGB Userspace Library
+ *
+ * One encoder for the SECU command used by the kernel driver and one
+ * transport interface for every way the tools reach the hardware:
+ *
+ *   acpi_call - /proc/acpi/call, target is the SECU method path
+ *   ec        - EC RAM writes through ports 0x62/0x66, target is the base address
+ *   hidraw    - HID feature reports, target is the /dev/hidrawN node
+ *               (per-key frames only - zone frames return -EOPNOTSUPP
+ *               until the zone report body is verified)
+ *   mock      - no hardware, target is an optional latency in microseconds
+ *
+ * Per-key frames are only supported by hidraw and mock.
+ *
+ * All functions return 0 (or a positive count) on success and -errno on
+ * failure. Nothing here prints; callers decide how to report errors.
+ *
+ * Author: OMEN Linux Project
+ * License: GPL v3
+ */
+
+#ifndef OMEN_RGB_LIB_H
+#define OMEN_RGB_LIB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "omen_rgb_ioctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SECU command layout - must match struct omen_acpi_command in the driver
+#define OMEN_SECU_MAGIC         "SECU"
+#define OMEN_SECU_COMMAND_ID    0x20009
+#define OMEN_SECU_FLAGS         0x80
+#define OMEN_SECU_RGB_SIZE      120
+
+enum omen_layout {
+    OMEN_LAYOUT_LAPTOP = 0,     // Sub-command 0x07, one zone
+    OMEN_LAYOUT_DESKTOP,        // Sub-command 0x0B, four zones
+};
+
+struct omen_secu_command {
+    char magic[4];              // "SECU"
+    uint32_t command_id;        // 0x20009
+    uint32_t sub_command;       // 0x07 (laptop) / 0x0B (desktop)
+    uint32_t flags;             // 0x80
+    uint32_t extended_flags;    // Device-specific
+    uint32_t additional_flags;  // Desktop specific
+    uint8_t rgb_data[OMEN_SECU_RGB_SIZE];
+} __attribute__((packed));
+
+// Per-key HID buffer - 4 bytes per key, sent as 65-byte feature reports.
+// Every report starts with Report ID 0x02 and Command 0x01 (SetStatic), as
+// in the protocol notes; the 576-byte buffer fills the remaining payload.
+// UNVERIFIED report count: the notes say "8-9 reports", which is 576 / 65
+// and leaves out the header. Two header bytes leave 63 payload bytes, so
+// 576 bytes take 10 reports; 9 would fit only if the command byte were sent
+// once rather than per report. No capture settles which.
+#define OMEN_HID_REPORT_ID      0x02
+#define OMEN_HID_CMD_SET_STATIC 0x01
+#define OMEN_HID_REPORT_SIZE    65
+#define OMEN_HID_HEADER_SIZE    2       // Report ID, command
+#define OMEN_HID_PAYLOAD_SIZE   (OMEN_HID_REPORT_SIZE - OMEN_HID_HEADER_SIZE)
+#define OMEN_HID_KEY_BYTES      4
+// UNVERIFIED: the notes give 4 bytes per key but not their layout. Keys
+// are encoded as {OMEN_HID_KEY_BYTE0, R, G, B}; byte 0 is a placeholder
+// until a capture confirms its meaning.
+#define OMEN_HID_KEY_BYTE0      0x00
+#define OMEN_HID_BUFFER_SIZE    576
+#define OMEN_HID_KEYS           (OMEN_HID_BUFFER_SIZE / OMEN_HID_KEY_BYTES)
+#define OMEN_HID_REPORTS        ((OMEN_HID_BUFFER_SIZE + OMEN_HID_PAYLOAD_SIZE - 1) / \
+                                 OMEN_HID_PAYLOAD_SIZE)
+#define OMEN_HID_RESYNC_FRAMES  300     // Full refresh every ~5 s at 60 fps
+
+struct omen_hid_reports {
+    uint8_t report[OMEN_HID_REPORTS][OMEN_HID_REPORT_SIZE];
+};
+
+// Keyboard layouts for per-key lookups
+enum omen_kb_layout {
+    OMEN_KB_ANSI = 0,
+    OMEN_KB_ISO,
+    OMEN_KB_LAYOUTS
+};
+
+// Encoder
+int omen_layout_zones(enum omen_layout layout);
+void omen_encode_init(struct omen_secu_command *cmd, enum omen_layout layout);
+int omen_encode_frame(struct omen_secu_command *cmd, enum omen_layout layout,
+                      const struct omen_rgb_zone *zones, int zone_count);
+
+// keys holds OMEN_HID_KEYS entries; the scalar path is the reference
+void omen_hid_encode_keys(struct omen_hid_reports *out,
+                          const struct omen_rgb_zone *keys);
+void omen_hid_encode_keys_scalar(struct omen_hid_reports *out,
+                                 const struct omen_rgb_zone *keys);
+
+// Key map - byte offset of a key in the per-key buffer, -ENOENT if the
+// layout has no such key. Names are Aurora DeviceKeys names ("ESC", "W"),
+// scan codes are Linux KEY_* codes. offset / OMEN_HID_KEY_BYTES indexes
+// the keys[] array of omen_hid_encode_keys().
+int omen_key_offset_by_name(enum omen_kb_layout layout, const char *name);
+int omen_key_offset_by_scancode(enum omen_kb_layout layout, unsigned int code);
+
+// Transports
+struct omen_transport;
+
+struct omen_transport_ops {
+    const char *name;
+    int (*open)(struct omen_transport *t, const char *target);
+    int (*submit)(struct omen_transport *t, const struct omen_rgb_zone *zones,
+                  int zone_count);
+    void (*close)(struct omen_transport *t);
+    // Optional - one OMEN_HID_REPORT_SIZE report of a per-key frame
+    int (*send_report)(struct omen_transport *t, const uint8_t *report);
+};
+
+struct omen_transport {
+    const struct omen_transport_ops *ops;
+    enum omen_layout layout;
+    struct omen_secu_command cmd;   // Encoded by omen_transport_submit()
+    int fd;
+    char target[128];
+    unsigned long param;            // Transport specific (EC base, mock latency)
+    uint64_t submitted;
+    
+    // Per-key delta state - only reports that changed since the last frame go out
+    struct omen_hid_reports keys_sent;
+    int keys_valid;                 // keys_sent matches the device
+    unsigned int resync_interval;   // Full refresh every n frames, 0 = never
+    unsigned int since_resync;
+    uint64_t reports_sent;
+    uint64_t reports_skipped;
+};
+
+int omen_transport_open(struct omen_transport *t, const char *kind,
+                        const char *target, enum omen_layout layout);
+int omen_transport_submit(struct omen_transport *t,
+                          const struct omen_rgb_zone *zones, int zone_count);
+int omen_transport_submit_keys(struct omen_transport *t,
+                               const struct omen_rgb_zone *keys);
+void omen_transport_set_resync(struct omen_transport *t, unsigned int frames);
+void omen_transport_close(struct omen_transport *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OMEN_RGB_LIB_H */
@@ -0,0 +1,123 @@
+/*
+ * OMEN RGB Driver - Tracepoints
+ *
+ * Follow a frame from submit to firmware completion:
+ *   perf trace -e 'omen_rgb:*'
+ *   echo 1 > /sys/kernel/tracing/events/omen_rgb/enable
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM omen_rgb
+
+#if !defined(_OMEN_RGB_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _OMEN_RGB_TRACE_H
+
+#include <linux/tracepoint.h>
+#include "omen_rgb_ioctl.h"
+
+#define OMEN_TRACE_RGB_LEN (OMEN_RGB_MAX_ZONES * 3)
+
+// Zones are copied flat so the printk side needs no struct layout
+DECLARE_EVENT_CLASS(omen_rgb_frame_class,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count),
+    TP_ARGS(zones, zone_count),
+    TP_STRUCT__entry(
+        __field(int, zone_count)
+        __array(u8, rgb, OMEN_TRACE_RGB_LEN)
+    ),
+    TP_fast_assign(
+        __entry->zone_count = zone_count;
+        memset(__entry->rgb, 0, OMEN_TRACE_RGB_LEN);
+        if (zones)
+            memcpy(__entry->rgb, zones, zone_count * 3);
+    ),
+    TP_printk("zones=%d rgb=%s", __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+// Request handed to the dispatcher - NULL zones for a doorbell
+DEFINE_EVENT(omen_rgb_frame_class, omen_rgb_submit,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count),
+    TP_ARGS(zones, zone_count)
+);
+
+// Dispatcher steps for a frame - a count, a result code and a time or
+// token value, named per event in its printk
+DECLARE_EVENT_CLASS(omen_rgb_step_class,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count, int count,
+             int result, u64 value),
+    TP_ARGS(zones, zone_count, count, result, value),
+    TP_STRUCT__entry(
+        __field(int, zone_count)
+        __field(int, count)
+        __field(int, result)
+        __field(u64, value)
+        __array(u8, rgb, OMEN_TRACE_RGB_LEN)
+    ),
+    TP_fast_assign(
+        __entry->zone_count = zone_count;
+        __entry->count = count;
+        __entry->result = result;
+        __entry->value = value;
+        memset(__entry->rgb, 0, OMEN_TRACE_RGB_LEN);
+        memcpy(__entry->rgb, zones, zone_count * 3);
+    ),
+    TP_printk("count=%d result=%d value=%llu zones=%d rgb=%s",
+              __entry->count, __entry->result, __entry->value,
+              __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+// Token bucket decision for the frame about to be dispatched -
+// count is 1 if allowed, value the milli-tokens left
+DEFINE_EVENT_PRINT(omen_rgb_step_class, omen_rgb_rate_limit,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count, int count,
+             int result, u64 value),
+    TP_ARGS(zones, zone_count, count, result, value),
+    TP_printk("allowed=%d tokens=%llu zones=%d rgb=%s",
+              __entry->count, __entry->value, __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+// acpi_lock taken for the frame's firmware call - value is the wait
+DEFINE_EVENT_PRINT(omen_rgb_step_class, omen_rgb_acpi_lock,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count, int count,
+             int result, u64 value),
+    TP_ARGS(zones, zone_count, count, result, value),
+    TP_printk("wait_ns=%llu zones=%d rgb=%s", __entry->value,
+              __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+// One acpi_evaluate_object attempt - count is the retry, result the
+// acpi_status
+DEFINE_EVENT_PRINT(omen_rgb_step_class, omen_rgb_acpi_eval,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count, int count,
+             int result, u64 value),
+    TP_ARGS(zones, zone_count, count, result, value),
+    TP_printk("retry=%d status=0x%x duration_ns=%llu zones=%d rgb=%s",
+              __entry->count, (u32)__entry->result, __entry->value,
+              __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+// Firmware command finished, successfully or not - count is the retries,
+// result the return code
+DEFINE_EVENT_PRINT(omen_rgb_step_class, omen_rgb_complete,
+    TP_PROTO(const struct omen_rgb_zone *zones, int zone_count, int count,
+             int result, u64 value),
+    TP_ARGS(zones, zone_count, count, result, value),
+    TP_printk("ret=%d retries=%d duration_ns=%llu zones=%d rgb=%s",
+              __entry->result, __entry->count, __entry->value,
+              __entry->zone_count,
+              __print_hex(__entry->rgb, __entry->zone_count * 3))
+);
+
+#endif /* _OMEN_RGB_TRACE_H */
+
+// Must stay outside the include guard
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE omen_rgb_trace
+#include <trace/define_trace.h>